@@ -0,0 +1,48 @@
+# Converts a compiled SPIR-V binary into a C++ header with the words stored in a constexpr array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DSYMBOL=<array name> -P embed_spirv.cmake
+
+file(READ "${INPUT}" SPIRV_HEX HEX)
+string(LENGTH "${SPIRV_HEX}" SPIRV_HEX_LENGTH)
+
+math(EXPR SPIRV_REMAINDER "${SPIRV_HEX_LENGTH} % 8")
+if(SPIRV_HEX_LENGTH EQUAL 0 OR NOT SPIRV_REMAINDER EQUAL 0)
+	message(FATAL_ERROR "ERROR: ${INPUT} is not a valid SPIR-V binary (size is not a multiple of 4 bytes).")
+endif()
+
+# SPIR-V is little-endian, so every group of 4 bytes is reversed to get the word value
+string(REGEX MATCHALL "........" SPIRV_BYTES "${SPIRV_HEX}")
+
+set(SPIRV_WORDS "")
+set(WORDS_IN_LINE 0)
+foreach(WORD ${SPIRV_BYTES})
+	string(SUBSTRING "${WORD}" 0 2 B0)
+	string(SUBSTRING "${WORD}" 2 2 B1)
+	string(SUBSTRING "${WORD}" 4 2 B2)
+	string(SUBSTRING "${WORD}" 6 2 B3)
+	string(APPEND SPIRV_WORDS "0x${B3}${B2}${B1}${B0},")
+
+	math(EXPR WORDS_IN_LINE "${WORDS_IN_LINE} + 1")
+	if(WORDS_IN_LINE EQUAL 8)
+		string(APPEND SPIRV_WORDS "\n\t")
+		set(WORDS_IN_LINE 0)
+	else()
+		string(APPEND SPIRV_WORDS " ")
+	endif()
+endforeach()
+
+get_filename_component(INPUT_NAME "${INPUT}" NAME)
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated from ${INPUT_NAME} by CMake/embed_spirv.cmake - do not edit.
+#pragma once
+
+#include <cstdint>
+
+inline constexpr uint32_t ${SYMBOL}[] = {
+	${SPIRV_WORDS}
+};
+")
+
+# Only touch the header when the contents change, so dependent sources are not rebuilt needlessly
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
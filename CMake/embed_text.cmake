@@ -0,0 +1,24 @@
+# Converts a text file (shader source) into a C++ header with a null-terminated constexpr byte array.
+# A byte array is used instead of a string literal because MSVC limits the length of string literals.
+# Usage: cmake -DINPUT=<file> -DOUTPUT=<file.h> -DSYMBOL=<array name> -P embed_text.cmake
+
+file(READ "${INPUT}" TEXT_HEX HEX)
+
+# 32 bytes per line, then every byte becomes a hex literal
+string(REGEX REPLACE "(................................................................)" "\\1\n\t" TEXT_HEX "${TEXT_HEX}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " TEXT_BYTES "${TEXT_HEX}")
+
+get_filename_component(INPUT_NAME "${INPUT}" NAME)
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated from ${INPUT_NAME} by CMake/embed_text.cmake - do not edit.
+#pragma once
+
+inline constexpr unsigned char ${SYMBOL}[] = {
+	${TEXT_BYTES}0x00
+};
+")
+
+# Only touch the header when the contents change, so dependent sources are not rebuilt needlessly
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
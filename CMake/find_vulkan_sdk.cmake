@@ -20,6 +20,14 @@ else()
 	
 endif()
 
+# Shader compilers and the SPIR-V optimizer shipped with the SDK
+find_program(GLSLANG_VALIDATOR NAMES "glslangValidator" PATHS "$ENV{VULKAN_SDK}/Bin" "$ENV{VULKAN_SDK}/bin")
+find_program(GLSLC NAMES "glslc" PATHS "$ENV{VULKAN_SDK}/Bin" "$ENV{VULKAN_SDK}/bin")
+find_program(SPIRV_OPT NAMES "spirv-opt" PATHS "$ENV{VULKAN_SDK}/Bin" "$ENV{VULKAN_SDK}/bin")
+
+# Optional - shaderc library for compiling shader variants at runtime
+find_library(SHADERC_LIBRARY NAMES "shaderc_combined" "shaderc_shared" PATHS "$ENV{VULKAN_SDK}/Lib" "$ENV{VULKAN_SDK}/lib")
+
 
 # Set variables
 if (NOT("${Vulkan_INCLUDE}" STREQUAL "Vulkan_INCLUDE-NOTFOUND"))
@@ -34,6 +42,12 @@ else()
 	set(Vulkan_LIBRARY_FOUND FALSE)
 endif()
 
+if (NOT("${SHADERC_LIBRARY}" STREQUAL "SHADERC_LIBRARY-NOTFOUND"))
+	set(SHADERC_FOUND TRUE)
+else()
+	set(SHADERC_FOUND FALSE)
+endif()
+
 if((NOT("${SDL_LIBRARY}" STREQUAL "SDL_LIBRARY-NOTFOUND")) AND (NOT("${SDL_LIBRARY_MAIN}" STREQUAL "SDL_MAIN_LIBRARY-NOTFOUND")))
 	set(SDL_FOUND TRUE)
 else()
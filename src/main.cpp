@@ -1,4 +1,6 @@
 #include <iostream>
+#include <string>
+#include <cstdlib>
 #include "rendering\renderEngine.h"
 
 
@@ -8,25 +10,309 @@
 #endif
 
 
+static void print_usage(){
+	std::cout << "Opcije:\n"
+		<< "  --bez-prozora        iscrtavanje bez prozora i swapchaina (npr. na posluziteljima bez zaslona)\n"
+		<< "  --procesor           iscrtavanje na procesoru, bez Vulkana i grafickog procesora (sprema slike kao --bez-prozora)\n"
+		<< "  --dretve <n>         broj dretvi za iscrtavanje na procesoru (zadano sve jezgre)\n"
+		<< "  --jezgra <ime>       jezgra za iscrtavanje na procesoru: skalarna, prenosiva, avx2 ili avx512 (zadano najbrza podrzana)\n"
+		<< "  --profil <ime>       profil gustoce za SIMD jezgre: eksponencijalni ili tablicni\n"
+		<< "  --opticka-dubina <ime>\n"
+		<< "                       opticka dubina za SIMD jezgre: koracanje, analiticka ili tablica\n"
+		<< "  --regresija          usporedba GPU-a i brzih jezgri procesora s referencom na nepromjenjivom skupu scena;\n"
+		<< "                       uz --procesor samo jezgre procesora (zadano 480x270, slike razlika u mapi 'regresija')\n"
+		<< "  --mjerenje <putanja> mjerenje brzine bez prozora za sve kombinacije postavki; rezultati se zapisuju kao JSON\n"
+		<< "  --razlucivosti <popis>\n"
+		<< "                       razlucivosti za mjerenje, npr. 1920x1080,1280x720 (zadano --sirina x --visina)\n"
+		<< "  --uzorci-unutra <popis>\n"
+		<< "                       broj iteracija zrake za mjerenje, npr. 5,10,20 (zadano 10)\n"
+		<< "  --uzorci-van <popis> broj iteracija tlaka za mjerenje (zadano 10)\n"
+		<< "  --nacini <popis>     nacini rasprsenja za mjerenje: 1 - Rayleigh, 2 - Mie, 3 - oba (zadano 3)\n"
+		<< "  --kamere <popis>     polozaji kamere za mjerenje: tlo, obzor, orbita, sumrak, sunce, aerosoli (zadano tlo)\n"
+		<< "  --zagrijavanje <n>   broj slika prije mjerenja svake kombinacije (zadano 30)\n"
+		<< "  --oznaka <tekst>     oznaka koja se zapisuje u rezultate mjerenja (npr. hash commita)\n"
+		<< "  --trag <putanja>     snimanje traga izvodenja (Chrome trace JSON) od pokretanja do izlaza\n"
+		<< "  --snimi-unos <putanja>\n"
+		<< "                       snimanje unosa i parametara sucelja za svaku sliku (kao F4)\n"
+		<< "  --ponovi-unos <putanja>\n"
+		<< "                       ponavljanje snimke unosa slika po slika; na kraju se ispisuje trajanje slika\n"
+		<< "  --ogranicenje-fps <n>\n"
+		<< "                       najveci broj slika u sekundi u prozoru (zadano bez ogranicenja)\n"
+		<< "  --bez-mirovanja      iscrtavanje svake slike i kada se nista ne mijenja ili prozor nema fokus\n"
+		<< "  --fps-bez-fokusa <n> broj slika u sekundi dok prozor nema fokus (zadano 10, 0 - bez iscrtavanja)\n"
+		<< "  --bez-dretve-iscrtavanja\n"
+		<< "                       snimanje i slanje naredbi na glavnoj dretvi, zajedno s unosom i suceljem\n"
+		<< "  --budzet-slike <ms>  najdulja slika na GPU-u koju odrzava dinamicka razlucivost (zadano 16.7, 0 - bez dinamicke razlucivosti)\n"
+		<< "  --foveacija <sredina|mis|pogled>\n"
+		<< "                       manje uzoraka dalje od tocke fokusa; 'pogled' cita retke \"x y\" (0-1) sa standardnog ulaza\n"
+		<< "  --prilagodljivi-uzorci\n"
+		<< "                       manje uzoraka u glatkim dijelovima slike, prema predprolazu niske razlucivosti\n"
+		<< "  --prikaz-plocica     prilagodljivi broj uzoraka s prikazom budzeta svake plocice preko slike\n"
+		<< "  --dretve-snimanja <n>\n"
+		<< "                       dodatne dretve za snimanje prolaza slike (zadano 1, 0 - svi prolazi na jednoj dretvi)\n"
+		<< "  --putanja <putanja>  unaprijed zadana putanja kamere, sunca i atmosfere (ukljucivo bez prozora); program zavrsava na kraju putanje\n"
+		<< "  --putanja-fps <n>    broj slika po sekundi vremena putanje (zadano 60)\n"
+		<< "  --korak-ponavljanja <ms>\n"
+		<< "                       stalan razmak slika pri ponavljanju, ili 'snimljeni' za razmak iz snimke (zadano bez cekanja)\n"
+		<< "  --sirina <px>        sirina slike\n"
+		<< "  --visina <px>        visina slike\n"
+		<< "  --broj-slika <n>     broj slika koje se iscrtavaju bez prozora (zadano 1; kod mjerenja broj mjerenih slika, zadano 300)\n"
+		<< "  --izlaz <putanja>    datoteka u koju se spremaju slike iscrtane bez prozora; format se odreduje ekstenzijom:\n"
+		<< "                       .ppm, .png (8 bita) ili .pfm, .exr (linearne float vrijednosti)\n";
+}
+
+
 #undef main
-int main(int argc, char* argv){
+int main(int argc, char* argv[]){
 
-// Prikazivanje tone veliine prozora na Windows sustavima
+// Prikazivanje točne veličine prozora na Windows sustavima
 #ifdef _WIN32
 	SetProcessDPIAware();
 #endif
 	
-	// Unos poetnih podataka u engine
+	// Unos početnih podataka u engine
 	RenderEngine main_engine;
 	main_engine._max_uniform_memory = 1 << 16;
 
 	main_engine._screen_size_x = 1600;
 	main_engine._screen_size_y = 900;
 
+	// Argumenti naredbenog retka
+	unsigned int headless_frame_count = 1;
+	std::string headless_output = "slika.ppm";
+	bool cpu_render = false;
+	unsigned int cpu_thread_count = 0;
+	bool regression = false;
+	bool size_given = false;
+	bool benchmark = false;
+	bool frame_count_given = false;
+	BenchmarkConfig benchmark_config;
+
+	for (int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (arg == "--bez-prozora"){
+			main_engine._headless = true;
+		}
+		else if (arg == "--procesor"){
+			cpu_render = true;
+		}
+		else if (arg == "--dretve" && has_value){
+			cpu_thread_count = (unsigned int)std::atoi(argv[++i]);
+		}
+		else if (arg == "--jezgra" && has_value){
+			std::string name = argv[++i];
+			bool found = false;
+			for (CpuRenderer::Kernel kernel : { CpuRenderer::Kernel::Scalar, CpuRenderer::Kernel::Generic, CpuRenderer::Kernel::Avx2, CpuRenderer::Kernel::Avx512 }){
+				if (name == CpuRenderer::kernel_name(kernel)){
+					main_engine._cpu_kernel = kernel;
+					found = true;
+				}
+			}
+			if (!found){
+				std::cerr << "Nepoznata jezgra: " << name << "\n";
+				print_usage();
+				return 1;
+			}
+		}
+		else if (arg == "--profil" && has_value){
+			std::string name = argv[++i];
+			bool found = false;
+			for (CpuDensityProfile profile : { CpuDensityProfile::Exponential, CpuDensityProfile::Tabulated }){
+				if (name == CpuRenderer::density_profile_name(profile)){
+					main_engine._cpu_density_profile = profile;
+					found = true;
+				}
+			}
+			if (!found){
+				std::cerr << "Nepoznat profil gustoce: " << name << "\n";
+				print_usage();
+				return 1;
+			}
+		}
+		else if (arg == "--opticka-dubina" && has_value){
+			std::string name = argv[++i];
+			bool found = false;
+			for (CpuOpticalDepth depth : { CpuOpticalDepth::Marched, CpuOpticalDepth::Analytic, CpuOpticalDepth::Lut }){
+				if (name == CpuRenderer::optical_depth_name(depth)){
+					main_engine._cpu_optical_depth = depth;
+					found = true;
+				}
+			}
+			if (!found){
+				std::cerr << "Nepoznata opticka dubina: " << name << "\n";
+				print_usage();
+				return 1;
+			}
+		}
+		else if (arg == "--regresija"){
+			regression = true;
+		}
+		else if (arg == "--mjerenje" && has_value){
+			benchmark = true;
+			benchmark_config.output_path = argv[++i];
+		}
+		else if (arg == "--zagrijavanje" && has_value){
+			benchmark_config.warmup_frames = (unsigned int)std::atoi(argv[++i]);
+		}
+		else if (arg == "--oznaka" && has_value){
+			benchmark_config.label = argv[++i];
+		}
+		else if ((arg == "--razlucivosti" || arg == "--uzorci-unutra" || arg == "--uzorci-van" || arg == "--nacini" || arg == "--kamere") && has_value){
+			std::string list = argv[++i];
+			bool valid;
+			if (arg == "--razlucivosti") valid = parse_resolution_list(list, benchmark_config.resolutions);
+			else if (arg == "--uzorci-unutra") valid = parse_int_list(list, benchmark_config.sample_amounts_in);
+			else if (arg == "--uzorci-van") valid = parse_int_list(list, benchmark_config.sample_amounts_out);
+			else if (arg == "--kamere") valid = parse_name_list(list, benchmark_config.cameras);
+			else{
+				valid = parse_int_list(list, benchmark_config.modes);
+				for (int mode : benchmark_config.modes) valid = valid && mode <= 3;
+			}
+			if (!valid){
+				std::cerr << "Neispravan popis za " << arg << ": " << list << "\n";
+				print_usage();
+				return 1;
+			}
+		}
+		else if (arg == "--sirina" && has_value){
+			main_engine._screen_size_x = (unsigned int)std::atoi(argv[++i]);
+			size_given = true;
+		}
+		else if (arg == "--visina" && has_value){
+			main_engine._screen_size_y = (unsigned int)std::atoi(argv[++i]);
+			size_given = true;
+		}
+		else if (arg == "--broj-slika" && has_value){
+			headless_frame_count = (unsigned int)std::atoi(argv[++i]);
+			frame_count_given = true;
+		}
+		else if (arg == "--izlaz" && has_value){
+			headless_output = argv[++i];
+		}
+		else if (arg == "--trag" && has_value){
+			main_engine._trace_path = argv[++i];
+		}
+		else if (arg == "--snimi-unos" && has_value){
+			main_engine._input_record_path = argv[++i];
+		}
+		else if (arg == "--ponovi-unos" && has_value){
+			main_engine._input_replay_path = argv[++i];
+		}
+		else if (arg == "--putanja" && has_value){
+			std::string error;
+			if (!main_engine._camera_path.load(argv[++i], error)){
+				std::cerr << error << "\n";
+				return 1;
+			}
+		}
+		else if (arg == "--putanja-fps" && has_value){
+			main_engine._camera_path_fps = std::atof(argv[++i]);
+			if (main_engine._camera_path_fps <= 0){
+				std::cerr << "Neispravan broj slika u sekundi putanje\n";
+				return 1;
+			}
+		}
+		else if (arg == "--ogranicenje-fps" && has_value){
+			main_engine._frame_pacer.set_limit(std::atof(argv[++i]));
+		}
+		else if (arg == "--bez-mirovanja"){
+			main_engine._idle_enabled = false;
+		}
+		else if (arg == "--fps-bez-fokusa" && has_value){
+			main_engine._background_fps = std::atof(argv[++i]);
+		}
+		else if (arg == "--bez-dretve-iscrtavanja"){
+			main_engine._use_render_thread = false;
+		}
+		else if (arg == "--budzet-slike" && has_value){
+			double budget_ms = std::atof(argv[++i]);
+			if (budget_ms > 0) main_engine._frame_budget_ms = budget_ms;
+			else main_engine._dynamic_resolution = false;
+		}
+		else if (arg == "--foveacija" && has_value){
+			std::string name = argv[++i];
+			bool found = false;
+			for (FoveationFocus focus : { FoveationFocus::Center, FoveationFocus::Mouse, FoveationFocus::Gaze }){
+				if (name == foveation_focus_name(focus)){
+					main_engine._foveation.enabled = true;
+					main_engine._foveation_focus = focus;
+					found = true;
+				}
+			}
+			if (!found){
+				std::cerr << "Nepoznata tocka fokusa: " << name << "\n";
+				return 1;
+			}
+			if (main_engine._foveation_focus == FoveationFocus::Gaze) main_engine._gaze.start();
+		}
+		else if (arg == "--prilagodljivi-uzorci"){
+			main_engine._adaptive_sampling.enabled = true;
+		}
+		else if (arg == "--prikaz-plocica"){
+			main_engine._adaptive_sampling.enabled = true;
+			main_engine._adaptive_sampling.show_tiles = true;
+		}
+		else if (arg == "--dretve-snimanja" && has_value){
+			main_engine._recording_threads = (unsigned int)std::max(0, std::atoi(argv[++i]));
+		}
+		else if (arg == "--korak-ponavljanja" && has_value){
+			std::string step = argv[++i];
+			main_engine._replay_step_ms = step == "snimljeni" ? -1.0 : std::atof(step.c_str());
+		}
+		else{
+			std::cerr << "Nepoznat argument: " << arg << "\n";
+			print_usage();
+			return 1;
+		}
+	}
+
+	// Referenca na procesoru je spora, pa provjera regresije zadano radi na manjoj slici.
+	// GPU slika se uspoređuje u floatu, bez prozora
+	if (regression){
+		if (!size_given){
+			main_engine._screen_size_x = 480;
+			main_engine._screen_size_y = 270;
+		}
+		main_engine._headless = true;
+		main_engine._output_format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	}
+
+	// Mjerenje uvijek radi bez prozora, kako prikaz i sinkronizacija sa zaslonom ne bi ulazili u vrijeme
+	if (benchmark){
+		main_engine._headless = true;
+		if (benchmark_config.resolutions.empty()){
+			benchmark_config.resolutions.push_back({ main_engine._screen_size_x, main_engine._screen_size_y });
+		}
+		if (frame_count_given){
+			benchmark_config.measured_frames = headless_frame_count;
+		}
+
+		// Izlazna slika se alocira za prvu razlučivost, a ostale ju po potrebi povećavaju
+		main_engine._screen_size_x = benchmark_config.resolutions[0].width;
+		main_engine._screen_size_y = benchmark_config.resolutions[0].height;
+	}
+
+	// Bez prozora putanja se zadano iscrtava cijela
+	if (!main_engine._camera_path.empty() && !frame_count_given){
+		headless_frame_count = (unsigned int)(main_engine._camera_path.duration() * main_engine._camera_path_fps) + 1;
+	}
+
+	// Float datoteke dobivaju float izlaznu sliku, da se ne izgube vrijednosti iznad 1
+	if (main_engine._headless && image_format_is_float(image_format_from_path(headless_output))){
+		main_engine._output_format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	}
+
+	if (main_engine._screen_size_x == 0 || main_engine._screen_size_y == 0){
+		std::cerr << "Neispravna velicina slike\n";
+		return 1;
+	}
+
 
 	main_engine.sun = Sun{
 		1.496f * powf(10, 8) * 1000, // Udaljenost (1.496 * 10^8 km)
-		1391400.0f * 1000, // Veliina
+		1391400.0f * 1000, // Veličina
 
 		50.0f, // Kut nagiba
 
@@ -41,13 +327,13 @@ int main(int argc, char* argv){
 	Atmosphere earth_atmosphere = Atmosphere{
 		101325, // Tlak na morskoj razini (u pa)
 
-		8700, // Visina na kojoj se nalazi prosjena gustoa atmosfere
-		1200, // Visina na kojoj se nalazi prosjena gustoa aerosola u atmosferi
+		8700, // Visina na kojoj se nalazi prosječna gustoća atmosfere
+		1200, // Visina na kojoj se nalazi prosječna gustoća aerosola u atmosferi
 
 
 
-		0.1f, // Relativna koliina aerosola
-		0.90, // Konstanta asmetrije kuta aerosolnog Mie rasprivanja
+		0.1f, // Relativna količina aerosola
+		0.90, // Konstanta asmetrije kuta aerosolnog Mie raspršivanja
 
 		100 * 1000, // Maksimalna razina
 
@@ -68,7 +354,7 @@ int main(int argc, char* argv){
 	);
 
 
-	// Raunanje konstanti Rayleighove jednadbe
+	// Računanje konstanti Rayleighove jednadžbe
 	double pi = 3.141592654;
 
 	double surface_mole_number =  (earth_atmosphere.surface_pressure_pa * (1*1*1)) / (8.3144621 * earth_atmosphere.temperature);
@@ -77,7 +363,7 @@ int main(int argc, char* argv){
 	double num_air_particles_2 = surface_mole_number  * (6.02214076 * pow(10,23)) /*Avogadrova konstanta*/;
 	//double num_air_particles_2 = (surface_mass / earth_atmosphere.molar_mass) * (6.02214076 * pow(10,23)) /*Avogadrova konstanta*/;
 	
-	// Koliina molekula po kubnom metru na povrini
+	// Količina molekula po kubnom metru na površini
 	double surface_molecule_density = num_air_particles_2 / (1*1*1);
 
 	double K = 2 * pi * pi * (earth_atmosphere.refractivity*earth_atmosphere.refractivity - 1) * (earth_atmosphere.refractivity*earth_atmosphere.refractivity - 1) / surface_molecule_density / 3.0f;
@@ -88,11 +374,43 @@ int main(int argc, char* argv){
 	main_engine.sample_amount_out = 10;
 
 
+	if (regression){
+		bool passed;
+		if (cpu_render){
+			passed = main_engine.run_regression(false);
+		}
+		else{
+			main_engine.init();
+			passed = main_engine.run_regression(true);
+			main_engine.cleanup();
+		}
+		return passed ? 0 : 1;
+	}
+
+	if (benchmark){
+		main_engine.init();
+		bool written = main_engine.run_benchmark(benchmark_config);
+		main_engine.cleanup();
+		return written ? 0 : 1;
+	}
+
+	// Iscrtavanje na procesoru ne treba ni prozor ni Vulkan
+	if (cpu_render){
+		main_engine.render_cpu(headless_frame_count, headless_output, cpu_thread_count);
+		return 0;
+	}
+
 	// Pokretanje sustava za prikaz
 	main_engine.init();
-	main_engine.run();
 
-	// Izvrava se kada se prozor zatvori
+	if (main_engine._headless){
+		main_engine.run_headless(headless_frame_count, headless_output);
+	}
+	else{
+		main_engine.run();
+	}
+
+	// Izvršava se kada se prozor zatvori
 	main_engine.cleanup();
 
 	return 0;
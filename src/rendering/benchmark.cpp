@@ -0,0 +1,160 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+
+FrameTimeStats compute_frame_time_stats(std::vector<double> samples){
+
+	FrameTimeStats stats = { 0, 0, 0, 0, 0, 0, 0 };
+	if (samples.empty()) return stats;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (double sample : samples) sum += sample;
+
+	// Najbliži rang - najmanji uzorak od kojega je barem p posto uzoraka manje ili jednako
+	auto percentile = [&](double p) {
+		size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+		return samples[std::min(std::max(rank, (size_t)1), samples.size()) - 1];
+	};
+
+	stats.count = (unsigned int)samples.size();
+	stats.mean = sum / samples.size();
+	stats.min = samples.front();
+	stats.max = samples.back();
+	stats.p50 = percentile(50);
+	stats.p95 = percentile(95);
+	stats.p99 = percentile(99);
+	return stats;
+}
+
+
+std::string json_string(const std::string& text){
+	std::ostringstream out;
+	out << '"';
+	for (char c : text) {
+		switch (c) {
+		case '"': out << "\\\""; break;
+		case '\\': out << "\\\\"; break;
+		case '\n': out << "\\n"; break;
+		case '\t': out << "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20) out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+			else out << c;
+		}
+	}
+	out << '"';
+	return out.str();
+}
+
+static void write_stats(std::ostream& out, const FrameTimeStats& stats){
+	out << "{ \"slika\": " << stats.count
+		<< ", \"prosjek\": " << stats.mean
+		<< ", \"min\": " << stats.min
+		<< ", \"max\": " << stats.max
+		<< ", \"p50\": " << stats.p50
+		<< ", \"p95\": " << stats.p95
+		<< ", \"p99\": " << stats.p99 << " }";
+}
+
+bool write_benchmark_json(const std::string& path, const BenchmarkReport& report){
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out) return false;
+
+	char date[32] = "";
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	out << std::setprecision(6);
+	out << "{\n"
+		<< "  \"oznaka\": " << json_string(report.label) << ",\n"
+		<< "  \"datum\": " << json_string(date) << ",\n"
+		<< "  \"uredaj\": " << json_string(report.device_name) << ",\n"
+		<< "  \"verzija_upravljackog_programa\": " << report.driver_version << ",\n"
+		<< "  \"vremenske_oznake_gpu\": " << (report.gpu_timestamps ? "true" : "false") << ",\n"
+		<< "  \"slike_zagrijavanja\": " << report.warmup_frames << ",\n"
+		<< "  \"mjerene_slike\": " << report.measured_frames << ",\n"
+		<< "  \"mjerenja\": [";
+
+	for (size_t i = 0; i < report.cases.size(); i++) {
+		const BenchmarkCase& c = report.cases[i];
+		out << (i ? ",\n" : "\n")
+			<< "    {\n"
+			<< "      \"sirina\": " << c.resolution.width << ",\n"
+			<< "      \"visina\": " << c.resolution.height << ",\n"
+			<< "      \"uzorci_unutra\": " << c.sample_amount_in << ",\n"
+			<< "      \"uzorci_van\": " << c.sample_amount_out << ",\n"
+			<< "      \"nacin\": " << c.mode << ",\n"
+			<< "      \"kamera\": " << json_string(c.camera) << ",\n"
+			<< "      \"varijanta_sjencara\": " << (c.shader_variant ? "true" : "false") << ",\n"
+			<< "      \"pozivi_sjencara\": " << c.compute_invocations << ",\n"
+			<< "      \"gpu_ms\": ";
+		write_stats(out, c.gpu_ms);
+		out << ",\n      \"procesor_ms\": ";
+		write_stats(out, c.cpu_ms);
+		out << "\n    }";
+	}
+
+	out << "\n  ]\n}\n";
+	return (bool)out;
+}
+
+
+// Dijeli tekst po zarezima - prazni elementi nisu dopušteni
+static bool split_list(const std::string& text, std::vector<std::string>& items){
+	items.clear();
+	std::stringstream stream(text);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		if (item.empty()) return false;
+		items.push_back(item);
+	}
+	return !items.empty() && text.back() != ',';
+}
+
+static bool parse_positive(const std::string& text, int& value){
+	char* end = nullptr;
+	long parsed = std::strtol(text.c_str(), &end, 10);
+	if (end == text.c_str() || *end != '\0' || parsed <= 0 || parsed > 1 << 16) return false;
+	value = (int)parsed;
+	return true;
+}
+
+bool parse_resolution_list(const std::string& text, std::vector<BenchmarkResolution>& resolutions){
+	std::vector<std::string> items;
+	if (!split_list(text, items)) return false;
+
+	resolutions.clear();
+	for (const std::string& item : items) {
+		size_t x = item.find('x');
+		int width, height;
+		if (x == std::string::npos || !parse_positive(item.substr(0, x), width) || !parse_positive(item.substr(x + 1), height)) return false;
+		resolutions.push_back({ (uint32_t)width, (uint32_t)height });
+	}
+	return true;
+}
+
+bool parse_int_list(const std::string& text, std::vector<int>& values){
+	std::vector<std::string> items;
+	if (!split_list(text, items)) return false;
+
+	values.clear();
+	for (const std::string& item : items) {
+		int value;
+		if (!parse_positive(item, value)) return false;
+		values.push_back(value);
+	}
+	return true;
+}
+
+bool parse_name_list(const std::string& text, std::vector<std::string>& names){
+	return split_list(text, names);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// Mjerenje brzine iscrtavanja (--mjerenje): za svaku kombinaciju razlučivosti, broja uzoraka, načina raspršenja i
+// položaja kamere iscrta se nekoliko slika za zagrijavanje, a zatim zadani broj mjerenih slika bez prozora.
+// Za svaku sliku bilježi se trajanje komputacijskog sjenčara na GPU-u (vremenske oznake) i vrijeme između dvaju slanja
+// na procesoru. Rezultati se zapisuju kao JSON, pa se mogu uspoređivati između verzija na istom računalu
+
+struct BenchmarkResolution {
+	uint32_t width;
+	uint32_t height;
+};
+
+struct BenchmarkConfig {
+	std::vector<BenchmarkResolution> resolutions;		// Mora se zadati barem jedna (main.cpp zadaje --sirina x --visina)
+	std::vector<int> sample_amounts_in = { 10 };
+	std::vector<int> sample_amounts_out = { 10 };
+	std::vector<int> modes = { 3 };						// Bitovi načina raspršenja: 1 - Rayleigh, 2 - Mie
+	std::vector<std::string> cameras = { "tlo" };		// Imena scena iz regression_scenes()
+
+	unsigned int warmup_frames = 30;
+	unsigned int measured_frames = 300;
+
+	std::string output_path = "mjerenje.json";
+	std::string label;									// Proizvoljna oznaka (npr. hash commita) koja se zapisuje u rezultate
+};
+
+// Vremena su u milisekundama. Percentili se računaju metodom najbližeg ranga
+struct FrameTimeStats {
+	unsigned int count;
+	double mean;
+	double min;
+	double max;
+	double p50;
+	double p95;
+	double p99;
+};
+
+FrameTimeStats compute_frame_time_stats(std::vector<double> samples);
+
+struct BenchmarkCase {
+	BenchmarkResolution resolution;
+	int sample_amount_in;
+	int sample_amount_out;
+	int mode;
+	std::string camera;
+
+	// Je li mjerena specijalizirana varijanta sjenčara ili opći sjenčar (ako varijanta nije izgrađena)
+	bool shader_variant;
+
+	// Broj poziva komputacijskog sjenčara po slici (0 ako statistika protočnog sustava nije podržana)
+	uint64_t compute_invocations;
+
+	FrameTimeStats gpu_ms;		// Prazno (count = 0) ako uređaj ne podržava vremenske oznake
+	FrameTimeStats cpu_ms;
+};
+
+struct BenchmarkReport {
+	std::string label;
+	std::string device_name;
+	uint32_t driver_version;
+	bool gpu_timestamps;
+	unsigned int warmup_frames;
+	unsigned int measured_frames;
+
+	std::vector<BenchmarkCase> cases;
+};
+
+bool write_benchmark_json(const std::string& path, const BenchmarkReport& report);
+
+// Tekst kao JSON niz s navodnicima i izbjegnutim znakovima - koristi ga i trag izvođenja (traceRecorder.cpp)
+std::string json_string(const std::string& text);
+
+// Popisi iz naredbenog retka, odvojeni zarezima: "1920x1080,1280x720", "5,10,20", "tlo,orbita".
+// Vraćaju false ako neki element nije ispravan
+bool parse_resolution_list(const std::string& text, std::vector<BenchmarkResolution>& resolutions);
+bool parse_int_list(const std::string& text, std::vector<int>& values);
+bool parse_name_list(const std::string& text, std::vector<std::string>& names);
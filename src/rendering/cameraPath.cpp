@@ -0,0 +1,158 @@
+#include "cameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+
+// Ime u datoteci i vrijednosti koje zadaje (uzastopne, počevši od first)
+struct PathProperty {
+	const char* name;
+	CameraPath::Channel first;
+	int count;
+};
+
+static const PathProperty path_properties[] = {
+	{ "polozaj", CameraPath::ChannelPositionX, 3 },
+	{ "smjer", CameraPath::ChannelYaw, 2 },
+	{ "sunce", CameraPath::ChannelSunAngle, 1 },
+	{ "tlak", CameraPath::ChannelSurfacePressure, 1 },
+	{ "visina_zraka", CameraPath::ChannelDensityHeight, 1 },
+	{ "visina_aerosola", CameraPath::ChannelDensityHeightAerosol, 1 },
+	{ "aerosoli", CameraPath::ChannelAerosolDensity, 1 },
+	{ "mie", CameraPath::ChannelMieAsymmetry, 1 },
+	{ "granica", CameraPath::ChannelUpperLimit, 1 },
+	{ "intenzitet", CameraPath::ChannelLightIntensity, 1 },
+};
+
+
+bool CameraPath::load(const std::string& path, std::string& error){
+	std::ifstream file(path);
+	if (!file) {
+		error = "Putanja '" + path + "' ne postoji";
+		return false;
+	}
+	return parse(file, path, error);
+}
+
+bool CameraPath::parse(std::istream& in, const std::string& name, std::string& error){
+
+	for (std::vector<Key>& channel : _channels) channel.clear();
+
+	bool has_key = false;
+	double key_time = 0;
+
+	std::string line;
+	for (unsigned int line_number = 1; std::getline(in, line); line_number++) {
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) line.erase(comment);
+
+		std::istringstream words(line);
+		std::string word;
+		if (!(words >> word)) continue;
+
+		std::string location = name + ":" + std::to_string(line_number) + ": ";
+
+		if (word == "kljuc") {
+			double time;
+			if (!(words >> time) || time < 0 || (has_key && time <= key_time)) {
+				error = location + "vrijeme kljuca mora biti nenegativno i vece od prethodnog";
+				return false;
+			}
+			has_key = true;
+			key_time = time;
+		}
+		else {
+			const PathProperty* property = nullptr;
+			for (const PathProperty& candidate : path_properties) {
+				if (word == candidate.name) property = &candidate;
+			}
+			if (!property) {
+				error = location + "nepoznato svojstvo '" + word + "'";
+				return false;
+			}
+			if (!has_key) {
+				error = location + "svojstvo prije prvog kljuca";
+				return false;
+			}
+
+			for (int i = 0; i < property->count; i++) {
+				double value;
+				if (!(words >> value)) {
+					error = location + "svojstvo '" + word + "' treba " + std::to_string(property->count) + " vrijednosti";
+					return false;
+				}
+
+				std::vector<Key>& keys = _channels[property->first + i];
+				if (!keys.empty() && keys.back().time == key_time) {
+					error = location + "svojstvo '" + word + "' zadano je dvaput u istom kljucu";
+					return false;
+				}
+				keys.push_back({ key_time, value });
+			}
+		}
+
+		std::string extra;
+		if (words >> extra) {
+			error = location + "visak teksta '" + extra + "'";
+			return false;
+		}
+	}
+
+	if (empty()) {
+		error = name + ": putanja nema nijednu vrijednost";
+		return false;
+	}
+	return true;
+}
+
+bool CameraPath::empty() const{
+	for (const std::vector<Key>& channel : _channels) {
+		if (!channel.empty()) return false;
+	}
+	return true;
+}
+
+double CameraPath::duration() const{
+	double duration = 0;
+	for (const std::vector<Key>& channel : _channels) {
+		if (!channel.empty()) duration = std::max(duration, channel.back().time);
+	}
+	return duration;
+}
+
+CameraPath::Sample CameraPath::evaluate(double time) const{
+	Sample sample;
+	for (int channel = 0; channel < ChannelCount; channel++) {
+		if (_channels[channel].empty()) continue;
+		sample.has[channel] = true;
+		sample.value[channel] = evaluate_channel(_channels[channel], time);
+	}
+	return sample;
+}
+
+// Catmull-Rom spline za nejednako razmaknute ključeve: Hermiteov polinom s tangentama iz susjednih ključeva.
+// Na rubovima se tangenta računa iz jedinog susjeda
+double CameraPath::evaluate_channel(const std::vector<Key>& keys, double time){
+
+	if (time <= keys.front().time) return keys.front().value;
+	if (time >= keys.back().time) return keys.back().value;
+
+	size_t i = 0;
+	while (keys[i + 1].time < time) i++;
+
+	const Key& k1 = keys[i];
+	const Key& k2 = keys[i + 1];
+	const Key& k0 = i > 0 ? keys[i - 1] : k1;
+	const Key& k3 = i + 2 < keys.size() ? keys[i + 2] : k2;
+
+	double dt = k2.time - k1.time;
+	double m1 = (k2.value - k0.value) / (k2.time - k0.time) * dt;
+	double m2 = (k3.value - k1.value) / (k3.time - k1.time) * dt;
+
+	double t = (time - k1.time) / dt;
+	double t2 = t * t;
+	double t3 = t2 * t;
+
+	return (2 * t3 - 3 * t2 + 1) * k1.value + (t3 - 2 * t2 + t) * m1 + (-2 * t3 + 3 * t2) * k2.value + (t3 - t2) * m2;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+
+// Unaprijed zadana putanja kamere, sunca i atmosfere (npr. izlazak sunca iz orbite) za mjerenja i demonstracije.
+// Datoteka je tekstualna - svaki "kljuc <vrijeme u s>" započinje ključnu točku, a retci ispod nje zadaju vrijednosti:
+//
+//   # Izlazak sunca iz orbite
+//   kljuc 0
+//   polozaj 0 6771000 0      # metri, središte planeta je u ishodištu
+//   smjer 0 -15              # zakret i nagib kamere u stupnjevima (kao mišem)
+//   sunce -10                # kut sunca u stupnjevima
+//   kljuc 20
+//   polozaj 0 6771000 400000
+//   sunce 25
+//   aerosoli 2
+//
+// Svaka vrijednost interpolira se zasebno (Catmull-Rom spline preko ključnih točaka u kojima je zadana), pa
+// ključ ne mora sadržavati sve vrijednosti. Prije prve i nakon zadnje ključne točke vrijednost je konstantna
+class CameraPath {
+
+public:
+	enum Channel {
+		ChannelPositionX,
+		ChannelPositionY,
+		ChannelPositionZ,
+		ChannelYaw,					// Stupnjevi
+		ChannelPitch,				// Stupnjevi
+		ChannelSunAngle,			// Stupnjevi
+		ChannelSurfacePressure,		// Pa
+		ChannelDensityHeight,		// m
+		ChannelDensityHeightAerosol,// m
+		ChannelAerosolDensity,
+		ChannelMieAsymmetry,
+		ChannelUpperLimit,			// m
+		ChannelLightIntensity,
+		ChannelCount
+	};
+
+	// Vrijednosti u jednom trenutku. Vrijednost koja nije zadana ni u jednom ključu ima has = false
+	struct Sample {
+		bool has[ChannelCount] = {};
+		double value[ChannelCount] = {};
+	};
+
+	bool load(const std::string& path, std::string& error);
+	bool parse(std::istream& in, const std::string& name, std::string& error);
+
+	bool empty() const;
+
+	// Vrijeme zadnje ključne točke (s)
+	double duration() const;
+
+	Sample evaluate(double time) const;
+
+private:
+	struct Key {
+		double time;
+		double value;
+	};
+
+	static double evaluate_channel(const std::vector<Key>& keys, double time);
+
+	std::vector<Key> _channels[ChannelCount];
+};
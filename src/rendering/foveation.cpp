@@ -0,0 +1,60 @@
+#include "foveation.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+const char* foveation_focus_name(FoveationFocus focus){
+	switch (focus) {
+	case FoveationFocus::Center: return "sredina";
+	case FoveationFocus::Mouse: return "mis";
+	case FoveationFocus::Gaze: return "pogled";
+	}
+	return "?";
+}
+
+
+static uint64_t pack_point(float x, float y){
+	uint32_t bits[2];
+	std::memcpy(&bits[0], &x, sizeof(float));
+	std::memcpy(&bits[1], &y, sizeof(float));
+	return (uint64_t)bits[0] | ((uint64_t)bits[1] << 32);
+}
+
+void GazeInput::store(Point& point, float x, float y){
+	point.packed.store(pack_point(std::clamp(x, 0.0f, 1.0f), std::clamp(y, 0.0f, 1.0f)), std::memory_order_relaxed);
+	point.valid.store(true, std::memory_order_release);
+}
+
+void GazeInput::set(float x, float y){
+	store(*_point, x, y);
+}
+
+bool GazeInput::get(float& x, float& y) const{
+	if (!_point->valid.load(std::memory_order_acquire)) return false;
+
+	uint64_t packed = _point->packed.load(std::memory_order_relaxed);
+	uint32_t bits[2] = { (uint32_t)packed, (uint32_t)(packed >> 32) };
+	std::memcpy(&x, &bits[0], sizeof(float));
+	std::memcpy(&y, &bits[1], sizeof(float));
+	return true;
+}
+
+void GazeInput::start(){
+	if (_started) return;
+	_started = true;
+
+	std::shared_ptr<Point> point = _point;
+	std::thread([point]() {
+		std::string line;
+		while (std::getline(std::cin, line)) {
+			std::istringstream in(line);
+			float x, y;
+			if (in >> x >> y) store(*point, x, y);
+		}
+	}).detach();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+// Foveacija: puni broj uzoraka samo oko točke fokusa, a prema rubu slike sve manje. Na velikim zaslonima rub slike
+// se ionako ne gleda izravno, pa se tako uštedi velik dio računanja
+enum class FoveationFocus {
+	Center,		// Sredina prozora
+	Mouse,		// Pokazivač miša
+	Gaze		// Točka pogleda iz vanjskog uređaja (GazeInput)
+};
+
+const char* foveation_focus_name(FoveationFocus focus);
+
+// Postavke jedne slike. Veličine su udio visine slike, pa ne ovise o razlučivosti
+struct FoveationParameters {
+	bool enabled = false;
+
+	// Točka fokusa u prozoru (0 - 1, 0 0 je gornji lijevi kut)
+	float focus_x = 0.5f;
+	float focus_y = 0.5f;
+
+	float radius = 0.15f;			// Polumjer pune kvalitete
+	float falloff = 0.3f;			// Širina glatkog prijelaza prema rubu
+	float periphery_factor = 0.3f;	// Udio ukupnog broja uzoraka izvan prijelaza
+};
+
+
+// Točka pogleda s uređaja za praćenje oka. Uređaj (ili program koji ga povezuje) šalje na standardni ulaz retke
+// "x y" s koordinatama u prozoru od 0 do 1. Čita se na zasebnoj dretvi, a zadnja točka preuzima se bez zaključavanja
+class GazeInput {
+
+public:
+	// Pokreće čitanje standardnog ulaza. Dretva se ne čeka pri izlazu, jer čitanje može stajati neograničeno dugo
+	void start();
+
+	void set(float x, float y);
+
+	// Vraća false dok ne stigne prva točka
+	bool get(float& x, float& y) const;
+
+private:
+	struct Point {
+		std::atomic<uint64_t> packed{ 0 };	// x i y kao dva floata, da se uvijek čitaju zajedno
+		std::atomic<bool> valid{ false };
+	};
+
+	static void store(Point& point, float x, float y);
+
+	// Dijeli se s dretvom čitanja, koja može nadživjeti ovaj objekt
+	std::shared_ptr<Point> _point = std::make_shared<Point>();
+	bool _started = false;
+};
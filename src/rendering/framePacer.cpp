@@ -0,0 +1,47 @@
+#include "framePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+
+void FramePacer::set_limit(double fps){
+	_limit = std::max(fps, 0.0);
+	_has_next_frame = false;
+}
+
+void FramePacer::wait(){
+	if (_limit <= 0) return;
+
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _limit));
+	Clock::time_point now = Clock::now();
+
+	// Slika koja kasni više od cijelog razmaka ne pokušava nadoknaditi propušteno - raspored kreće ispočetka
+	if (!_has_next_frame || now - _next_frame > period) {
+		_next_frame = now;
+		_has_next_frame = true;
+	}
+	else {
+		sleep_until(_next_frame);
+	}
+
+	_next_frame += period;
+}
+
+void FramePacer::sleep_until(Clock::time_point deadline){
+
+	Clock::time_point now = Clock::now();
+	double remaining_s = std::chrono::duration<double>(deadline - now).count();
+
+	if (remaining_s > _oversleep_s) {
+		Clock::time_point wake_target = deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_oversleep_s));
+		std::this_thread::sleep_until(wake_target);
+
+		// Kašnjenje se brzo povećava, a sporo smanjuje - jedno kasno buđenje ne smije se ponavljati svaku sliku
+		double late_s = std::chrono::duration<double>(Clock::now() - wake_target).count();
+		if (late_s > _oversleep_s) _oversleep_s = late_s;
+		else _oversleep_s = _oversleep_s * 0.99 + late_s * 0.01;
+		_oversleep_s = std::clamp(_oversleep_s, 0.0002, 0.004);
+	}
+
+	while (Clock::now() < deadline) std::this_thread::yield();
+}
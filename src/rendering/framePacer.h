@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+
+
+// Ograničenje broja slika u sekundi. Do malo prije roka dretva spava, a ostatak čeka aktivno, jer spavanje
+// na većini sustava kasni i do nekoliko milisekundi. Rezerva za aktivno čekanje prilagođava se izmjerenom kašnjenju
+class FramePacer {
+
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// 0 - bez ograničenja
+	void set_limit(double fps);
+	double limit() const { return _limit; }
+
+	// Poziva se jednom po slici, prije obrade unosa (tako unos nije star koliko i čekanje)
+	void wait();
+
+	void sleep_until(Clock::time_point deadline);
+
+private:
+	double _limit = 0;
+
+	bool _has_next_frame = false;
+	Clock::time_point _next_frame;
+
+	// Procjena kašnjenja buđenja iz spavanja (s)
+	double _oversleep_s = 0.001;
+};
@@ -0,0 +1,185 @@
+#include "frameReadback.h"
+#include "traceRecorder.h"
+
+#include <iostream>
+
+
+void FrameReadback::init(VkDevice device, VmaAllocator allocator, unsigned int slot_count, unsigned int worker_count){
+	_device = device;
+	_allocator = allocator;
+
+	_slots.resize(slot_count);
+
+	// Svaki potrošač drži jedan spremnik, pa red poslova ne mora biti veći od broja spremnika
+	_workers.init(worker_count, slot_count);
+}
+
+void FrameReadback::cleanup(){
+	flush();
+	_workers.cleanup();
+
+	for (Slot& slot : _slots) release_buffer(slot);
+	_slots.clear();
+}
+
+
+void FrameReadback::ensure_capacity(Slot& slot, VkDeviceSize size){
+	if (slot.capacity >= size) return;
+
+	// Spremnik je slobodan, pa ga GPU sigurno više ne koristi i može se odmah zamijeniti
+	release_buffer(slot);
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	// Trajno mapiran spremnik - mapiranje pri svakom čitanju bilo bi nepotrebno
+	VmaAllocationCreateInfo vmaallocInfo = {};
+	vmaallocInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+	vmaallocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	VmaAllocationInfo allocationInfo = {};
+	if (vmaCreateBuffer(_allocator, &bufferInfo, &vmaallocInfo, &slot.buffer, &slot.allocation, &allocationInfo) != VK_SUCCESS) {
+		std::cerr << "Spremnik za citanje slike nije uspio biti alociran\n";
+		slot.buffer = VK_NULL_HANDLE;
+		slot.allocation = VK_NULL_HANDLE;
+		return;
+	}
+
+	slot.mapped = allocationInfo.pMappedData;
+	slot.capacity = size;
+}
+
+void FrameReadback::release_buffer(Slot& slot){
+	if (slot.buffer != VK_NULL_HANDLE) {
+		vmaDestroyBuffer(_allocator, slot.buffer, slot.allocation);
+	}
+	slot.buffer = VK_NULL_HANDLE;
+	slot.allocation = VK_NULL_HANDLE;
+	slot.mapped = nullptr;
+	slot.capacity = 0;
+}
+
+
+bool FrameReadback::record_copy(VkCommandBuffer cmd, VkImage image, VkFormat format, VkExtent2D extent, unsigned int frame_index, uint64_t frame_number,
+	Consumer consumer, bool wait_for_slot){
+
+	Slot* slot = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		auto find_free = [&]() {
+			for (Slot& s : _slots) {
+				if (s.state == SlotState::Free) {
+					slot = &s;
+					return true;
+				}
+			}
+			return false;
+		};
+
+		if (!find_free()) {
+			if (!wait_for_slot) {
+				_dropped_frames++;
+				return false;
+			}
+			_slot_freed.wait(lock, find_free);
+		}
+
+		// Zauzimanje spremnika prije otključavanja, da ga potrošač u međuvremenu ne bi dodijelio
+		slot->state = SlotState::Recorded;
+	}
+
+	bool is_float = format == VK_FORMAT_R32G32B32A32_SFLOAT;
+	VkDeviceSize row_pitch = (VkDeviceSize)extent.width * (is_float ? 16 : 4);
+	ensure_capacity(*slot, row_pitch * extent.height);
+
+	if (slot->buffer == VK_NULL_HANDLE) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		slot->state = SlotState::Free;
+		_dropped_frames++;
+		return false;
+	}
+
+	slot->frame_index = frame_index;
+	slot->consumer = std::move(consumer);
+	slot->frame.width = extent.width;
+	slot->frame.height = extent.height;
+	slot->frame.row_pitch = (size_t)row_pitch;
+	slot->frame.is_float = is_float;
+	slot->frame.frame_number = frame_number;
+	slot->frame.data = (const uint8_t*)slot->mapped;
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.bufferOffset = 0;
+	copyRegion.bufferRowLength = 0; // Redovi su gusto složeni
+	copyRegion.bufferImageHeight = 0;
+	copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.imageOffset = { 0, 0, 0 };
+	copyRegion.imageExtent = { extent.width, extent.height, 1 };
+
+	vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->buffer, 1, &copyRegion);
+
+	// Podaci moraju biti vidljivi procesoru nakon ograde
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = slot->buffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+	return true;
+}
+
+void FrameReadback::retire_frame(unsigned int frame_index){
+
+	std::vector<Slot*> ready;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (Slot& slot : _slots) {
+			if (slot.state == SlotState::Recorded && slot.frame_index == frame_index) {
+				slot.state = SlotState::Consuming;
+				ready.push_back(&slot);
+			}
+		}
+	}
+
+	for (Slot* slot : ready) {
+		// Red je velik koliko i broj spremnika, pa ovo nikada ne čeka
+		_workers.submit([this, slot]() {
+			TRACE_SCOPE("spremanje_slike");
+			vmaInvalidateAllocation(_allocator, slot->allocation, 0, VK_WHOLE_SIZE);
+
+			if (slot->consumer) slot->consumer(slot->frame);
+			_completed_frames++;
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				slot->consumer = nullptr;
+				slot->state = SlotState::Free;
+			}
+			_slot_freed.notify_one();
+		});
+	}
+}
+
+void FrameReadback::flush(){
+
+	// Sve snimljene kopije su gotove (pozivatelj je pričekao GPU), pa se odmah predaju potrošačima
+	std::vector<unsigned int> frames;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (Slot& slot : _slots) {
+			if (slot.state == SlotState::Recorded) frames.push_back(slot.frame_index);
+		}
+	}
+	for (unsigned int frame_index : frames) retire_frame(frame_index);
+
+	_workers.wait_idle();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+#include <functional>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "workerPool.h"
+
+
+// Jedna pročitana slika - podaci vrijede samo za vrijeme poziva potrošača.
+// Pikseli su u obliku koji piše sjenčar: 4 komponente po pikselu obrnutim redoslijedom (b, g, r, 0),
+// bajtovi ili, kod float izlazne slike, 32-bitni floatovi
+struct ReadbackFrame {
+	const uint8_t* data;
+	uint32_t width;
+	uint32_t height;
+	size_t row_pitch;
+	bool is_float;
+
+	uint64_t frame_number;
+};
+
+
+// Asinkrono čitanje izlaznih slika s GPU-a.
+// Kopija u spremnik vidljiv procesoru snima se u naredbeni spremnik slike, a podaci se predaju potrošaču
+// (npr. zapisivaču datoteka) na pozadinskoj dretvi tek nakon što je ograda te slike pričekana u glavnoj petlji.
+// Glavna petlja zato nikada ne čeka na GPU zbog čitanja.
+class FrameReadback {
+
+public:
+	using Consumer = std::function<void(const ReadbackFrame&)>;
+
+	// slot_count mora biti veći od broja slika u letu, inače bi čekanje na slobodan spremnik moglo blokirati zauvijek
+	void init(VkDevice device, VmaAllocator allocator, unsigned int slot_count, unsigned int worker_count);
+	void cleanup();
+
+	// Snima kopiju slike (koja mora biti u VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) u slobodan spremnik.
+	// Podržani formati su VK_FORMAT_R8G8B8A8_UNORM i VK_FORMAT_R32G32B32A32_SFLOAT.
+	// frame_index je indeks slike u letu čija ograda označava kraj kopiranja.
+	// Ako nema slobodnog spremnika, ovisno o wait_for_slot ili se čeka ili se slika preskače (vraća false)
+	bool record_copy(VkCommandBuffer cmd, VkImage image, VkFormat format, VkExtent2D extent, unsigned int frame_index, uint64_t frame_number,
+		Consumer consumer, bool wait_for_slot);
+
+	// Poziva se nakon što je ograda slike frame_index pričekana - njezine kopije se predaju potrošačima
+	void retire_frame(unsigned int frame_index);
+
+	// Čeka da svi potrošači završe (GPU mora prije toga završiti sve kopije, npr. vkDeviceWaitIdle)
+	void flush();
+
+	uint64_t dropped_frames() const { return _dropped_frames; }
+	uint64_t completed_frames() const { return _completed_frames; }
+
+private:
+	enum class SlotState {
+		Free,
+		Recorded,	// Kopija je snimljena, čeka se ograda
+		Consuming	// Podaci su kod potrošača
+	};
+
+	struct Slot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		VkDeviceSize capacity = 0;
+
+		SlotState state = SlotState::Free;
+		unsigned int frame_index = 0;
+		ReadbackFrame frame = {};
+		Consumer consumer;
+	};
+
+	void ensure_capacity(Slot& slot, VkDeviceSize size);
+	void release_buffer(Slot& slot);
+
+	VkDevice _device = VK_NULL_HANDLE;
+	VmaAllocator _allocator = VK_NULL_HANDLE;
+
+	std::vector<Slot> _slots;
+
+	std::mutex _mutex;
+	std::condition_variable _slot_freed;
+
+	WorkerPool _workers;
+
+	std::atomic<uint64_t> _dropped_frames{ 0 };
+	std::atomic<uint64_t> _completed_frames{ 0 };
+};
@@ -0,0 +1,204 @@
+#include "gpuProfiler.h"
+
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+
+
+const char* GpuProfiler::stage_name(Stage stage){
+	switch (stage) {
+	case StageCompute: return "sjencar";
+	case StageCopy: return "kopiranje";
+	case StageGui: return "sucelje";
+	default: return "?";
+	}
+}
+
+static uint64_t timestamp_mask(uint32_t valid_bits){
+	if (valid_bits == 0) return 0;
+	return valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+}
+
+
+void GpuProfiler::init(VkDevice device, VkPhysicalDevice gpu, uint32_t compute_family, uint32_t graphics_family, unsigned int frames_in_flight,
+	bool pipeline_statistics){
+
+	_device = device;
+	_frames.assign(frames_in_flight, FrameQueries());
+
+	uint32_t family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> families(family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &family_count, families.data());
+
+	// Oznake različitih redova mogu imati različit broj valjanih bitova
+	_compute_mask = timestamp_mask(families[compute_family].timestampValidBits);
+	_graphics_mask = timestamp_mask(families[graphics_family].timestampValidBits);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(gpu, &properties);
+	_timestamp_period_ns = properties.limits.timestampPeriod;
+
+	if (_compute_mask != 0) {
+		VkQueryPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = frames_in_flight * StageCount * 2;
+
+		if (vkCreateQueryPool(_device, &poolInfo, nullptr, &_timestamp_pool) != VK_SUCCESS) _timestamp_pool = VK_NULL_HANDLE;
+	}
+	if (!_timestamp_pool) {
+		std::cout << "Komputacijski red ne podrzava vremenske oznake - trajanje faza na GPU-u se ne mjeri\n";
+	}
+
+	if (pipeline_statistics) {
+		VkQueryPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		poolInfo.queryCount = frames_in_flight;
+		poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+		if (vkCreateQueryPool(_device, &poolInfo, nullptr, &_statistics_pool) != VK_SUCCESS) _statistics_pool = VK_NULL_HANDLE;
+	}
+}
+
+void GpuProfiler::cleanup(){
+	if (_timestamp_pool) vkDestroyQueryPool(_device, _timestamp_pool, nullptr);
+	if (_statistics_pool) vkDestroyQueryPool(_device, _statistics_pool, nullptr);
+	_timestamp_pool = VK_NULL_HANDLE;
+	_statistics_pool = VK_NULL_HANDLE;
+}
+
+
+bool GpuProfiler::stage_supported(Stage stage) const{
+	if (!_timestamp_pool) return false;
+	return (stage == StageGui ? _graphics_mask : _compute_mask) != 0;
+}
+
+void GpuProfiler::begin_frame(unsigned int frame_index, uint64_t frame_number){
+	_frames[frame_index].frame_number = frame_number;
+	std::fill(std::begin(_frames[frame_index].stage_written), std::end(_frames[frame_index].stage_written), false);
+	_frames[frame_index].statistics_written = false;
+	_frames[frame_index].has_submit_time = false;
+}
+
+void GpuProfiler::mark_submit(unsigned int frame_index){
+	_frames[frame_index].has_submit_time = true;
+	_frames[frame_index].submit_time = std::chrono::steady_clock::now();
+}
+
+void GpuProfiler::begin_stage(VkCommandBuffer cmd, unsigned int frame_index, Stage stage, VkPipelineStageFlagBits start_stage){
+	if (!stage_supported(stage)) return;
+
+	uint32_t query = timestamp_query(frame_index, stage);
+	vkCmdResetQueryPool(cmd, _timestamp_pool, query, 2);
+	vkCmdWriteTimestamp(cmd, start_stage, _timestamp_pool, query);
+}
+
+void GpuProfiler::end_stage(VkCommandBuffer cmd, unsigned int frame_index, Stage stage){
+	if (!stage_supported(stage)) return;
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _timestamp_pool, timestamp_query(frame_index, stage) + 1);
+	_frames[frame_index].stage_written[stage] = true;
+}
+
+void GpuProfiler::begin_statistics(VkCommandBuffer cmd, unsigned int frame_index){
+	if (!_statistics_pool) return;
+
+	vkCmdResetQueryPool(cmd, _statistics_pool, frame_index, 1);
+	vkCmdBeginQuery(cmd, _statistics_pool, frame_index, 0);
+}
+
+void GpuProfiler::end_statistics(VkCommandBuffer cmd, unsigned int frame_index){
+	if (!_statistics_pool) return;
+
+	vkCmdEndQuery(cmd, _statistics_pool, frame_index);
+	_frames[frame_index].statistics_written = true;
+}
+
+
+bool GpuProfiler::collect(unsigned int frame_index){
+
+	FrameQueries& queries = _frames[frame_index];
+	bool any_written = std::find(std::begin(queries.stage_written), std::end(queries.stage_written), true) != std::end(queries.stage_written);
+	if (!any_written && !queries.statistics_written) return false;
+
+	FrameTimes times;
+	times.frame_number = queries.frame_number;
+	times.has_submit_time = queries.has_submit_time;
+	times.cpu_submit_time = queries.submit_time;
+
+	// Bez VK_QUERY_RESULT_WAIT_BIT - ograde su pričekane, a ako rezultat ipak nije spreman, slika se preskače
+	bool any_stage = false;
+	for (int stage = 0; stage < StageCount; stage++) {
+		if (!queries.stage_written[stage]) continue;
+
+		uint64_t timestamps[2];
+		VkResult result = vkGetQueryPoolResults(_device, _timestamp_pool, timestamp_query(frame_index, (Stage)stage), 2,
+			sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS) continue;
+
+		// Bitovi iznad timestampValidBits su nedefinirani, pa se uklanjaju prije računanja
+		uint64_t mask = stage == StageGui ? _graphics_mask : _compute_mask;
+		uint64_t begin = timestamps[0] & mask;
+		uint64_t end = timestamps[1] & mask;
+		times.stage_ms[stage] = ((end - begin) & mask) * _timestamp_period_ns / 1e6;
+		times.stage_valid[stage] = true;
+		times.stage_begin_ns[stage] = begin * _timestamp_period_ns;
+		times.stage_end_ns[stage] = times.stage_begin_ns[stage] + times.stage_ms[stage] * 1e6;
+
+		times.total_ms += times.stage_ms[stage];
+		any_stage = true;
+	}
+
+	if (queries.statistics_written) {
+		uint64_t invocations = 0;
+		if (vkGetQueryPoolResults(_device, _statistics_pool, frame_index, 1, sizeof(invocations), &invocations, sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+			times.has_statistics = true;
+			times.compute_invocations = invocations;
+		}
+	}
+
+	std::fill(std::begin(queries.stage_written), std::end(queries.stage_written), false);
+	queries.statistics_written = false;
+
+	if (!any_stage && !times.has_statistics) return false;
+
+	_last_frame = times;
+	{
+		std::lock_guard<std::mutex> lock(_history_mutex);
+		_history.push_back(times);
+		if (_history.size() > _history_size) _history.pop_front();
+	}
+	if (_recording) _recorded.push_back(times);
+
+	return true;
+}
+
+
+GpuProfiler::Stats GpuProfiler::get_stats() const{
+	Stats stats;
+	std::lock_guard<std::mutex> lock(_history_mutex);
+	if (_history.empty()) return stats;
+
+	for (const FrameTimes& times : _history) {
+		for (int stage = 0; stage < StageCount; stage++) stats.stage_ms[stage] += times.stage_ms[stage];
+		stats.total_ms += times.total_ms;
+		stats.total_max_ms = std::max(stats.total_max_ms, times.total_ms);
+		stats.compute_invocations += times.compute_invocations;
+	}
+
+	double count = (double)_history.size();
+	for (int stage = 0; stage < StageCount; stage++) stats.stage_ms[stage] /= count;
+	stats.total_ms /= count;
+	stats.compute_invocations = (uint64_t)(stats.compute_invocations / count);
+	stats.sample_count = (unsigned int)_history.size();
+	return stats;
+}
+
+std::vector<GpuProfiler::FrameTimes> GpuProfiler::take_recorded(){
+	std::vector<FrameTimes> recorded;
+	recorded.swap(_recorded);
+	return recorded;
+}
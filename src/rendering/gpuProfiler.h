@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <mutex>
+
+
+// Mjerenje trajanja faza slike na GPU-u vremenskim oznakama, te broja poziva komputacijskog sjenčara
+// upitom statistike protočnog sustava (ako ga uređaj podržava).
+// Svaka slika u letu ima svoje upite. Rezultati se čitaju tek nakon što je ograda slike pričekana, pa čitanje
+// nikada ne čeka GPU - podaci kasne jednu do dvije slike
+class GpuProfiler {
+
+public:
+	enum Stage {
+		StageCompute,	// Komputacijski sjenčar
+		StageCopy,		// Kopiranje izlazne slike u swapchain i spremnike za čitanje
+		StageGui,		// Iscrtavanje sučelja
+		StageCount
+	};
+
+	static const char* stage_name(Stage stage);
+
+	// Rezultati jedne slike. Faza koja nije snimljena (npr. sučelje bez prozora) ima trajanje 0
+	struct FrameTimes {
+		uint64_t frame_number = 0;
+		double stage_ms[StageCount] = {};
+		bool stage_valid[StageCount] = {};
+
+		// Zbroj trajanja snimljenih faza. Oznake dvaju redova ne mogu se međusobno oduzimati, a čekanje između
+		// redova ionako nije posao GPU-a
+		double total_ms = 0;
+
+		// Početak i kraj faza na satu GPU-a (ns) i vrijeme slanja slike na procesoru - za povezivanje s tragom izvođenja
+		double stage_begin_ns[StageCount] = {};
+		double stage_end_ns[StageCount] = {};
+		bool has_submit_time = false;
+		std::chrono::steady_clock::time_point cpu_submit_time;
+
+		bool has_statistics = false;
+		uint64_t compute_invocations = 0;
+	};
+
+	struct Stats {
+		double stage_ms[StageCount] = {};
+		double total_ms = 0;
+		double total_max_ms = 0;
+		uint64_t compute_invocations = 0;
+		unsigned int sample_count = 0;
+	};
+
+	// Redovi bez valjanih bitova vremenskih oznaka se ne mjere. pipeline_statistics - je li na uređaju
+	// uključena značajka pipelineStatisticsQuery
+	void init(VkDevice device, VkPhysicalDevice gpu, uint32_t compute_family, uint32_t graphics_family, unsigned int frames_in_flight,
+		bool pipeline_statistics);
+	void cleanup();
+
+	bool timestamps_supported() const { return _timestamp_pool != VK_NULL_HANDLE; }
+	bool statistics_supported() const { return _statistics_pool != VK_NULL_HANDLE; }
+
+	// Poziva se na početku snimanja prve naredbe slike
+	void begin_frame(unsigned int frame_index, uint64_t frame_number);
+
+	// Faza se mora snimiti u naredbeni spremnik reda navedenog u init(): sučelje u grafički, ostalo u komputacijski.
+	// Ne smije se pozivati unutar prolaza iscrtavanja. start_stage - faza protočnog sustava na kojoj se zapisuje
+	// početna oznaka; faza koja čeka semafor ili barijeru treba početi tek iza tog čekanja, inače ga ubraja u svoje trajanje
+	void begin_stage(VkCommandBuffer cmd, unsigned int frame_index, Stage stage, VkPipelineStageFlagBits start_stage);
+	void end_stage(VkCommandBuffer cmd, unsigned int frame_index, Stage stage);
+
+	// Poziva se neposredno prije slanja naredbi slike na GPU
+	void mark_submit(unsigned int frame_index);
+
+	// Broj poziva komputacijskog sjenčara između begin i end (komputacijski red)
+	void begin_statistics(VkCommandBuffer cmd, unsigned int frame_index);
+	void end_statistics(VkCommandBuffer cmd, unsigned int frame_index);
+
+	// Poziva se nakon što su pričekane sve ograde slike. Vraća false ako za sliku nema rezultata
+	bool collect(unsigned int frame_index);
+
+	const FrameTimes& last_frame() const { return _last_frame; }
+
+	// Prosjek zadnjih nekoliko slika. Smije se pozivati s bilo koje dretve (ploča s performansama gradi se na glavnoj
+	// dretvi, a collect() poziva dretva iscrtavanja)
+	Stats get_stats() const;
+
+	// Dok je uključeno, rezultati svih slika se spremaju (npr. za mjerenje brzine) - take_recorded() ih predaje i briše
+	void set_recording(bool recording) { _recording = recording; }
+	std::vector<FrameTimes> take_recorded();
+
+private:
+	struct FrameQueries {
+		uint64_t frame_number = 0;
+		// Faze se snimaju na različitim dretvama, pa svaka ima svoju zastavicu umjesto zajedničkog bita
+		bool stage_written[StageCount] = {};
+		bool statistics_written = false;
+		bool has_submit_time = false;
+		std::chrono::steady_clock::time_point submit_time;
+	};
+
+	uint32_t timestamp_query(unsigned int frame_index, Stage stage) const { return (frame_index * StageCount + stage) * 2; }
+	bool stage_supported(Stage stage) const;
+
+	VkDevice _device = VK_NULL_HANDLE;
+	VkQueryPool _timestamp_pool = VK_NULL_HANDLE;
+	VkQueryPool _statistics_pool = VK_NULL_HANDLE;
+
+	double _timestamp_period_ns = 1.0;
+	uint64_t _compute_mask = 0;
+	uint64_t _graphics_mask = 0;
+
+	std::vector<FrameQueries> _frames;
+
+	FrameTimes _last_frame;
+
+	static const unsigned int _history_size = 120;
+	mutable std::mutex _history_mutex;
+	std::deque<FrameTimes> _history;
+
+	bool _recording = false;
+	std::vector<FrameTimes> _recorded;
+};
@@ -0,0 +1,379 @@
+#include "imageWriters.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+#ifdef SIMULACIJA_ZLIB
+#include <zlib.h>
+#endif
+
+
+ImageFileFormat image_format_from_path(const std::string& path){
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos) return ImageFileFormat::PPM;
+
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+	if (extension == "png") return ImageFileFormat::PNG;
+	if (extension == "pfm") return ImageFileFormat::PFM;
+	if (extension == "exr") return ImageFileFormat::EXR;
+	return ImageFileFormat::PPM;
+}
+
+bool image_format_is_float(ImageFileFormat format){
+	return format == ImageFileFormat::PFM || format == ImageFileFormat::EXR;
+}
+
+
+// Pomoćne funkcije za binarne formate
+
+static void put_u32_be(std::vector<uint8_t>& out, uint32_t value){
+	out.push_back((uint8_t)(value >> 24));
+	out.push_back((uint8_t)(value >> 16));
+	out.push_back((uint8_t)(value >> 8));
+	out.push_back((uint8_t)value);
+}
+
+// OpenEXR je uvijek little-endian, kao i svi procesori na kojima se program pokreće
+template<typename T>
+static void write_le(std::ofstream& file, T value){
+	file.write((const char*)&value, sizeof(T));
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size){
+	static uint32_t table[256];
+	static bool table_ready = [](){
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		return true;
+	}();
+	(void)table_ready;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+
+// PPM - P6, 8 bita po komponenti
+class PpmWriter : public ImageWriter {
+public:
+	bool wants_float() const override { return false; }
+
+	bool write_row(uint32_t y, const void* rgb) override {
+		_file.write((const char*)rgb, (std::streamsize)_width * 3);
+		return (bool)_file;
+	}
+
+protected:
+	bool write_header() override {
+		_file << "P6\n" << _width << " " << _height << "\n255\n";
+		return (bool)_file;
+	}
+};
+
+
+// PFM - float RGB, redovi odozdo prema gore, negativna skala označava little-endian
+class PfmWriter : public ImageWriter {
+public:
+	bool wants_float() const override { return true; }
+	bool bottom_up() const override { return true; }
+
+	bool write_row(uint32_t y, const void* rgb) override {
+		_file.write((const char*)rgb, (std::streamsize)_width * 3 * sizeof(float));
+		return (bool)_file;
+	}
+
+protected:
+	bool write_header() override {
+		_file << "PF\n" << _width << " " << _height << "\n-1.0\n";
+		return (bool)_file;
+	}
+};
+
+
+// OpenEXR bez sažimanja - svaki red je zaseban blok, a kanali unutar bloka slijede abecedno (B, G, R)
+class ExrWriter : public ImageWriter {
+public:
+	bool wants_float() const override { return true; }
+
+	bool write_row(uint32_t y, const void* rgb) override {
+		const float* pixels = (const float*)rgb;
+
+		write_le<int32_t>(_file, (int32_t)y);
+		write_le<int32_t>(_file, (int32_t)(_width * 3 * sizeof(float)));
+
+		_channel.resize(_width);
+		for (int channel = 2; channel >= 0; channel--) {
+			for (uint32_t x = 0; x < _width; x++) _channel[x] = pixels[x * 3 + channel];
+			_file.write((const char*)_channel.data(), (std::streamsize)_width * sizeof(float));
+		}
+		return (bool)_file;
+	}
+
+protected:
+	bool write_header() override {
+		write_le<uint32_t>(_file, 20000630);	// Magični broj
+		write_le<uint32_t>(_file, 2);			// Verzija 2, slika po redovima
+
+		auto attribute = [this](const char* name, const char* type, uint32_t size) {
+			_file.write(name, strlen(name) + 1);
+			_file.write(type, strlen(type) + 1);
+			write_le<uint32_t>(_file, size);
+		};
+
+		attribute("channels", "chlist", 3 * 18 + 1);
+		for (const char* channel : { "B", "G", "R" }) {
+			_file.write(channel, 2);
+			write_le<int32_t>(_file, 2);	// FLOAT
+			write_le<uint32_t>(_file, 0);	// pLinear i rezervirani bajtovi
+			write_le<int32_t>(_file, 1);	// xSampling
+			write_le<int32_t>(_file, 1);	// ySampling
+		}
+		_file.put(0);
+
+		attribute("compression", "compression", 1);
+		_file.put(0);	// NO_COMPRESSION
+
+		for (const char* window : { "dataWindow", "displayWindow" }) {
+			attribute(window, "box2i", 16);
+			write_le<int32_t>(_file, 0);
+			write_le<int32_t>(_file, 0);
+			write_le<int32_t>(_file, (int32_t)_width - 1);
+			write_le<int32_t>(_file, (int32_t)_height - 1);
+		}
+
+		attribute("lineOrder", "lineOrder", 1);
+		_file.put(0);	// INCREASING_Y
+
+		attribute("pixelAspectRatio", "float", 4);
+		write_le<float>(_file, 1.0f);
+
+		attribute("screenWindowCenter", "v2f", 8);
+		write_le<float>(_file, 0.0f);
+		write_le<float>(_file, 0.0f);
+
+		attribute("screenWindowWidth", "float", 4);
+		write_le<float>(_file, 1.0f);
+
+		_file.put(0);	// Kraj zaglavlja
+
+		// Svi blokovi su jednake veličine, pa se tablica pomaka može zapisati unaprijed
+		uint64_t block_size = 8 + (uint64_t)_width * 3 * sizeof(float);
+		uint64_t offset = (uint64_t)_file.tellp() + (uint64_t)_height * sizeof(uint64_t);
+		for (uint32_t y = 0; y < _height; y++) {
+			write_le<uint64_t>(_file, offset + y * block_size);
+		}
+		return (bool)_file;
+	}
+
+private:
+	std::vector<float> _channel;
+};
+
+
+// PNG - RGB, 8 bita, bez filtara. Svaki red se sažima čim stigne i odmah zapisuje u IDAT blok.
+// Bez zliba podaci se zapisuju kao nesažeti deflate blokovi, što je i dalje ispravan PNG
+class PngWriter : public ImageWriter {
+public:
+	~PngWriter() override {
+#ifdef SIMULACIJA_ZLIB
+		if (_stream_ready) deflateEnd(&_stream);
+#endif
+	}
+
+	bool wants_float() const override { return false; }
+
+	bool write_row(uint32_t y, const void* rgb) override {
+		_row.resize(1 + (size_t)_width * 3);
+		_row[0] = 0;	// Filtar "None"
+		memcpy(_row.data() + 1, rgb, (size_t)_width * 3);
+
+#ifdef SIMULACIJA_ZLIB
+		return deflate_data(_row.data(), _row.size(), Z_NO_FLUSH);
+#else
+		// Nesažeti deflate blok može imati najviše 65535 bajtova
+		_chunk.clear();
+		for (size_t start = 0; start < _row.size(); start += 65535) {
+			uint16_t length = (uint16_t)std::min<size_t>(65535, _row.size() - start);
+			_chunk.push_back(0);	// BFINAL = 0, BTYPE = 00
+			_chunk.push_back((uint8_t)length);
+			_chunk.push_back((uint8_t)(length >> 8));
+			_chunk.push_back((uint8_t)~length);
+			_chunk.push_back((uint8_t)(~length >> 8));
+			_chunk.insert(_chunk.end(), _row.begin() + start, _row.begin() + start + length);
+		}
+		update_adler(_row.data(), _row.size());
+		return write_chunk("IDAT", _chunk);
+#endif
+	}
+
+protected:
+	bool write_header() override {
+		static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		_file.write((const char*)signature, 8);
+
+		std::vector<uint8_t> header;
+		put_u32_be(header, _width);
+		put_u32_be(header, _height);
+		header.push_back(8);	// Bitova po komponenti
+		header.push_back(2);	// RGB
+		header.push_back(0);	// Deflate
+		header.push_back(0);	// Standardni filtri
+		header.push_back(0);	// Bez preplitanja
+		if (!write_chunk("IHDR", header)) return false;
+
+#ifdef SIMULACIJA_ZLIB
+		memset(&_stream, 0, sizeof(_stream));
+		// Razina 1 - kod dugih snimki brzina je važnija od veličine datoteke
+		if (deflateInit(&_stream, 1) != Z_OK) return false;
+		_stream_ready = true;
+		return true;
+#else
+		// Zaglavlje zlib toka (deflate, bez sažimanja) - IDAT blokovi se čitaju kao jedan neprekinuti tok
+		return write_chunk("IDAT", { 0x78, 0x01 });
+#endif
+	}
+
+	bool write_footer() override {
+#ifdef SIMULACIJA_ZLIB
+		if (!deflate_data(nullptr, 0, Z_FINISH)) return false;
+#else
+		// Prazan završni blok i Adler-32 zbroj nesažetih podataka
+		_chunk = { 1, 0x00, 0x00, 0xff, 0xff };
+		put_u32_be(_chunk, (_adler_b << 16) | _adler_a);
+		if (!write_chunk("IDAT", _chunk)) return false;
+#endif
+		return write_chunk("IEND", {});
+	}
+
+private:
+	bool write_chunk(const char* type, const std::vector<uint8_t>& data){
+		std::vector<uint8_t> length;
+		put_u32_be(length, (uint32_t)data.size());
+		_file.write((const char*)length.data(), 4);
+		_file.write(type, 4);
+		if (!data.empty()) _file.write((const char*)data.data(), data.size());
+
+		uint32_t crc = crc32_update(0, (const uint8_t*)type, 4);
+		crc = crc32_update(crc, data.data(), data.size());
+		std::vector<uint8_t> crc_bytes;
+		put_u32_be(crc_bytes, crc);
+		_file.write((const char*)crc_bytes.data(), 4);
+
+		return (bool)_file;
+	}
+
+#ifdef SIMULACIJA_ZLIB
+	bool deflate_data(const uint8_t* data, size_t size, int flush){
+		_stream.next_in = (Bytef*)data;
+		_stream.avail_in = (uInt)size;
+
+		int status;
+		do {
+			_chunk.resize(1 << 16);
+			_stream.next_out = _chunk.data();
+			_stream.avail_out = (uInt)_chunk.size();
+
+			status = deflate(&_stream, flush);
+			if (status == Z_STREAM_ERROR) return false;
+
+			_chunk.resize(_chunk.size() - _stream.avail_out);
+			if (!_chunk.empty() && !write_chunk("IDAT", _chunk)) return false;
+		} while (_stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+		return true;
+	}
+
+	z_stream _stream;
+	bool _stream_ready = false;
+#else
+	void update_adler(const uint8_t* data, size_t size){
+		for (size_t i = 0; i < size; i++) {
+			_adler_a = (_adler_a + data[i]) % 65521;
+			_adler_b = (_adler_b + _adler_a) % 65521;
+		}
+	}
+
+	uint32_t _adler_a = 1;
+	uint32_t _adler_b = 0;
+#endif
+
+	std::vector<uint8_t> _row;
+	std::vector<uint8_t> _chunk;
+};
+
+
+std::unique_ptr<ImageWriter> ImageWriter::create(ImageFileFormat format){
+	switch (format) {
+	case ImageFileFormat::PNG: return std::make_unique<PngWriter>();
+	case ImageFileFormat::PFM: return std::make_unique<PfmWriter>();
+	case ImageFileFormat::EXR: return std::make_unique<ExrWriter>();
+	default: return std::make_unique<PpmWriter>();
+	}
+}
+
+bool ImageWriter::open(const std::string& path, uint32_t width, uint32_t height){
+	_width = width;
+	_height = height;
+
+	_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!_file.is_open()) return false;
+
+	return write_header();
+}
+
+bool ImageWriter::finish(){
+	bool success = write_footer();
+	_file.close();
+	return success && !_file.fail();
+}
+
+
+bool write_image(const std::string& path, ImageFileFormat format, const ImageSource& source){
+
+	std::unique_ptr<ImageWriter> writer = ImageWriter::create(format);
+	if (!writer->open(path, source.width, source.height)) return false;
+
+	int r = source.swap_red_blue ? 2 : 0;
+	int b = source.swap_red_blue ? 0 : 2;
+	bool wants_float = writer->wants_float();
+
+	// Samo jedan red u izlaznom obliku - ostatak slike se čita izravno iz izvora
+	std::vector<float> float_row(wants_float ? (size_t)source.width * 3 : 0);
+	std::vector<uint8_t> byte_row(wants_float ? 0 : (size_t)source.width * 3);
+
+	for (uint32_t i = 0; i < source.height; i++) {
+		uint32_t y = writer->bottom_up() ? source.height - 1 - i : i;
+		const uint8_t* src = source.data + y * source.row_pitch;
+
+		if (source.is_float) {
+			const float* pixels = (const float*)src;
+			for (uint32_t x = 0; x < source.width; x++) {
+				float rgb[3] = { pixels[x * 4 + r], pixels[x * 4 + 1], pixels[x * 4 + b] };
+				for (int c = 0; c < 3; c++) {
+					if (wants_float) float_row[x * 3 + c] = rgb[c];
+					else byte_row[x * 3 + c] = (uint8_t)(std::min(std::max(rgb[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+				}
+			}
+		}
+		else {
+			for (uint32_t x = 0; x < source.width; x++) {
+				uint8_t rgb[3] = { src[x * 4 + r], src[x * 4 + 1], src[x * 4 + b] };
+				for (int c = 0; c < 3; c++) {
+					if (wants_float) float_row[x * 3 + c] = rgb[c] / 255.0f;
+					else byte_row[x * 3 + c] = rgb[c];
+				}
+			}
+		}
+
+		if (!writer->write_row(y, wants_float ? (const void*)float_row.data() : (const void*)byte_row.data())) return false;
+	}
+
+	return writer->finish();
+}
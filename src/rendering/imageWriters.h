@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+
+enum class ImageFileFormat {
+	PPM,	// 8 bita po komponenti, bez sažimanja
+	PNG,	// 8 bita po komponenti, sažimanje zlibom ako je dostupan
+	PFM,	// Linearni float podaci
+	EXR		// Linearni float podaci, nesažeti OpenEXR s jednim redom po bloku
+};
+
+// Format se određuje po ekstenziji datoteke, nepoznate ekstenzije daju PPM
+ImageFileFormat image_format_from_path(const std::string& path);
+
+// Treba li format linearne float podatke (inače se podaci pretvaraju u 8 bita)
+bool image_format_is_float(ImageFileFormat format);
+
+
+// Izvor piksela - slika u obliku u kojem je pročitana s GPU-a
+struct ImageSource {
+	const uint8_t* data;
+	uint32_t width;
+	uint32_t height;
+	size_t row_pitch;
+
+	bool is_float;			// 4 floata po pikselu, inače 4 bajta
+	bool swap_red_blue;		// Sjenčar piše komponente obrnutim redoslijedom (b, g, r)
+};
+
+
+// Zapisivač koji sliku piše red po red, tako da cijela slika nikada ne mora biti u memoriji u izlaznom obliku.
+// Redovi se predaju redoslijedom koji vraća bottom_up(), jer neki formati (PFM) spremaju redove odozdo prema gore
+class ImageWriter {
+
+public:
+	static std::unique_ptr<ImageWriter> create(ImageFileFormat format);
+
+	virtual ~ImageWriter() = default;
+
+	bool open(const std::string& path, uint32_t width, uint32_t height);
+
+	// Jedan red RGB piksela - float ako je wants_float(), inače uint8_t
+	virtual bool write_row(uint32_t y, const void* rgb) = 0;
+
+	// Zatvara datoteku, vraća false ako je bilo koje pisanje bilo neuspješno
+	bool finish();
+
+	virtual bool wants_float() const = 0;
+	virtual bool bottom_up() const { return false; }
+
+protected:
+	virtual bool write_header() = 0;
+	virtual bool write_footer() { return true; }
+
+	std::ofstream _file;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+};
+
+
+// Zapisuje cijeli izvor u datoteku, red po red
+bool write_image(const std::string& path, ImageFileFormat format, const ImageSource& source);
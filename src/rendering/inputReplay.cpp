@@ -0,0 +1,182 @@
+#include "inputReplay.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+
+static const char replay_magic[8] = { 'S', 'I', 'M', 'U', 'N', 'O', 'S', '1' };
+
+
+static void write_varint(std::vector<uint8_t>& out, uint64_t value){
+	while (value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static bool read_varint(const std::vector<uint8_t>& data, size_t& position, uint64_t& value){
+	value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (position >= data.size()) return false;
+		uint8_t byte = data[position++];
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+
+bool InputRecorder::start(const std::string& path, const std::vector<ReplayField>& fields){
+
+	stop();
+
+	_file.open(path, std::ios::binary);
+	if (!_file) return false;
+
+	_fields = fields;
+	_previous.clear();
+	_frame_count = 0;
+
+	std::vector<uint8_t> header(replay_magic, replay_magic + sizeof(replay_magic));
+	uint32_t field_count = (uint32_t)_fields.size();
+	for (int i = 0; i < 4; i++) header.push_back((uint8_t)(field_count >> (i * 8)));
+	for (const ReplayField& field : _fields) header.push_back(field.size);
+
+	for (const ReplayField& field : _fields) {
+		const uint8_t* bytes = (const uint8_t*)field.data;
+		_previous.insert(_previous.end(), bytes, bytes + field.size);
+	}
+	header.insert(header.end(), _previous.begin(), _previous.end());
+
+	_file.write((const char*)header.data(), header.size());
+	return (bool)_file;
+}
+
+void InputRecorder::stop(){
+	if (_file.is_open()) _file.close();
+}
+
+void InputRecorder::record_frame(double frame_dt){
+	if (!active()) return;
+
+	uint64_t dt_us = (uint64_t)std::max(frame_dt * 1e6 + 0.5, 0.0);
+
+	_record.clear();
+	write_varint(_record, dt_us);
+	size_t count_position = _record.size();
+	_record.push_back(0);
+
+	uint8_t changed = 0;
+	size_t offset = 0;
+	for (size_t i = 0; i < _fields.size(); i++) {
+		const ReplayField& field = _fields[i];
+		const uint8_t* bytes = (const uint8_t*)field.data;
+
+		if (field.group != ReplayGroup::Start && std::memcmp(&_previous[offset], bytes, field.size) != 0) {
+			std::memcpy(&_previous[offset], bytes, field.size);
+			_record.push_back((uint8_t)i);
+			_record.insert(_record.end(), bytes, bytes + field.size);
+			changed++;
+		}
+		offset += field.size;
+	}
+	_record[count_position] = changed;
+
+	_file.write((const char*)_record.data(), _record.size());
+	_frame_count++;
+}
+
+
+bool InputPlayer::load(const std::string& path, const std::vector<ReplayField>& fields, std::string& error){
+
+	_loaded = false;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		error = "Snimka '" + path + "' ne postoji";
+		return false;
+	}
+	_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	size_t header_size = sizeof(replay_magic) + 4 + fields.size();
+	if (_data.size() < header_size || std::memcmp(_data.data(), replay_magic, sizeof(replay_magic)) != 0) {
+		error = "'" + path + "' nije snimka unosa";
+		return false;
+	}
+
+	uint32_t field_count = 0;
+	for (int i = 0; i < 4; i++) field_count |= (uint32_t)_data[sizeof(replay_magic) + i] << (i * 8);
+
+	// Snimka starije verzije programa s drugačijim skupom parametara ne može se ponoviti
+	bool fields_match = field_count == fields.size();
+	for (size_t i = 0; fields_match && i < fields.size(); i++) {
+		fields_match = _data[sizeof(replay_magic) + 4 + i] == fields[i].size;
+	}
+	if (!fields_match) {
+		error = "Parametri snimke '" + path + "' ne odgovaraju ovoj verziji programa";
+		return false;
+	}
+
+	_fields = fields;
+	_offsets.clear();
+	size_t state_size = 0;
+	for (const ReplayField& field : _fields) {
+		_offsets.push_back(state_size);
+		state_size += field.size;
+	}
+
+	if (_data.size() < header_size + state_size) {
+		error = "Snimka '" + path + "' je ostecena";
+		return false;
+	}
+	_state.assign(_data.begin() + header_size, _data.begin() + header_size + state_size);
+	_position = header_size + state_size;
+
+	_frame_dt = 0;
+	_frame_index = 0;
+	_error.clear();
+	_loaded = true;
+
+	apply(ReplayGroup::Start);
+	apply(ReplayGroup::Input);
+	apply(ReplayGroup::Parameter);
+	return true;
+}
+
+bool InputPlayer::next_frame(){
+	if (!_loaded || _position >= _data.size()) return false;
+
+	uint64_t dt_us;
+	if (!read_varint(_data, _position, dt_us) || _position >= _data.size()) {
+		_error = "Snimka je ostecena";
+		return false;
+	}
+
+	uint8_t changed = _data[_position++];
+	for (uint8_t i = 0; i < changed; i++) {
+		if (_position >= _data.size() || _data[_position] >= _fields.size()) {
+			_error = "Snimka je ostecena";
+			return false;
+		}
+
+		size_t field = _data[_position++];
+		if (_position + _fields[field].size > _data.size()) {
+			_error = "Snimka je ostecena";
+			return false;
+		}
+		std::memcpy(&_state[_offsets[field]], &_data[_position], _fields[field].size);
+		_position += _fields[field].size;
+	}
+
+	_frame_dt = dt_us / 1e6;
+	_frame_index++;
+	return true;
+}
+
+void InputPlayer::apply(ReplayGroup group) const{
+	for (size_t i = 0; i < _fields.size(); i++) {
+		if (_fields[i].group == group) std::memcpy(_fields[i].data, &_state[_offsets[i]], _fields[i].size);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+// Snimanje i ponavljanje interaktivne sesije. Za svaku sliku zapisuje se stanje unosa (kretanje kamere i sunca)
+// i svi parametri iz sučelja, pa se ista sesija može ponoviti na drugoj verziji programa i usporediti trajanje slika.
+// Pri ponavljanju N-ta slika dobiva točno stanje N-te snimljene slike i isto trajanje slike za simulaciju, pa put
+// kamere ne ovisi o brzini iscrtavanja.
+//
+// Format datoteke (little endian):
+//   zaglavlje: "SIMUNOS1", broj polja (u32), veličina svakog polja (u8), početne vrijednosti svih polja
+//   slika:     trajanje slike tijekom snimanja u µs (varint), broj promijenjenih polja (u8),
+//              te za svako promijenjeno polje njegov indeks (u8) i novu vrijednost
+// Zapisuju se samo promjene, pa slika bez unosa zauzima dva bajta
+
+enum class ReplayGroup {
+	Start,		// Zapisuje se samo u zaglavlju (npr. položaj kamere na početku snimanja)
+	Input,		// Stanje unosa - primjenjuje se prije pomicanja kamere
+	Parameter	// Parametri iz sučelja - primjenjuju se nakon izgradnje sučelja
+};
+
+// Polje koje se snima, npr. { &sun.angle, sizeof(float), ReplayGroup::Parameter }.
+// Redoslijed polja mora biti isti pri snimanju i ponavljanju
+struct ReplayField {
+	void* data;
+	uint8_t size;
+	ReplayGroup group;
+};
+
+
+class InputRecorder {
+
+public:
+	bool start(const std::string& path, const std::vector<ReplayField>& fields);
+	void stop();
+
+	bool active() const { return _file.is_open(); }
+	uint64_t frame_count() const { return _frame_count; }
+
+	// Poziva se jednom po slici, nakon što su unos i sučelje obrađeni. frame_dt - trajanje slike koje je dobila simulacija (s)
+	void record_frame(double frame_dt);
+
+private:
+	std::vector<ReplayField> _fields;
+	std::vector<uint8_t> _previous;		// Vrijednosti zapisane u prošloj slici, redom polja
+	std::vector<uint8_t> _record;
+
+	std::ofstream _file;
+	uint64_t _frame_count = 0;
+};
+
+
+class InputPlayer {
+
+public:
+	// Učitava cijelu snimku i primjenjuje početno stanje svih polja
+	bool load(const std::string& path, const std::vector<ReplayField>& fields, std::string& error);
+
+	bool active() const { return _loaded; }
+
+	// Prelazi na sljedeću snimljenu sliku. Vraća false kada je snimka gotova (ili oštećena - vidi error())
+	bool next_frame();
+
+	// Upisuje stanje trenutne slike u polja zadane skupine
+	void apply(ReplayGroup group) const;
+
+	// Trajanje trenutne slike tijekom snimanja (s)
+	double recorded_dt() const { return _frame_dt; }
+
+	uint64_t frame_index() const { return _frame_index; }
+	const std::string& error() const { return _error; }
+
+private:
+	std::vector<ReplayField> _fields;
+	std::vector<size_t> _offsets;
+	std::vector<uint8_t> _state;
+
+	std::vector<uint8_t> _data;
+	size_t _position = 0;
+
+	bool _loaded = false;
+	double _frame_dt = 0;
+	uint64_t _frame_index = 0;
+	std::string _error;
+};
@@ -0,0 +1,183 @@
+#include "latencyTracker.h"
+#include "traceRecorder.h"
+
+#include <algorithm>
+
+
+static double to_ms(LatencyTracker::Clock::duration d){
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+
+void LatencyTracker::init(VkDevice device, PFN_vkWaitForPresentKHR wait_for_present){
+	_device = device;
+	_wait_for_present = wait_for_present;
+
+	// Dretva za čekanje prikaza pokreće se samo ako ju je moguće koristiti
+	if (_wait_for_present){
+		_running = true;
+		_worker = std::thread(&LatencyTracker::worker_loop, this);
+	}
+}
+
+void LatencyTracker::cleanup(){
+	if (_running){
+		_running = false;
+		_queue_cv.notify_all();
+		_worker.join();
+	}
+
+	std::lock_guard<std::mutex> lock(_queue_mutex);
+	_pending.clear();
+}
+
+
+void LatencyTracker::mark_input(uint32_t sdl_timestamp, uint32_t sdl_now){
+	// Bitan je samo najraniji unos koji čeka na sljedeću sliku
+	if (_has_pending_input) return;
+
+	// SDL vremenska oznaka događaja pretvara se u steady_clock kako bi se uračunalo i vrijeme čekanja u redu događaja
+	uint32_t age = (sdl_now >= sdl_timestamp) ? sdl_now - sdl_timestamp : 0;
+
+	_has_pending_input = true;
+	_pending_input_time = Clock::now() - std::chrono::milliseconds(age);
+}
+
+LatencyTracker::FrameMark LatencyTracker::take_input(){
+	FrameMark mark;
+	mark.has_input = _has_pending_input;
+	mark.input_time = _pending_input_time;
+
+	_has_pending_input = false;
+	return mark;
+}
+
+LatencyTracker::FrameMark LatencyTracker::mark_submit(FrameMark mark){
+	mark.submit_time = Clock::now();
+
+	if (mark.has_input){
+		std::lock_guard<std::mutex> lock(_stats_mutex);
+		_input_to_submit_samples.push_back(to_ms(mark.submit_time - mark.input_time));
+		if (_input_to_submit_samples.size() > _sample_window) _input_to_submit_samples.pop_front();
+	}
+
+	return mark;
+}
+
+uint64_t LatencyTracker::next_present_id(){
+	if (!_wait_for_present) return 0;
+	return ++_present_id_counter;
+}
+
+void LatencyTracker::mark_present(VkSwapchainKHR swapchain, uint64_t present_id, const FrameMark& mark){
+	if (!_wait_for_present || present_id == 0) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_queue_mutex);
+		_pending.push_back({ swapchain, present_id, mark });
+
+		// Ako se prikaz zaglavi, ne skupljaju se beskonačno stari zahtjevi
+		while (_pending.size() > 16) _pending.pop_front();
+	}
+	_queue_cv.notify_one();
+}
+
+void LatencyTracker::reset_swapchain(){
+	// Redoslijed zaključavanja (swapchain pa red) jednak je onom u pozadinskoj dretvi
+	std::lock_guard<std::mutex> swapchain_lock(_swapchain_mutex);
+	std::lock_guard<std::mutex> queue_lock(_queue_mutex);
+	_pending.clear();
+}
+
+
+void LatencyTracker::worker_loop(){
+
+	TraceRecorder::instance().set_thread_name("mjerenje latencije");
+
+	// Razmak provjera raste dok slika čeka prikaz (pod FIFO većinu slike), pa dretva ne troši procesor. Najveći
+	// razmak ujedno je najveća pogreška izmjerenog vremena prikaza
+	const std::chrono::microseconds min_poll_interval(100);
+	const std::chrono::microseconds max_poll_interval(1000);
+	std::chrono::microseconds poll_interval = min_poll_interval;
+
+	while (_running){
+
+		PendingPresent current;
+		{
+			std::unique_lock<std::mutex> lock(_queue_mutex);
+			_queue_cv.wait(lock, [&]() { return !_running || !_pending.empty(); });
+			if (!_running) break;
+			current = _pending.front();
+		}
+
+		VkResult result;
+		{
+			std::lock_guard<std::mutex> swapchain_lock(_swapchain_mutex);
+			{
+				// Swapchain je mogao biti uništen dok se čekalo na zaključavanje
+				std::lock_guard<std::mutex> queue_lock(_queue_mutex);
+				if (_pending.empty() || _pending.front().present_id != current.present_id) continue;
+			}
+
+			// Čekanje s nultim vremenom - swapchain se ne drži zaključanim dok se slika prikazuje
+			result = _wait_for_present(_device, current.swapchain, current.present_id, 0);
+		}
+
+		if (result == VK_TIMEOUT){
+			std::this_thread::sleep_for(poll_interval);
+			poll_interval = std::min(poll_interval * 2, max_poll_interval);
+			continue;
+		}
+		poll_interval = min_poll_interval;
+
+		Clock::time_point present_time = Clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock(_queue_mutex);
+			if (!_pending.empty() && _pending.front().present_id == current.present_id) _pending.pop_front();
+		}
+
+		if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR){
+			add_sample(current.mark, present_time);
+		}
+	}
+}
+
+void LatencyTracker::add_sample(const FrameMark& mark, Clock::time_point present_time){
+	std::lock_guard<std::mutex> lock(_stats_mutex);
+
+	_submit_to_present_samples.push_back(to_ms(present_time - mark.submit_time));
+	if (_submit_to_present_samples.size() > _sample_window) _submit_to_present_samples.pop_front();
+
+	if (mark.has_input){
+		_input_to_present_samples.push_back(to_ms(present_time - mark.input_time));
+		if (_input_to_present_samples.size() > _sample_window) _input_to_present_samples.pop_front();
+	}
+}
+
+
+LatencyTracker::Stats LatencyTracker::get_stats(){
+	Stats stats;
+	stats.present_wait_supported = _wait_for_present != nullptr;
+
+	std::lock_guard<std::mutex> lock(_stats_mutex);
+
+	auto average = [](const std::deque<double>& samples){
+		if (samples.empty()) return 0.0;
+		double sum = 0;
+		for (double s : samples) sum += s;
+		return sum / samples.size();
+	};
+
+	stats.input_to_submit_ms = average(_input_to_submit_samples);
+	stats.submit_to_present_ms = average(_submit_to_present_samples);
+	stats.input_to_present_ms = average(_input_to_present_samples);
+
+	if (!_input_to_present_samples.empty()){
+		stats.input_to_present_max_ms = *std::max_element(_input_to_present_samples.begin(), _input_to_present_samples.end());
+	}
+
+	stats.sample_count = (unsigned int)_input_to_present_samples.size();
+
+	return stats;
+}
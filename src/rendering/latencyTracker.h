@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+
+// Mjeri latenciju od korisničkog unosa (SDL događaja) do trenutka kada je slika stvarno prikazana na zaslonu.
+// Kraj prikaza moguće je izmjeriti samo ako uređaj podržava VK_KHR_present_id i VK_KHR_present_wait,
+// inače se mjeri samo vrijeme od unosa do slanja naredbi na GPU.
+class LatencyTracker {
+
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Vremenske oznake jedne slike
+	struct FrameMark {
+		bool has_input = false;
+		Clock::time_point input_time;
+		Clock::time_point submit_time;
+	};
+
+	struct Stats {
+		bool present_wait_supported = false;
+
+		double input_to_submit_ms = 0;
+		double submit_to_present_ms = 0;
+		double input_to_present_ms = 0;
+		double input_to_present_max_ms = 0;
+
+		unsigned int sample_count = 0;
+	};
+
+
+	void init(VkDevice device, PFN_vkWaitForPresentKHR wait_for_present);
+	void cleanup();
+
+	// Poziva se za svaki ulazni SDL događaj, uz njegovu SDL vremensku oznaku (u milisekundama)
+	void mark_input(uint32_t sdl_timestamp, uint32_t sdl_now);
+
+	// Poziva se pri izgradnji slike, na dretvi koja zove mark_input(). Predaje najraniji unos koji još nije
+	// uključen ni u jednu sliku (bez vremena slanja)
+	FrameMark take_input();
+
+	// Poziva se neposredno prije slanja naredbi slike na GPU, s oznakom koju je slika dobila iz take_input()
+	FrameMark mark_submit(FrameMark mark);
+
+	// Sljedeći id prezentacije (0 ako VK_KHR_present_id nije dostupan)
+	uint64_t next_present_id();
+
+	// Poziva se nakon vkQueuePresentKHR - slika se predaje pozadinskoj dretvi koja čeka njezin prikaz
+	void mark_present(VkSwapchainKHR swapchain, uint64_t present_id, const FrameMark& mark);
+
+	// Mora se pozvati prije uništavanja swapchaina
+	void reset_swapchain();
+
+	// Pristup swapchainu mora biti vanjski sinkroniziran između vkQueuePresentKHR i vkWaitForPresentKHR
+	std::mutex& swapchain_mutex() { return _swapchain_mutex; }
+
+	bool present_wait_supported() const { return _wait_for_present != nullptr; }
+
+	Stats get_stats();
+
+private:
+	struct PendingPresent {
+		VkSwapchainKHR swapchain;
+		uint64_t present_id;
+		FrameMark mark;
+	};
+
+	void worker_loop();
+	void add_sample(const FrameMark& mark, Clock::time_point present_time);
+
+	VkDevice _device = VK_NULL_HANDLE;
+	PFN_vkWaitForPresentKHR _wait_for_present = nullptr;
+
+	std::thread _worker;
+	std::atomic<bool> _running{ false };
+
+	std::mutex _swapchain_mutex;
+
+	std::mutex _queue_mutex;
+	std::condition_variable _queue_cv;
+	std::deque<PendingPresent> _pending;
+
+	uint64_t _present_id_counter = 0;
+
+	// Najraniji unos koji još nije uključen u sliku
+	bool _has_pending_input = false;
+	Clock::time_point _pending_input_time;
+
+	// Zadnjih nekoliko mjerenja za izračun prosjeka
+	static const unsigned int _sample_window = 120;
+	std::mutex _stats_mutex;
+	std::deque<double> _input_to_submit_samples;
+	std::deque<double> _submit_to_present_samples;
+	std::deque<double> _input_to_present_samples;
+};
@@ -0,0 +1,147 @@
+#include "performanceHud.h"
+
+#include "..\third-party\imgui\imgui.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+
+const char* PerformanceHud::phase_name(CpuPhase phase){
+	switch (phase) {
+	case PhaseInput: return "Unos";
+	case PhaseMovement: return "Kretanje";
+	case PhaseGui: return "Sucelje";
+	case PhaseRecording: return "Snimanje naredbi";
+	case PhaseGpuWait: return "Cekanje GPU-a";
+	default: return "?";
+	}
+}
+
+void PerformanceHud::toggle(){
+	_visible = !_visible;
+
+	// Nakon ponovnog otvaranja graf ne smije prikazati vrijeme dok je ploča bila skrivena kao jednu dugu sliku
+	_has_last_frame = false;
+	_history_count = 0;
+	_history_offset = 0;
+
+	std::lock_guard<std::mutex> lock(_phase_mutex);
+	for (int phase = 0; phase < PhaseCount; phase++) {
+		_phase_average_ms[phase] = 0;
+		_phase_frame_ms[phase] = 0;
+	}
+}
+
+void PerformanceHud::begin_frame(){
+	if (!_visible) return;
+
+	Clock::time_point now = Clock::now();
+	if (_has_last_frame) {
+		_frame_times[_history_offset] = std::chrono::duration<float, std::milli>(now - _last_frame).count();
+		_history_offset = (_history_offset + 1) % _history_size;
+		_history_count = std::min(_history_count + 1, _history_size);
+
+		// Faze prošle slike ulaze u prosjek tek kada je slika završena (čekanje ograda može se mjeriti više puta)
+		std::lock_guard<std::mutex> lock(_phase_mutex);
+		for (int phase = 0; phase < PhaseCount; phase++) {
+			_phase_average_ms[phase] = _phase_average_ms[phase] * 0.95 + _phase_frame_ms[phase] * 0.05;
+			_phase_frame_ms[phase] = 0;
+		}
+	}
+	_last_frame = now;
+	_has_last_frame = true;
+}
+
+void PerformanceHud::add_phase(CpuPhase phase, double ms){
+	std::lock_guard<std::mutex> lock(_phase_mutex);
+	_phase_frame_ms[phase] += ms;
+}
+
+
+static void format_bytes(char* text, size_t size, uint64_t bytes){
+	if (bytes >= (1ull << 30)) snprintf(text, size, "%.2f GiB", bytes / (double)(1ull << 30));
+	else snprintf(text, size, "%.1f MiB", bytes / (double)(1ull << 20));
+}
+
+void PerformanceHud::draw(const GpuProfiler& gpu_profiler, const Workload& workload, VmaAllocator allocator){
+	if (!_visible) return;
+
+	ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 430, 0), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+	bool open = true;
+	ImGui::Begin("Performanse", &open, ImGuiWindowFlags_AlwaysAutoResize);
+
+	// Graf trajanja slike - stariji uzorci lijevo
+	float average = 0, maximum = 0;
+	for (int i = 0; i < _history_count; i++) {
+		float value = _frame_times[(_history_offset - _history_count + i + _history_size) % _history_size];
+		average += value;
+		maximum = std::max(maximum, value);
+	}
+	if (_history_count) average /= _history_count;
+
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "%.2f ms (%.0f FPS), max %.2f ms", average, average > 0 ? 1000.0f / average : 0.0f, maximum);
+	int offset = _history_count < _history_size ? 0 : _history_offset;
+	ImGui::PlotLines("##trajanje_slike", _frame_times, _history_count, offset, overlay, 0.0f, std::max(maximum * 1.2f, 1.0f), ImVec2(400, 80));
+
+	ImGui::SeparatorText("Procesor");
+	double phase_average_ms[PhaseCount];
+	{
+		std::lock_guard<std::mutex> lock(_phase_mutex);
+		std::copy(_phase_average_ms, _phase_average_ms + PhaseCount, phase_average_ms);
+	}
+	double cpu_total = 0;
+	for (int phase = 0; phase < PhaseCount; phase++) {
+		ImGui::Text("%-18s %7.3f ms", phase_name((CpuPhase)phase), phase_average_ms[phase]);
+		cpu_total += phase_average_ms[phase];
+	}
+	ImGui::Text("%-18s %7.3f ms", "Ostalo", std::max(0.0, average - cpu_total));
+
+	ImGui::SeparatorText("GPU");
+	GpuProfiler::Stats gpu = gpu_profiler.get_stats();
+	if (!gpu_profiler.timestamps_supported()) {
+		ImGui::Text("Vremenske oznake nisu podrzane");
+	}
+	else {
+		for (int stage = 0; stage < GpuProfiler::StageCount; stage++) {
+			ImGui::Text("%-18s %7.3f ms", GpuProfiler::stage_name((GpuProfiler::Stage)stage), gpu.stage_ms[stage]);
+		}
+		ImGui::Text("%-18s %7.3f ms (max %.3f ms)", "ukupno", gpu.total_ms, gpu.total_max_ms);
+
+		// Propusnost se računa prema trajanju sjenčara, a ne cijele slike
+		double compute_s = gpu.stage_ms[GpuProfiler::StageCompute] / 1000.0;
+		if (compute_s > 0) {
+			double pixels = (double)workload.width * workload.height;
+			double samples = pixels * std::max(workload.sample_amount_in, 0) * std::max(workload.sample_amount_out, 0);
+			ImGui::Text("%.1f Mpiksela/s, %.2f Guzoraka/s", pixels / compute_s / 1e6, samples / compute_s / 1e9);
+		}
+	}
+	if (gpu_profiler.statistics_supported()) {
+		ImGui::Text("Pozivi sjencara: %llu po slici", (unsigned long long)gpu.compute_invocations);
+	}
+
+	ImGui::SeparatorText("GPU memorija");
+	const VkPhysicalDeviceMemoryProperties* memory_properties;
+	vmaGetMemoryProperties(allocator, &memory_properties);
+
+	std::vector<VmaBudget> budgets(memory_properties->memoryHeapCount);
+	vmaGetHeapBudgets(allocator, budgets.data());
+
+	for (uint32_t heap = 0; heap < memory_properties->memoryHeapCount; heap++) {
+		if (budgets[heap].usage == 0 && budgets[heap].statistics.blockBytes == 0) continue;
+
+		char usage[32], budget[32], blocks[32];
+		format_bytes(usage, sizeof(usage), budgets[heap].usage);
+		format_bytes(budget, sizeof(budget), budgets[heap].budget);
+		format_bytes(blocks, sizeof(blocks), budgets[heap].statistics.blockBytes);
+		bool device_local = (memory_properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		ImGui::Text("Gomila %u (%s): %s / %s, VMA %s", heap, device_local ? "GPU" : "sustav", usage, budget, blocks);
+	}
+
+	ImGui::End();
+
+	// Zatvaranje gumbom prozora
+	if (!open) toggle();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vma/vk_mem_alloc.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "gpuProfiler.h"
+
+
+// Ploča s performansama (F2): graf trajanja slike, raspodjela vremena glavne petlje na procesoru, faze na GPU-u,
+// propusnost (piksela i uzoraka u sekundi) i zauzeće GPU memorije.
+// Dok je ploča skrivena ništa se ne mjeri - faze ne čitaju sat, pa je cijena jedna provjera zastavice po fazi
+class PerformanceHud {
+
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum CpuPhase {
+		PhaseInput,			// handle_input
+		PhaseMovement,		// process_movement
+		PhaseGui,			// Izgradnja sučelja (show_gui i ImGui)
+		PhaseRecording,		// Snimanje i slanje naredbi (na dretvi iscrtavanja)
+		PhaseGpuWait,		// Čekanje ograda slike i slike swapchaina (na dretvi iscrtavanja)
+		PhaseCount
+	};
+
+	static const char* phase_name(CpuPhase phase);
+
+	// Mjeri fazu od stvaranja do kraja dosega. Smije se koristiti na bilo kojoj dretvi
+	class Scope {
+	public:
+		Scope(PerformanceHud& hud, CpuPhase phase) : _hud(hud), _phase(phase), _active(hud.visible()) {
+			if (_active) _start = Clock::now();
+		}
+		~Scope() {
+			if (_active) _hud.add_phase(_phase, std::chrono::duration<double, std::milli>(Clock::now() - _start).count());
+		}
+
+	private:
+		PerformanceHud& _hud;
+		CpuPhase _phase;
+		bool _active;
+		Clock::time_point _start;
+	};
+
+	bool visible() const { return _visible.load(std::memory_order_relaxed); }
+	void toggle();
+
+	// Poziva se jednom po slici, na početku glavne petlje
+	void begin_frame();
+	void add_phase(CpuPhase phase, double ms);
+
+	// Podaci o trenutnom opterećenju za izračun propusnosti
+	struct Workload {
+		unsigned int width;
+		unsigned int height;
+		int sample_amount_in;
+		int sample_amount_out;
+	};
+
+	// Crta ploču (unutar ImGui okvira)
+	void draw(const GpuProfiler& gpu_profiler, const Workload& workload, VmaAllocator allocator);
+
+private:
+	std::atomic<bool> _visible{ false };
+
+	static const int _history_size = 240;
+	float _frame_times[_history_size] = {};
+	int _history_offset = 0;
+	int _history_count = 0;
+
+	bool _has_last_frame = false;
+	Clock::time_point _last_frame;
+
+	// Eksponencijalno izglađeni prosjek svake faze i zbroj faza trenutne slike. Faze dolaze s glavne dretve
+	// i s dretve iscrtavanja
+	std::mutex _phase_mutex;
+	double _phase_average_ms[PhaseCount] = {};
+	double _phase_frame_ms[PhaseCount] = {};
+};
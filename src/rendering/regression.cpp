@@ -0,0 +1,123 @@
+#include "regression.h"
+#include "imageWriters.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+const std::vector<RegressionScene>& regression_scenes(){
+	static const std::vector<RegressionScene> scenes = {
+		// Rubovi planeta i sunčevog diska ovise o jednoj usporedbi po pikselu, pa rubni piksel na GPU-u može pasti
+		// s druge strane ruba - najveća greška zato ima širu granicu od srednje i mjeri se prema najbližem susjedu
+		// reference (compare_images)
+		// Ime          Visina      Smjer pogleda                    Sunce   Aerosoli  RMSE    Maks.
+		{ "tlo",        10.0f,      { 0.0f, 0.0f, -1.0f },           50.0f,  0.1f,     1e-3f,  0.25f },
+		{ "obzor",      20000.0f,   { 0.0f, -0.15f, -1.0f },         20.0f,  0.1f,     1e-3f,  0.25f },
+		{ "orbita",     400000.0f,  { 0.0f, -0.35f, -1.0f },         50.0f,  0.1f,     1e-3f,  0.25f },
+		{ "sumrak",     10.0f,      { 1.0f, 0.05f, 0.0f },           -4.0f,  0.1f,     1e-3f,  0.25f },
+		{ "sunce",      10.0f,      { 0.98f, 0.17f, 0.0f },          10.0f,  0.1f,     5e-3f,  0.25f },
+		{ "aerosoli",   10.0f,      { 0.7f, 0.1f, -0.7f },           30.0f,  1.0f,     1e-3f,  0.25f },
+	};
+	return scenes;
+}
+
+const std::vector<RegressionVariant>& regression_variants(){
+	// Koračanje mora pratiti sjenčar do na zaokruživanje. Analitička dubina i tablica računaju integral gustoće
+	// točnije od sjenčarovih 10 uzoraka, pa je njihova razlika od reference uglavnom greška same reference
+	static const std::vector<RegressionVariant> variants = {
+		{ "koracanje",          CpuDensityProfile::Exponential, CpuOpticalDepth::Marched,  1e-4f,  1e-3f },
+		{ "tablicni-profil",    CpuDensityProfile::Tabulated,   CpuOpticalDepth::Marched,  2e-4f,  2e-3f },
+		{ "analiticka-dubina",  CpuDensityProfile::Exponential, CpuOpticalDepth::Analytic, 5e-2f,  2e-1f },
+		{ "tablica-dubine",     CpuDensityProfile::Exponential, CpuOpticalDepth::Lut,      5e-2f,  2e-1f },
+	};
+	return variants;
+}
+
+void apply_regression_scene(const RegressionScene& scene, Camera& camera, Sun& sun, Planet& planet){
+
+	camera.position = glm::vec3(0, planet.radius + scene.camera_height, 0);
+
+	// Kamera gleda u smjeru -front (vidi RenderEngine::fill_shader_inputs)
+	camera.front = -glm::normalize(scene.view_dir);
+	camera.right = glm::normalize(glm::cross(glm::vec3(0, 1, 0), camera.front));
+	camera.up = glm::cross(camera.front, camera.right);
+
+	// Sunce se kreće u ravnini xy, pa je njegov kut iznad obzora točke (0, r, 0) upravo sun.angle
+	sun.angle = scene.sun_angle;
+
+	planet.atmosphere.aerosol_density_mul = scene.aerosol_density_mul;
+}
+
+
+static inline float tone_map(float value){
+	value = std::max(value, 0.0f);
+	return value / (1.0f + value);
+}
+
+// Najmanja greška komponente prema pikselima reference u susjedstvu 3x3 - rub pomaknut za jedan piksel ne
+// računa se kao greška, a pogrešna boja ili nestali sunčev disk i dalje da
+static float neighbourhood_error(float candidate, const float* reference, uint32_t width, uint32_t height, uint32_t x, uint32_t y, int c){
+	float error = 1.0f;
+	for (uint32_t ny = (y > 0 ? y - 1 : 0); ny <= std::min(y + 1, height - 1); ny++) {
+		for (uint32_t nx = (x > 0 ? x - 1 : 0); nx <= std::min(x + 1, width - 1); nx++) {
+			size_t i = ((size_t)ny * width + nx) * 4;
+			error = std::min(error, std::fabs(tone_map(candidate) - tone_map(reference[i + c])));
+		}
+	}
+	return error;
+}
+
+ImageDifference compare_images(const float* candidate, const float* reference, uint32_t width, uint32_t height){
+
+	ImageDifference difference = { 0, 0, 0, 0 };
+	double sum = 0;
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			size_t i = ((size_t)y * width + x) * 4;
+
+			for (int c = 0; c < 3; c++) {
+				// NaN se računa kao najveća moguća greška
+				double error = std::isfinite(candidate[i + c])
+					? std::fabs(tone_map(candidate[i + c]) - tone_map(reference[i + c]))
+					: 1.0;
+
+				sum += error * error;
+
+				// Najveća greška računa se prema najbližem susjedu, samo za piksele koji bi ju mogli povećati
+				if (error > difference.max_error && std::isfinite(candidate[i + c])) {
+					error = neighbourhood_error(candidate[i + c], reference, width, height, x, y, c);
+				}
+				if (error > difference.max_error) {
+					difference.max_error = error;
+					difference.max_x = x;
+					difference.max_y = y;
+				}
+			}
+		}
+	}
+
+	size_t count = (size_t)width * height * 3;
+	difference.rmse = count ? std::sqrt(sum / count) : 0.0;
+	return difference;
+}
+
+void write_regression_images(const std::string& base, const float* candidate, const float* reference, uint32_t width, uint32_t height, float max_limit){
+
+	size_t row_pitch = (size_t)width * 4 * sizeof(float);
+	write_image(base + "_kandidat.exr", ImageFileFormat::EXR, { (const uint8_t*)candidate, width, height, row_pitch, true, true });
+	write_image(base + "_referenca.exr", ImageFileFormat::EXR, { (const uint8_t*)reference, width, height, row_pitch, true, true });
+
+	// Razlika po komponentama - greška jednaka pragu max_limit je puna svjetlina
+	std::vector<float> difference((size_t)width * height * 4, 0.0f);
+	float scale = max_limit > 0 ? 1.0f / max_limit : 1.0f;
+	for (size_t i = 0; i < difference.size(); i += 4) {
+		for (int c = 0; c < 3; c++) {
+			float error = std::isfinite(candidate[i + c])
+				? std::fabs(tone_map(candidate[i + c]) - tone_map(reference[i + c]))
+				: 1.0f;
+			difference[i + c] = std::min(error * scale, 1.0f);
+		}
+	}
+	write_image(base + "_razlika.png", ImageFileFormat::PNG, { (const uint8_t*)difference.data(), width, height, row_pitch, true, true });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "camera.h"
+#include "../simulation/shaderInputs.h"
+#include "../simulation/cpuRenderer.h"
+
+
+// Provjera regresije slike (--regresija): nepromjenjiv skup scena iscrtava se na GPU-u i brzim jezgrama procesora,
+// a svaka slika uspoređuje se s referencom - skalarnom jezgrom procesora, koja je izravan prijenos sjenčara.
+// Greške se mjere nakon preslikavanja x / (1 + x), pa sunce (vrijednosti do 50) i tamno nebo imaju usporedive pragove
+
+struct RegressionScene {
+	const char* name;
+	float camera_height;		// Visina kamere iznad površine (m)
+	glm::vec3 view_dir;			// Smjer pogleda u središtu slike
+	float sun_angle;			// Kut sunca iznad obzora u točki ispod kamere (stupnjevi)
+	float aerosol_density_mul;
+
+	// Dopuštena odstupanja GPU slike od reference
+	float rmse_limit;
+	float max_limit;
+};
+
+// Način računanja u SIMD jezgrama procesora i njegova dopuštena odstupanja od reference.
+// Provjerava se sa svakom jezgrom koju procesor podržava
+struct RegressionVariant {
+	const char* name;
+	CpuDensityProfile profile;
+	CpuOpticalDepth depth;
+	float rmse_limit;
+	float max_limit;
+};
+
+const std::vector<RegressionScene>& regression_scenes();
+const std::vector<RegressionVariant>& regression_variants();
+
+// Postavlja kameru, sunce i atmosferu scene - ostali parametri (broj uzoraka, način raspršenja) ostaju kakvi jesu
+void apply_regression_scene(const RegressionScene& scene, Camera& camera, Sun& sun, Planet& planet);
+
+
+struct ImageDifference {
+	double rmse;
+	double max_error;
+	uint32_t max_x, max_y;		// Piksel s najvećom greškom
+};
+
+// Slike su u obliku koji piše sjenčar (4 floata po pikselu, b, g, r, 0). RMSE se računa po pikselima, a najveća
+// greška prema najbližem pikselu reference u susjedstvu 3x3, pa rub pomaknut za jedan piksel nije greška
+ImageDifference compare_images(const float* candidate, const float* reference, uint32_t width, uint32_t height);
+
+// Za neuspjelu provjeru: kandidat i referenca (EXR, linearne vrijednosti) te slika razlike (PNG, max_limit je puna svjetlina)
+void write_regression_images(const std::string& base, const float* candidate, const float* reference, uint32_t width, uint32_t height, float max_limit);
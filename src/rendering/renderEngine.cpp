@@ -3,6 +3,15 @@
 #define VMA_IMPLEMENTATION
 #include <vma/vk_mem_alloc.h>
 
+// Generirano pri izgradnji - SPIR-V svih sjenčara iz mape shaders
+#include "embedded_shaders.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 static void check_vk_result(VkResult err)
 {
 	if (err == 0)
@@ -12,41 +21,70 @@ static void check_vk_result(VkResult err)
 		abort();
 }
 
+static const char* present_mode_name(VkPresentModeKHR mode)
+{
+	switch (mode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+	default: return "?";
+	}
+}
+
 
 void RenderEngine::init(){
 
+	_startup_time = std::chrono::steady_clock::now();
 
-	// Inicijalizacija SDL prozora
-	SDL_Init(SDL_INIT_VIDEO);
+	TraceRecorder::instance().set_thread_name("glavna");
+	if (!_trace_path.empty()) TraceRecorder::instance().start();
 
-	SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN);
+	// Mapa s .spv datotekama koje zamjenjuju ugrađene sjenčare (za razvoj, bez ponovne izgradnje programa)
+	const char* shader_dir = std::getenv("SIMULACIJA_SHADER_DIR");
+	if (shader_dir) _shader_override_dir = shader_dir;
 
-	_window = SDL_CreateWindow(
-		"Simulacija atmosferskog rasprsivanja v1.0", //window title
-		SDL_WINDOWPOS_UNDEFINED, //window position x
-		SDL_WINDOWPOS_UNDEFINED, //window position y
-		_screen_size_x,     //window width in pixels
-		_screen_size_y,    //window height in pixels
-		window_flags
-	);
+	if (!_headless && _output_format != VK_FORMAT_R8G8B8A8_UNORM){
+		std::cerr << "Float izlazna slika moguca je samo bez prozora - koristi se 8-bitna slika\n";
+		_output_format = VK_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	// Inicijalizacija SDL prozora - bez prozora se SDL uopće ne koristi
+	if (!_headless){
+		SDL_Init(SDL_INIT_VIDEO);
+
+		SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+
+		_window = SDL_CreateWindow(
+			"Simulacija atmosferskog rasprsivanja v1.0", //window title
+			SDL_WINDOWPOS_UNDEFINED, //window position x
+			SDL_WINDOWPOS_UNDEFINED, //window position y
+			_screen_size_x,     //window width in pixels
+			_screen_size_y,    //window height in pixels
+			window_flags
+		);
 
-	SDL_SetRelativeMouseMode(SDL_TRUE);
+		SDL_SetRelativeMouseMode(SDL_TRUE);
+	}
 
-	// Inicijalizacija Vulkan instance i dohvaanje grafikog procesora
+	// Inicijalizacija Vulkan instance i dohvaćanje grafičkog procesora
 	init_vulkan();
 
-	// Postavljanje GPU memorije za spremanje struktura potrebnih sjenaru
+	// Postavljanje GPU memorije za spremanje struktura potrebnih sjenčaru
 	allocate_compute_buffers();
 	allocate_compute_images();
 	
 	
 
-	// Postavljanje struktura za opis grafikog protonog sustava, uitavanje sjenara i opis podataka
+	// Postavljanje struktura za opis grafičkog protočnog sustava, učitavanje sjenčara i opis podataka
 	init_compute_descriptors();
+	init_pipeline_cache();
 	init_compute_pipelines();
 
 	// Postavljanje struktura za prikaz slike
-	init_swapchain();
+	_requested_present_mode = _desired_present_mode;
+	if (!_headless) init_swapchain();
 
 
 	// Struktura za prijenos GPU naredbi
@@ -57,10 +95,21 @@ void RenderEngine::init(){
 	init_sync_structures();
 
 
+	init_readback();
+
+	init_gpu_profiler();
+
+	if (_headless) return;
+
 	init_render_pass();
 	init_framebuffers();
 	init_imgui();
 
+	// Dretve za snimanje prolaza koje dretva iscrtavanja ne stigne sama
+	if (_recording_threads > 0) _record_workers.init(_recording_threads, 16, "snimanje naredbi");
+
+	// Sučelje prve slike prikazuje stanje swapchaina prije nego što dretva iscrtavanja išta iscrta
+	publish_render_status();
 }
 
 
@@ -73,18 +122,24 @@ void RenderEngine::init_vulkan(){
 		.request_validation_layers(true)
 		.require_api_version(1, 1, 0)
 		.use_default_debug_messenger()
+		// Bez prozora nisu potrebna proširenja površine, pa radi i na uređajima bez zaslona (npr. lavapipe)
+		.set_headless(_headless)
 		.build();
 
+	if (!instance) {
+		throw std::runtime_error("Vulkan instanca nije uspjela biti stvorena: " + instance.error().message());
+	}
+
 
 	vkb::Instance vkb_instance = instance.value();
 
 
-	// Spremanje instance kako bi se mogla korisiti i poistiti poslije
+	// Spremanje instance kako bi se mogla korisiti i počistiti poslije
 	_instance = vkb_instance.instance;
 	_debug_messenger = vkb_instance.debug_messenger;
 
-	// Dohvaanje SDL prozora
-	SDL_Vulkan_CreateSurface(_window, _instance, &_window_surface);
+	// Dohvaćanje SDL prozora
+	if (!_headless) SDL_Vulkan_CreateSurface(_window, _instance, &_window_surface);
 
 	VkPhysicalDeviceDescriptorIndexingFeatures descriptorFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES, 
 		VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,VK_FALSE,
@@ -95,24 +150,77 @@ void RenderEngine::init_vulkan(){
 
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.shaderFloat64 = VK_TRUE;
+	// Sjenčar ne navodi format izlazne slike, tako da može pisati i u float sliku
+	deviceFeatures.shaderStorageImageWriteWithoutFormat = VK_TRUE;
 
-	// Biranje grafikog procesora
+	// Biranje grafičkog procesora
 	vkb::PhysicalDeviceSelector selector{ vkb_instance };
-	vkb::PhysicalDevice physicalDevice = selector
-		.add_required_extension("VK_KHR_swapchain")
+	selector
 		.add_required_extension("VK_EXT_descriptor_indexing")
 		.add_required_extension_features<VkPhysicalDeviceDescriptorIndexingFeatures>(descriptorFeatures)
 		.set_required_features(deviceFeatures)
-		.set_minimum_version(1, 1)
-		.set_surface(_window_surface)
-		.select()
-		.value();
+		.set_minimum_version(1, 1);
+
+	if (!_headless) {
+		selector
+			.add_required_extension("VK_KHR_swapchain")
+			// Opcionalno - služe za mjerenje trenutka prikaza slike
+			.add_desired_extension(VK_KHR_PRESENT_ID_EXTENSION_NAME)
+			.add_desired_extension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+			.set_surface(_window_surface);
+	}
+
+	vkb::Result<vkb::PhysicalDevice> selected = selector.select();
+	if (!selected) {
+		throw std::runtime_error("Nije pronaden odgovarajuci graficki procesor: " + selected.error().message());
+	}
+	vkb::PhysicalDevice physicalDevice = selected.value();
+
+
+
+	// Provjera jesu li pronađena proširenja za čekanje prikaza i njihove mogućnosti
+	bool has_present_id_ext = false;
+	bool has_present_wait_ext = false;
+	for (const std::string& ext : physicalDevice.get_extensions()) {
+		if (ext == VK_KHR_PRESENT_ID_EXTENSION_NAME) has_present_id_ext = true;
+		if (ext == VK_KHR_PRESENT_WAIT_EXTENSION_NAME) has_present_wait_ext = true;
+	}
+
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+	presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+	presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	presentIdFeatures.pNext = &presentWaitFeatures;
+
+	if (has_present_id_ext && has_present_wait_ext) {
+		VkPhysicalDeviceFeatures2 supportedFeatures{};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &presentIdFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice.physical_device, &supportedFeatures);
+	}
+
+	_present_id_enabled = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
 
+	// Statistika protočnog sustava (broj poziva sjenčara) je opcionalna - uključuje se samo ako ju uređaj podržava.
+	// Značajke odabranog uređaja prenose se u logički uređaj
+	VkPhysicalDeviceFeatures supportedBaseFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice.physical_device, &supportedBaseFeatures);
+	_pipeline_statistics_enabled = supportedBaseFeatures.pipelineStatisticsQuery == VK_TRUE;
+	physicalDevice.features.pipelineStatisticsQuery = supportedBaseFeatures.pipelineStatisticsQuery;
 
 
-	// Prijenos fizikog opisnika u logiki
+	// Prijenos fizičkog opisnika u logički
 	vkb::DeviceBuilder deviceBuilder{ physicalDevice };
 
+	if (_present_id_enabled) {
+		// Lanac je već ispunjen podržanim vrijednostima, pa se samo prosljeđuje uređaju
+		presentWaitFeatures.pNext = nullptr;
+		presentIdFeatures.pNext = nullptr;
+		deviceBuilder.add_pNext(&presentIdFeatures);
+		deviceBuilder.add_pNext(&presentWaitFeatures);
+	}
+
 	vkb::Device vkbDevice = deviceBuilder.build().value();
 
 	_device = vkbDevice.device;
@@ -123,6 +231,18 @@ void RenderEngine::init_vulkan(){
 	vkGetPhysicalDeviceProperties(_physical_GPU, &GPU_info);
 	std::cout << "Koristeni graficki procesor: " << GPU_info.deviceName << "\n";
 
+
+	// Mjerenje latencije - kraj prikaza može se izmjeriti samo uz VK_KHR_present_wait
+	PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+	if (_present_id_enabled) {
+		waitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(_device, "vkWaitForPresentKHR");
+	}
+	if (!waitForPresent) {
+		_present_id_enabled = false;
+		if (!_headless) std::cout << "VK_KHR_present_wait nije podrzan - mjeri se samo latencija do slanja naredbi\n";
+	}
+	_latency.init(_device, waitForPresent);
+
 	// Biranje naredbenih redova
 	std::vector<VkQueueFamilyProperties> queue_families = physicalDevice.get_queue_families();
 	std::vector<vkb::CustomQueueDescription> graphics_queue_descriptions;
@@ -141,12 +261,21 @@ void RenderEngine::init_vulkan(){
 		}
 	}
 	if (compute_queue_descriptions.size() == 0) {
-		std::cerr << "Izabrani GPU uredaj nema redove za komputaciju. Program e se sada unistiti\n";
+		std::cerr << "Izabrani GPU uredaj nema redove za komputaciju. Program će se sada unistiti\n";
 		return;
 	}
 
+	// Bez prozora grafički red nije potreban - uređaj može imati samo komputacijske redove
+	if (graphics_queue_descriptions.size() == 0) {
+		if (!_headless) {
+			std::cerr << "Izabrani GPU uredaj nema redove za grafiku\n";
+			return;
+		}
+		graphics_queue_descriptions.push_back(compute_queue_descriptions[0]);
+	}
 
-	// Biranje prvog reda koji podrava grafike naredbe
+
+	// Biranje prvog reda koji podržava grafičke naredbe
 	vkGetDeviceQueue(vkbDevice.device, graphics_queue_descriptions[0].index, 0, &_graphics_queue);
 	_graphics_queue_family = graphics_queue_descriptions[0].index;
 	// I komputacijske
@@ -242,7 +371,19 @@ void RenderEngine::allocate_compute_buffers(){
 }
 void RenderEngine::allocate_compute_images(){
 
-	// Alociranje rezultantne slike komputacijskog sjenara
+	for (unsigned int i = 0; i < _max_frames_in_flight; i++) {
+		allocate_output_image(i);
+	}
+}
+
+void RenderEngine::allocate_output_image(unsigned int frame_index){
+
+	// Veličina se zaokružuje na veći razred, tako da manje promjene veličine prozora ne zahtijevaju novu sliku
+	VkExtent2D extent;
+	extent.width = (_screen_size_x + _output_image_bucket - 1) / _output_image_bucket * _output_image_bucket;
+	extent.height = (_screen_size_y + _output_image_bucket - 1) / _output_image_bucket * _output_image_bucket;
+
+	// Alociranje rezultantne slike komputacijskog sjenčara
 	VmaAllocationCreateInfo vmaallocInfo = {};
 
 
@@ -251,7 +392,7 @@ void RenderEngine::allocate_compute_images(){
 	imageCinfo.pNext = nullptr;
 	imageCinfo.arrayLayers = 1;
 	imageCinfo.flags = 0;
-	imageCinfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageCinfo.format = _output_format;
 	imageCinfo.imageType = VK_IMAGE_TYPE_2D;
 	imageCinfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	imageCinfo.mipLevels = 1;
@@ -262,43 +403,120 @@ void RenderEngine::allocate_compute_images(){
 	imageCinfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 	imageCinfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
-	imageCinfo.extent = { _screen_size_x, _screen_size_y, 1 };
+	imageCinfo.extent = { extent.width, extent.height, 1 };
 
+	Frame& frame = _frames[frame_index];
 
+	VK_CHECK(vmaCreateImage(_allocator, &imageCinfo, &vmaallocInfo,
+		&frame._output_image._image,
+		&frame._output_image._allocation,
+		nullptr));
 
-	for (unsigned int i = 0; i < _max_frames_in_flight; i++) {
+	frame._output_image_extent = extent;
 
-		imageCinfo.pQueueFamilyIndices = &(_compute_queue_family, _graphics_queue_family);
-		imageCinfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-		imageCinfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-		imageCinfo.extent = { _screen_size_x, _screen_size_y, 1 };
+	// Pomoćna slika za dinamičku razlučivost - puni se samo blitom i kopira u swapchain
+	if (!_headless) {
+		VkImageCreateInfo upscaledCinfo = imageCinfo;
+		upscaledCinfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-		VK_CHECK(vmaCreateImage(_allocator, &imageCinfo, &vmaallocInfo,
-			&_frames[i]._output_image._image,
-			&_frames[i]._output_image._allocation,
+		VK_CHECK(vmaCreateImage(_allocator, &upscaledCinfo, &vmaallocInfo,
+			&frame._upscaled_image._image,
+			&frame._upscaled_image._allocation,
 			nullptr));
+	}
 
+	// Jedna svjetlina po kutu pločice - kutova je po svakoj osi jedan više od pločica
+	VkDeviceSize corners_x = (extent.width + _adaptive_tile_size - 1) / _adaptive_tile_size + 1;
+	VkDeviceSize corners_y = (extent.height + _adaptive_tile_size - 1) / _adaptive_tile_size + 1;
+
+	VkBufferCreateInfo estimateInfo = {};
+	estimateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	estimateInfo.size = corners_x * corners_y * sizeof(float);
+	estimateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	VmaAllocationCreateInfo estimateAllocInfo = {};
+	estimateAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VK_CHECK(vmaCreateBuffer(_allocator, &estimateInfo, &estimateAllocInfo,
+		&frame._sample_estimate_buffer._buffer,
+		&frame._sample_estimate_buffer._allocation,
+		nullptr));
+
+	VkImageViewCreateInfo viewCInfo = {};
+	viewCInfo.image = frame._output_image._image;
+	viewCInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewCInfo.pNext = nullptr;
+	viewCInfo.flags = 0;
+	viewCInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewCInfo.format = _output_format;
+	viewCInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0,1,0,1 };
+
+	VK_CHECK(vkCreateImageView(_device, &viewCInfo, nullptr, &frame._output_image_view));
+}
 
-		_image_deletion_queue.push_function([=]() {
-			vmaDestroyImage(_allocator, _frames[i]._output_image._image, _frames[i]._output_image._allocation);
-			});
+void RenderEngine::retire_output_image(unsigned int frame_index){
 
-		VkImageViewCreateInfo viewCInfo = {};
-		viewCInfo.image = _frames[i]._output_image._image;
-		viewCInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewCInfo.pNext = nullptr;
-		viewCInfo.flags = 0;
-		viewCInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewCInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-		viewCInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0,1,0,1 };
+	// Kopije, jer će se polja slike do brisanja već odnositi na novu sliku
+	AllocatedImage image = _frames[frame_index]._output_image;
+	VkImageView view = _frames[frame_index]._output_image_view;
+	AllocatedImage upscaled = _frames[frame_index]._upscaled_image;
+	AllocatedBuffer estimate = _frames[frame_index]._sample_estimate_buffer;
 
-		VK_CHECK(vkCreateImageView(_device, &viewCInfo, nullptr, &_frames[i]._output_image_view));
+	_frames[frame_index]._deletion_queue.push_function([=]() {
+		vkDestroyImageView(_device, view, nullptr);
+		vmaDestroyImage(_allocator, image._image, image._allocation);
+		if (upscaled._image != VK_NULL_HANDLE) vmaDestroyImage(_allocator, upscaled._image, upscaled._allocation);
+		vmaDestroyBuffer(_allocator, estimate._buffer, estimate._allocation);
+		});
+}
 
-		_image_deletion_queue.push_function([=]() {
-			vkDestroyImageView(_device, _frames[i]._output_image_view, nullptr);
-			});
+void RenderEngine::write_output_image_descriptor(unsigned int frame_index){
+	VkDescriptorImageInfo iinfo = {};
+	iinfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	iinfo.imageView = _frames[frame_index]._output_image_view;
+	iinfo.sampler = nullptr;
+
+	VkWriteDescriptorSet setWrite = {};
+	setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	setWrite.pNext = nullptr;
+	setWrite.dstBinding = 2;
+	setWrite.dstSet = _frames[frame_index]._compute_descriptor_set;
+	setWrite.descriptorCount = 1;
+	setWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	setWrite.pImageInfo = &iinfo;
+	setWrite.pBufferInfo = nullptr;
+
+	vkUpdateDescriptorSets(_device, 1, &setWrite, 0, nullptr);
+
+	VkDescriptorBufferInfo binfo = {};
+	binfo.buffer = _frames[frame_index]._sample_estimate_buffer._buffer;
+	binfo.offset = 0;
+	binfo.range = VK_WHOLE_SIZE;
+
+	setWrite.dstBinding = 3;
+	setWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	setWrite.pImageInfo = nullptr;
+	setWrite.pBufferInfo = &binfo;
+
+	vkUpdateDescriptorSets(_device, 1, &setWrite, 0, nullptr);
+}
 
-	}
+void RenderEngine::update_output_image(unsigned int frame_index){
+	const Frame& frame = _frames[frame_index];
+
+	bool too_small = frame._output_image_extent.width < _screen_size_x || frame._output_image_extent.height < _screen_size_y;
+
+	// Nakon smanjenja prozora (npr. izlaska iz cijelog zaslona) prevelika slika se ne drži zauvijek
+	uint64_t allocated_area = (uint64_t)frame._output_image_extent.width * frame._output_image_extent.height;
+	uint64_t needed_area = (uint64_t)(_screen_size_x + _output_image_bucket) * (_screen_size_y + _output_image_bucket);
+	bool too_large = allocated_area > 4 * needed_area;
+
+	if (!too_small && !too_large) return;
+
+	// Ograda ove slike je već pričekana, pa njezin opisnik nije u upotrebi i može se odmah promijeniti
+	retire_output_image(frame_index);
+	allocate_output_image(frame_index);
+	write_output_image_descriptor(frame_index);
 }
 void RenderEngine::init_compute_descriptors(){
 
@@ -319,25 +537,31 @@ void RenderEngine::init_compute_descriptors(){
 	computeBinding2.binding = 2;
 	computeBinding2.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 
+	// Opisnik spremnika svjetline predprolaza
+	VkDescriptorSetLayoutBinding computeBinding3 = computeBinding0;
+	computeBinding3.binding = 3;
+	computeBinding3.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
 
 	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingInfo;
 	bindingInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
 	bindingInfo.pNext = nullptr;
-	VkDescriptorBindingFlags flags[3] = {0,
+	VkDescriptorBindingFlags flags[4] = {0,
+										 0,
 										 0,
 										 0};
 	bindingInfo.pBindingFlags = flags;
-	bindingInfo.bindingCount = 3;
+	bindingInfo.bindingCount = 4;
 
 	// Opisnik cijelog seta
 	VkDescriptorSetLayoutCreateInfo setinfo = {};
 	setinfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	setinfo.pNext = &bindingInfo;
 
-	setinfo.bindingCount = 3;
+	setinfo.bindingCount = 4;
 	setinfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
 
-	VkDescriptorSetLayoutBinding bindings[3] = { computeBinding0, computeBinding1, computeBinding2};
+	VkDescriptorSetLayoutBinding bindings[4] = { computeBinding0, computeBinding1, computeBinding2, computeBinding3};
 	setinfo.pBindings = bindings;
 
 	vkCreateDescriptorSetLayout(_device, &setinfo, nullptr, &_compute_set_layout);
@@ -351,7 +575,8 @@ void RenderEngine::init_compute_descriptors(){
 	std::vector<VkDescriptorPoolSize> sizes =
 	{
 		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2*_max_frames_in_flight },
-		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  1*_max_frames_in_flight }
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  1*_max_frames_in_flight },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1*_max_frames_in_flight }
 	};
 
 
@@ -370,7 +595,7 @@ void RenderEngine::init_compute_descriptors(){
 
 	for (unsigned int i = 0; i < _max_frames_in_flight; i++) {    
 
-		// Prosljeivanje informacija opisnicima
+		// Prosljeđivanje informacija opisnicima
 		VkDescriptorSetAllocateInfo allocInfo = {};
 		allocInfo.pNext = nullptr;
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -390,7 +615,7 @@ void RenderEngine::init_compute_descriptors(){
 		setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		setWrite.pNext = nullptr;
 
-		// Pristupa se s 0. bindingom u sjenaru
+		// Pristupa se s 0. bindingom u sjenčaru
 		setWrite.dstBinding = 0;
 		setWrite.dstSet = _frames[i]._compute_descriptor_set;
 		setWrite.descriptorCount = 1;
@@ -399,12 +624,12 @@ void RenderEngine::init_compute_descriptors(){
 
 		vkUpdateDescriptorSets(_device, 1, &setWrite, 0, nullptr);
 
-		// Nakon Update naredbe, strukti binfo i setwrite mogu se ponovno iskoristiti za opisivanje sljedeeg spremnika
+		// Nakon Update naredbe, strukti binfo i setwrite mogu se ponovno iskoristiti za opisivanje sljedećeg spremnika
 		binfo.buffer = _frames[i]._atmosphere_uniform_buffer._buffer;
 		binfo.offset = 0;
 		binfo.range = sizeof(shader_input_buffer_1);
 
-		// Pristupa se s 1. bindingom u sjenaru
+		// Pristupa se s 1. bindingom u sjenčaru
 		setWrite.dstBinding = 1;
 		setWrite.dstSet = _frames[i]._compute_descriptor_set;
 		setWrite.descriptorCount = 1;
@@ -413,20 +638,8 @@ void RenderEngine::init_compute_descriptors(){
 		vkUpdateDescriptorSets(_device, 1, &setWrite, 0, nullptr);
 
 
-		// Alokacija opisnika slike
-		VkDescriptorImageInfo iinfo = {};
-		iinfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		iinfo.imageView = _frames[i]._output_image_view;
-		iinfo.sampler = nullptr;
-
-		setWrite.dstBinding = 2;
-		setWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		setWrite.pImageInfo = &iinfo;
-		setWrite.pBufferInfo = nullptr;
-		vkUpdateDescriptorSets(_device, 1, &setWrite, 0, nullptr);
-		
-
+		// Opisnici slike i spremnika svjetline - isti se ponovno pišu pri svakoj novoj izlaznoj slici
+		write_output_image_descriptor(i);
 	}
 }
 
@@ -471,40 +684,58 @@ void RenderEngine::init_render_pass(){
 }
 
 
-bool RenderEngine::load_shader_module(const char* filePath, VkShaderModule* outShaderModule)
+bool RenderEngine::load_shader_module(const char* shaderName, VkShaderModule* outShaderModule)
 {
-	//open the file. With cursor at the end
-	std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+	// Razvojni način - sjenčar se učitava s diska umjesto iz izvršne datoteke
+	if (!_shader_override_dir.empty()) {
+		std::string filePath = _shader_override_dir + "/" + shaderName + ".spv";
 
-	if (!file.is_open()) {
-		return false;
-	}
+		//open the file. With cursor at the end
+		std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+
+		if (file.is_open()) {
+			//find what the size of the file is by looking up the location of the cursor
+			//because the cursor is at the end, it gives the size directly in bytes
+			size_t fileSize = (size_t)file.tellg();
 
-	//find what the size of the file is by looking up the location of the cursor
-	//because the cursor is at the end, it gives the size directly in bytes
-	size_t fileSize = (size_t)file.tellg();
+			//spirv expects the buffer to be on uint32, so make sure to reserve an int vector big enough for the entire file
+			std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
 
-	//spirv expects the buffer to be on uint32, so make sure to reserve an int vector big enough for the entire file
-	std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
+			//put file cursor at beginning
+			file.seekg(0);
 
-	//put file cursor at beginning
-	file.seekg(0);
+			//load the entire file into the buffer
+			file.read((char*)buffer.data(), fileSize);
 
-	//load the entire file into the buffer
-	file.read((char*)buffer.data(), fileSize);
+			//now that the file is loaded into the buffer, we can close it
+			file.close();
 
-	//now that the file is loaded into the buffer, we can close it
-	file.close();
+			std::cout << "Sjencar '" << shaderName << "' ucitan s diska ('" << filePath << "')\n";
+			return create_shader_module(buffer.data(), buffer.size() * sizeof(uint32_t), outShaderModule);
+		}
+
+		std::cerr << "Sjencar '" << filePath << "' nije pronaden - koristi se ugradeni\n";
+	}
+
+	for (const EmbeddedShader& shader : embedded_shaders) {
+		if (strcmp(shader.name, shaderName) == 0) {
+			return create_shader_module(shader.code, shader.size_bytes, outShaderModule);
+		}
+	}
 
+	return false;
+}
 
+bool RenderEngine::create_shader_module(const uint32_t* code, size_t codeSize, VkShaderModule* outShaderModule)
+{
 	//create a new shader module, using the buffer we loaded
 	VkShaderModuleCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 	createInfo.pNext = nullptr;
 
-	//codeSize has to be in bytes, so multiply the ints in the buffer by size of int to know the real size of the buffer
-	createInfo.codeSize = buffer.size() * sizeof(uint32_t);
-	createInfo.pCode = buffer.data();
+	//codeSize has to be in bytes
+	createInfo.codeSize = codeSize;
+	createInfo.pCode = code;
 
 	//check that the creation goes well.
 	VkShaderModule shaderModule;
@@ -518,9 +749,9 @@ bool RenderEngine::load_shader_module(const char* filePath, VkShaderModule* outS
 
 void RenderEngine::init_compute_pipelines(){
 
-	// Uitavanje kompilirane datoteke sjenara
+	// Učitavanje kompilirane datoteke sjenčara
 	VkShaderModule mainShader;
-	char shaderName1[] = "./shaders/main_shader.spv";
+	char shaderName1[] = "main_shader";
 	if (!load_shader_module(shaderName1, &mainShader)) {
 		std::cerr << "Glavni komputacijski sjencar ('" << shaderName1 << "') nije uspio biti ucitan :(\n";
 	}
@@ -531,14 +762,21 @@ void RenderEngine::init_compute_pipelines(){
 	
 	PipelineBuilder pipelineBuilder;
 
-	// Gradnja protone strukture
+	// Gradnja protočne strukture
 	VkPipelineLayoutCreateInfo compute_pipeline_layout_info;
 	compute_pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	compute_pipeline_layout_info.pNext = nullptr;
 	compute_pipeline_layout_info.flags = 0;
 	compute_pipeline_layout_info.setLayoutCount = 0;
-	compute_pipeline_layout_info.pushConstantRangeCount = 0;
-	compute_pipeline_layout_info.pPushConstantRanges = nullptr;
+
+	// Prolaz sjenčara (predprolaz ili puni prolaz) predaje se kao konstanta, jer oba koriste isti uniformni spremnik
+	VkPushConstantRange pass_range = {};
+	pass_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pass_range.offset = 0;
+	pass_range.size = sizeof(int32_t);
+
+	compute_pipeline_layout_info.pushConstantRangeCount = 1;
+	compute_pipeline_layout_info.pPushConstantRanges = &pass_range;
 	compute_pipeline_layout_info.setLayoutCount = 1;
 	compute_pipeline_layout_info.pSetLayouts = &_compute_set_layout;
 
@@ -558,10 +796,14 @@ void RenderEngine::init_compute_pipelines(){
 	info.pName = "main";
 
 	pipelineBuilder._shaderStages.push_back(info);
-	_default_compute_pipeline = pipelineBuilder.build_compute_pipeline(_device);
+	std::chrono::steady_clock::time_point pipeline_start = std::chrono::steady_clock::now();
+	_default_compute_pipeline = pipelineBuilder.build_compute_pipeline(_device, _pipeline_cache);
 
+	std::cout << "Izgradnja protocnog sustava: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipeline_start).count()
+		<< " ms\n";
 
-	// ienje sjenara - nakon to je dodan u protok, moe se odmah izbrisati
+
+	// Čišćenje sjenčara - nakon što je dodan u protok, može se odmah izbrisati
 	vkDestroyShaderModule(_device, mainShader, nullptr);
 
 
@@ -571,9 +813,306 @@ void RenderEngine::init_compute_pipelines(){
 		vkDestroyPipelineLayout(_device, _compute_pipeline_Layout, nullptr);
 		});
 
+	_active_compute_pipeline = _default_compute_pipeline;
+
+	init_shader_variants();
+}
+
+void RenderEngine::init_shader_variants(){
+
+	const EmbeddedShader* mainShader = nullptr;
+	for (const EmbeddedShader& shader : embedded_shaders) {
+		if (strcmp(shader.name, "main_shader") == 0) mainShader = &shader;
+	}
+
+	// Varijante se grade iz ugrađenog izvora, pa nemaju smisla kada se sjenčar učitava s diska
+	if (!mainShader || !_shader_override_dir.empty()) {
+		_use_shader_variants = false;
+		return;
+	}
+
+	if (!ShaderVariantCompiler::runtime_compilation_available()) {
+		std::cout << "Program je izgraden bez biblioteke shaderc - koriste se samo vec prevedene varijante sjencara iz mape shader_cache\n";
+	}
+
+	// Poziva se iz pozadinske dretve - priručna memorija protočnih sustava je interno sinkronizirana
+	_variant_compiler.init("main_shader", mainShader->source, mainShader->source_size, "shader_cache", [this](const std::vector<uint32_t>& spirv) {
+		VkShaderModule module;
+		if (!create_shader_module(spirv.data(), spirv.size() * sizeof(uint32_t), &module)) {
+			return (VkPipeline)VK_NULL_HANDLE;
+		}
+
+		PipelineBuilder pipelineBuilder;
+		pipelineBuilder._pipelineLayout = _compute_pipeline_Layout;
+
+		VkPipelineShaderStageCreateInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		info.module = module;
+		info.pName = "main";
+		pipelineBuilder._shaderStages.push_back(info);
+
+		VkPipeline pipeline = pipelineBuilder.build_compute_pipeline(_device, _pipeline_cache);
+
+		vkDestroyShaderModule(_device, module, nullptr);
+		return pipeline;
+	});
+
+	// Dodaje se zadnje, pa se briše prije rasporeda protočnog sustava i priručne memorije o kojima ovisi
+	_main_deletion_queue.push_function([=]() {
+		_variant_compiler.cleanup();
+
+		// Varijante koje su dovršene, ali ih glavna petlja još nije preuzela
+		ShaderVariantResult result;
+		while (_variant_compiler.poll(result)) {
+			if (result.pipeline != VK_NULL_HANDLE) vkDestroyPipeline(_device, result.pipeline, nullptr);
+		}
+
+		for (auto& variant : _variant_pipelines) {
+			vkDestroyPipeline(_device, variant.second.pipeline, nullptr);
+		}
+		_variant_pipelines.clear();
+		});
+}
+
+void RenderEngine::update_shader_variant(const SceneParameters& scene){
+
+	_variant_use_counter++;
+
+	ShaderVariantResult result;
+	while (_variant_compiler.poll(result)) {
+		if (result.pipeline != VK_NULL_HANDLE) {
+			// Ista varijanta mogla je biti tražena dvaput (npr. A, B pa opet A dok se A prevodi) - druga se nije koristila
+			if (!_variant_pipelines.emplace(result.key, VariantPipeline{ result.pipeline, _variant_use_counter }).second) {
+				vkDestroyPipeline(_device, result.pipeline, nullptr);
+			}
+			_last_variant_build_ms = result.build_ms;
+			trim_variant_pipelines();
+		}
+		else {
+			// Neuspjele varijante se ne traže ponovno, ostaje opći sjenčar
+			_failed_variants.insert(result.key);
+			std::cerr << "Varijanta sjencara nije izgradena: " << result.error << "\n";
+		}
+	}
+
+	_active_compute_pipeline = _default_compute_pipeline;
+	_shader_variant_pending = false;
+
+	// Nakon ponovnog uključivanja varijanta se traži ispočetka
+	if (!scene.use_shader_variants) {
+		_requested_variant_key = 0;
+		return;
+	}
+
+	int mode = 0;
+	if (scene.do_rayleigh) mode |= 1;
+	if (scene.do_mie) mode |= 2;
+
+	std::vector<ShaderDefine> defines = {
+		{ "VARIANT_MODE", std::to_string(mode) },
+		{ "VARIANT_SAMPLE_AMOUNT_IN", std::to_string(scene.sample_amount_in) },
+		{ "VARIANT_SAMPLE_AMOUNT_OUT", std::to_string(scene.sample_amount_out) },
+		{ "VARIANT_PIXEL_SAMPLES", scene.foveation.enabled || scene.adaptive.enabled || scene.sample_factor < 1 ? "1" : "0" }
+	};
+	uint64_t key = _variant_compiler.key_for(defines);
+
+	auto found = _variant_pipelines.find(key);
+	if (found != _variant_pipelines.end()) {
+		found->second.last_used = _variant_use_counter;
+		_active_compute_pipeline = found->second.pipeline;
+		return;
+	}
+
+	if (_failed_variants.count(key) != 0) return;
+	_shader_variant_pending = true;
+
+	// Traži se samo zadnja kombinacija postavki - međukoraci (npr. pri klikanju po broju iteracija) se preskaču
+	if (key != _requested_variant_key) {
+		_variant_compiler.request(key, defines);
+		_requested_variant_key = key;
+	}
+}
+
+// Svaka vrijednost iteracija daje novu varijantu, pa se broj živih varijanti ograničava. Izbačena varijanta mogla se
+// koristiti u slikama koje su još u letu, pa se briše tek kada ova slika ponovno dođe na red - tada su sve ranije
+// slike gotove. Ponovno tražena varijanta obično se učitava iz priručne memorije na disku
+void RenderEngine::trim_variant_pipelines(){
+	while (_variant_pipelines.size() > _max_variant_pipelines) {
+		auto oldest = _variant_pipelines.end();
+		for (auto it = _variant_pipelines.begin(); it != _variant_pipelines.end(); ++it) {
+			if (it->second.pipeline == _active_compute_pipeline) continue;
+			if (oldest == _variant_pipelines.end() || it->second.last_used < oldest->second.last_used) oldest = it;
+		}
+		if (oldest == _variant_pipelines.end()) return;
+
+		VkPipeline pipeline = oldest->second.pipeline;
+		_frames[_current_frame]._deletion_queue.push_function([=]() {
+			vkDestroyPipeline(_device, pipeline, nullptr);
+			});
+		_variant_pipelines.erase(oldest);
+	}
+}
+
+// Zaglavlje koje se zapisuje ispred podataka priručne memorije protočnih sustava.
+// Služi za prepoznavanje oštećenih, skraćenih ili datoteka nekog drugog uređaja/upravljačkog programa
+struct PipelineCacheFileHeader {
+	uint32_t magic;
+	uint32_t driver_version;
+	uint8_t device_uuid[VK_UUID_SIZE];
+	uint64_t data_size;
+	uint64_t data_hash;
+};
+
+static const uint32_t pipeline_cache_magic = 0x50435348; // "PCSH"
+
+static uint64_t fnv1a_hash(const uint8_t* data, size_t size){
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++){
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static void get_device_identity(VkPhysicalDevice gpu, VkPhysicalDeviceProperties& props, uint8_t device_uuid[VK_UUID_SIZE]){
+	VkPhysicalDeviceIDProperties idProperties = {};
+	idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties2 = {};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &idProperties;
+	vkGetPhysicalDeviceProperties2(gpu, &properties2);
+
+	props = properties2.properties;
+	memcpy(device_uuid, idProperties.deviceUUID, VK_UUID_SIZE);
+}
+
+void RenderEngine::init_pipeline_cache(){
+
+	VkPhysicalDeviceProperties props;
+	uint8_t device_uuid[VK_UUID_SIZE];
+	get_device_identity(_physical_GPU, props, device_uuid);
+
+	// Ime datoteke ovisi o uređaju i verziji upravljačkog programa
+	std::ostringstream name;
+	name << "pipeline_cache_" << std::hex << std::setfill('0');
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++) name << std::setw(2) << (int)device_uuid[i];
+	name << "_" << std::dec << props.driverVersion << ".bin";
+	_pipeline_cache_path = name.str();
+
+
+	std::vector<uint8_t> initial_data;
+
+	std::ifstream file(_pipeline_cache_path, std::ios::ate | std::ios::binary);
+	if (file.is_open()) {
+		size_t fileSize = (size_t)file.tellg();
+		std::vector<uint8_t> contents(fileSize);
+		file.seekg(0);
+		file.read((char*)contents.data(), fileSize);
+		file.close();
+
+		bool valid = fileSize >= sizeof(PipelineCacheFileHeader);
+
+		PipelineCacheFileHeader header = {};
+		if (valid) {
+			memcpy(&header, contents.data(), sizeof(header));
+			const uint8_t* data = contents.data() + sizeof(header);
+			size_t data_size = fileSize - sizeof(header);
+
+			valid = header.magic == pipeline_cache_magic &&
+				header.driver_version == props.driverVersion &&
+				memcmp(header.device_uuid, device_uuid, VK_UUID_SIZE) == 0 &&
+				header.data_size == data_size &&
+				header.data_hash == fnv1a_hash(data, data_size);
+		}
+
+		// Provjera Vulkanovog zaglavlja (VkPipelineCacheHeaderVersionOne) - upravljački program bi ga trebao sam provjeriti,
+		// ali neki se ruše na neispravnim podacima
+		if (valid) {
+			const uint8_t* data = contents.data() + sizeof(header);
+			uint32_t vk_header[4];
+
+			valid = header.data_size >= sizeof(vk_header) + VK_UUID_SIZE;
+			if (valid) {
+				memcpy(vk_header, data, sizeof(vk_header));
+				valid = vk_header[0] >= sizeof(vk_header) + VK_UUID_SIZE &&
+					vk_header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+					vk_header[2] == props.vendorID &&
+					vk_header[3] == props.deviceID &&
+					memcmp(data + sizeof(vk_header), props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+			}
+		}
+
+		if (valid) {
+			initial_data.assign(contents.begin() + sizeof(header), contents.end());
+		}
+		else {
+			std::cout << "Prirucna memorija protocnih sustava ('" << _pipeline_cache_path << "') je ostecena ili ne odgovara uredaju - ignorira se\n";
+		}
+	}
+
+
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.pNext = nullptr;
+	cacheInfo.flags = 0;
+	cacheInfo.initialDataSize = initial_data.size();
+	cacheInfo.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+
+	if (vkCreatePipelineCache(_device, &cacheInfo, nullptr, &_pipeline_cache) != VK_SUCCESS) {
+		// Upravljački program je odbio podatke - kreće se od prazne memorije
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		initial_data.clear();
+		VK_CHECK(vkCreatePipelineCache(_device, &cacheInfo, nullptr, &_pipeline_cache));
+	}
+
+	_pipeline_cache_loaded = !initial_data.empty();
+
+	_main_deletion_queue.push_function([=]() {
+		vkDestroyPipelineCache(_device, _pipeline_cache, nullptr);
+		});
+}
+
+void RenderEngine::save_pipeline_cache(){
+	if (_pipeline_cache == VK_NULL_HANDLE) return;
+
+	size_t data_size = 0;
+	if (vkGetPipelineCacheData(_device, _pipeline_cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0) return;
+
+	std::vector<uint8_t> data(data_size);
+	if (vkGetPipelineCacheData(_device, _pipeline_cache, &data_size, data.data()) != VK_SUCCESS) return;
+	data.resize(data_size);
+
+	VkPhysicalDeviceProperties props;
+	PipelineCacheFileHeader header = {};
+	get_device_identity(_physical_GPU, props, header.device_uuid);
+
+	header.magic = pipeline_cache_magic;
+	header.driver_version = props.driverVersion;
+	header.data_size = data.size();
+	header.data_hash = fnv1a_hash(data.data(), data.size());
+
+	// Zapisivanje u privremenu datoteku pa preimenovanje - prekid pisanja ne ostavlja napola zapisanu datoteku
+	std::string temp_path = _pipeline_cache_path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			std::cerr << "Prirucna memorija protocnih sustava nije mogla biti spremljena u '" << temp_path << "'\n";
+			return;
+		}
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)data.data(), data.size());
+	}
+
+	std::remove(_pipeline_cache_path.c_str());
+	if (std::rename(temp_path.c_str(), _pipeline_cache_path.c_str()) != 0) {
+		std::cerr << "Prirucna memorija protocnih sustava nije mogla biti spremljena u '" << _pipeline_cache_path << "'\n";
+	}
 }
 
-VkPipeline RenderEngine::PipelineBuilder::build_compute_pipeline(VkDevice device) {
+VkPipeline RenderEngine::PipelineBuilder::build_compute_pipeline(VkDevice device, VkPipelineCache cache) {
 
 
 	VkComputePipelineCreateInfo pipelineInfo = {};
@@ -586,7 +1125,7 @@ VkPipeline RenderEngine::PipelineBuilder::build_compute_pipeline(VkDevice device
 
 	VkPipeline newPipeline;
 	if (vkCreateComputePipelines(
-		device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
+		device, cache, 1, &pipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
 		std::cerr << "Greska pri stvaranju protocnog sustava\n";
 		return VK_NULL_HANDLE;
 	}
@@ -598,19 +1137,37 @@ VkPipeline RenderEngine::PipelineBuilder::build_compute_pipeline(VkDevice device
 
 
 void RenderEngine::init_swapchain(){
+
+	// Dohvaćanje načina prezentacije koje površina prozora podržava. Popis se ne mijenja, pa se dohvaća samo jednom -
+	// sučelje ga čita s glavne dretve dok dretva iscrtavanja mijenja swapchain
+	if (_supported_present_modes.empty()) {
+		uint32_t present_mode_count = 0;
+		vkGetPhysicalDeviceSurfacePresentModesKHR(_physical_GPU, _window_surface, &present_mode_count, nullptr);
+		_supported_present_modes.resize(present_mode_count);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(_physical_GPU, _window_surface, &present_mode_count, _supported_present_modes.data());
+	}
+
+	// MAILBOX bez treće slike blokira isto kao FIFO, ostali načini rade s minimalnim brojem slika
+	uint32_t min_image_count = _max_frames_in_flight;
+	if (_requested_present_mode == VK_PRESENT_MODE_MAILBOX_KHR) min_image_count = _max_frames_in_flight + 1;
+
 	vkb::SwapchainBuilder swapchainBuilder{ _physical_GPU, _device, _window_surface };
 
 	vkb::Swapchain vkbSwapchain = swapchainBuilder
 		.use_default_format_selection()
 
-		.set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
-		// Puno istodobnih frameova moe uzrokovati latenciju
-		.set_desired_min_image_count(_max_frames_in_flight)
+		.set_desired_present_mode(_requested_present_mode)
+		// FIFO je jedini način koji svaka površina mora podržavati
+		.add_fallback_present_mode(VK_PRESENT_MODE_FIFO_KHR)
+		// Puno istodobnih frameova može uzrokovati latenciju
+		.set_desired_min_image_count(min_image_count)
 
 		.set_desired_extent(_windowExtent.width, _windowExtent.height)
-		// Traeni format i mogunosti slike
+		// Traženi format i mogućnosti slike
 		.set_desired_format({VK_FORMAT_R32G32B32A32_SFLOAT, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR})
 		.set_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT|VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+		// Pri promjeni veličine stari swapchain se predaje novom, kako bi slike u letu mogle završiti prikaz
+		.set_old_swapchain(_swapchain)
 		.build()
 		.value();
 
@@ -623,15 +1180,23 @@ void RenderEngine::init_swapchain(){
 
 	_swapchain_image_format = vkbSwapchain.image_format;
 
-	// Dodavanje funkcija za ienje
+	_present_mode = vkbSwapchain.present_mode;
+	if (_present_mode != _requested_present_mode) {
+		std::cout << "Trazeni nacin prezentacije (" << present_mode_name(_requested_present_mode) << ") nije podrzan, koristi se "
+			<< present_mode_name(_present_mode) << "\n";
+	}
+
+	// Dodavanje funkcija za čišćenje - s kopijama, jer se stari swapchain briše tek nakon što je novi stvoren
+	VkSwapchainKHR swapchain = _swapchain;
 	_swapchain_deletion_queue.push_function([=]() {
-		vkDestroySwapchainKHR(_device, _swapchain, nullptr);
+		vkDestroySwapchainKHR(_device, swapchain, nullptr);
 		});
 
 	for (int i = 0; i < _swapchain_images.size(); i++) {
 
+		VkImageView view = _swapchain_image_views[i];
 		_swapchain_deletion_queue.push_function([=]() {
-			vkDestroyImageView(_device, _swapchain_image_views[i], nullptr);
+			vkDestroyImageView(_device, view, nullptr);
 			});
 	}
 }
@@ -659,8 +1224,10 @@ void RenderEngine::init_framebuffers(){
 			throw std::runtime_error("failed to create framebuffer!");
 		}
 
-		_main_deletion_queue.push_function([=]() {
-			vkDestroyFramebuffer(_device, _framebuffers[i], nullptr);
+		// Framebufferi ovise o slikama swapchaina, pa se brišu zajedno s njim
+		VkFramebuffer framebuffer = _framebuffers[i];
+		_swapchain_deletion_queue.push_function([=]() {
+			vkDestroyFramebuffer(_device, framebuffer, nullptr);
 			});
 	}
 
@@ -678,7 +1245,7 @@ void RenderEngine::init_command_buffers(){
 	commandPoolInfo_compute.queueFamilyIndex = _compute_queue_family;
 	commandPoolInfo_compute.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-	// Za grafike naredbe
+	// Za grafičke naredbe
 	VkCommandPoolCreateInfo commandPoolInfo_graphics;
 	commandPoolInfo_graphics.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	commandPoolInfo_graphics.pNext = nullptr;
@@ -709,7 +1276,7 @@ void RenderEngine::init_command_buffers(){
 			});
 
 
-		// Grafiki (za prikazivanje slika nakon izrauna)
+		// Grafički (za prikazivanje slika nakon izračuna)
 		VK_CHECK(vkCreateCommandPool(_device, &commandPoolInfo_graphics, nullptr, &_frames[i]._graphics_command_pool));
 
 		VkCommandBufferAllocateInfo cmdAllocInfo_graphics;
@@ -739,7 +1306,7 @@ void RenderEngine::init_sync_structures(){
 	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceCreateInfo.pNext = nullptr;
 	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-	// Signalna zastava omoguuje ekanje da ograda bude dovrena prije koritenja GPU naredbe po prvi put
+	// Signalna zastava omogućuje čekanje da ograda bude dovršena prije korištenja GPU naredbe po prvi put
 
 	VkSemaphoreCreateInfo semaphoreCreateInfo;
 	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -781,90 +1348,501 @@ void RenderEngine::init_sync_structures(){
 
 void RenderEngine::run(){
 
+	if (!_input_record_path.empty()) {
+		if (_input_recorder.start(_input_record_path, replay_fields())) std::cout << "Snimanje unosa u '" << _input_record_path << "' zapoceto\n";
+		else std::cerr << "Snimka unosa '" << _input_record_path << "' ne moze se stvoriti\n";
+	}
+
+	if (!_input_replay_path.empty()) {
+		std::string error;
+		if (!_input_player.load(_input_replay_path, replay_fields(), error)) {
+			std::cerr << error << "\n";
+			return;
+		}
+		std::cout << "Ponavljanje snimke '" << _input_replay_path << "'\n";
+	}
+
+	// Trajanje svake ponovljene slike i slike putanje (bez čekanja na sljedeći korak) - za usporedbu verzija programa
+	bool measure_frames = _input_player.active() || !_camera_path.empty();
+	std::vector<double> measured_frame_ms;
+	std::chrono::steady_clock::time_point replay_deadline = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point last_frame_start = std::chrono::steady_clock::now();
+	uint64_t path_frame = 0;
+
+	// Izmjereno trajanje mora uključivati snimanje i slanje naredbi, kao u verzijama bez dretve iscrtavanja, pa se
+	// mjerene slike iscrtavaju na glavnoj dretvi
+	if (_use_render_thread && measure_frames) std::cout << "Mjerenje trajanja slika - iscrtavanje na glavnoj dretvi\n";
+	if (_use_render_thread && !measure_frames) start_render_thread();
 
-	while (!should_quit){
+	while (!should_quit && !_render_thread_failed){
+
+		// Kraj putanje završava program
+		double path_time = path_frame / _camera_path_fps;
+		if (!_camera_path.empty() && path_time > _camera_path.duration()) break;
+
+		// Vrijeme mirovanja ne ulazi u simulaciju - kamera se nakon buđenja ne pomiče za cijelo čekanje
+		if (!_input_player.active() && _camera_path.empty() && wait_while_idle()) last_frame_start = std::chrono::steady_clock::now();
+
+		// Svaka slika preuzima stanje sljedeće snimljene slike, a kraj snimke završava program
+		if (_input_player.active()) {
+			if (!_input_player.next_frame()) break;
+
+			if (_replay_step_ms != 0) {
+				double step_s = _replay_step_ms > 0 ? _replay_step_ms / 1000.0 : _input_player.recorded_dt();
+				replay_deadline += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(step_s));
+				_frame_pacer.sleep_until(replay_deadline);
+			}
+		}
+		else {
+			_frame_pacer.wait();
+		}
+
+		// Sljedeća slika gradi se tek kada je dretva iscrtavanja preuzela prošlu, pa unos nije stariji nego što mora biti
+		wait_for_render_thread();
+
+		std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+		double frame_dt = std::chrono::duration<double>(frame_start - last_frame_start).count();
+		last_frame_start = frame_start;
+
+		// Zaokruženo na mikrosekunde kao u snimci unosa, da ponovljena simulacija bude jednaka izvornoj
+		frame_dt = std::round(frame_dt * 1e6) / 1e6;
+
+		// Pri ponavljanju simulacija dobiva snimljeno trajanje slike (ili stalni korak), pa ne ovisi o brzini ponavljanja
+		if (_input_player.active()) frame_dt = _replay_step_ms > 0 ? _replay_step_ms / 1000.0 : _input_player.recorded_dt();
 	
+		_performance_hud.begin_frame();
+
+		// Procesiranje korisničkog inputa
+		{
+			PerformanceHud::Scope scope(_performance_hud, PerformanceHud::PhaseInput);
+			TRACE_SCOPE("unos");
+			handle_input();
+
+			// Pri ponavljanju tipkovnica i miš ne pomiču kameru
+			if (_input_player.active()) _input_player.apply(ReplayGroup::Input);
+		}
+
+		{
+			PerformanceHud::Scope scope(_performance_hud, PerformanceHud::PhaseMovement);
+			TRACE_SCOPE("kretanje");
+			if (!_camera_path.empty()) apply_camera_path(path_time);
+			else process_movement(frame_dt);
+			path_frame++;
+		}
+
+		// Izgradnja sučelja
+		{
+			PerformanceHud::Scope scope(_performance_hud, PerformanceHud::PhaseGui);
+			TRACE_SCOPE("sucelje");
 
-		// Procesiranje korisnikog inputa
-		handle_input();
+			ImGui_ImplVulkan_NewFrame();
+			ImGui_ImplSDL2_NewFrame();
+			ImGui::NewFrame();
 
-		process_movement();
+			_render_status.update();
+			show_gui();
 
-		ImGui_ImplVulkan_NewFrame();
-		ImGui_ImplSDL2_NewFrame();
-		ImGui::NewFrame();
+			ImGui::Render();
+		}
 
-		show_gui();
+		// Promjene iz sučelja se pri ponavljanju zamjenjuju snimljenima
+		if (_input_player.active()) _input_player.apply(ReplayGroup::Parameter);
+		_input_recorder.record_frame(frame_dt);
 
 
 		if (prev_frame_atmosphere.surface_pressure_pa != main_planet.atmosphere.surface_pressure_pa || 
 			prev_frame_atmosphere.temperature != main_planet.atmosphere.temperature || 
 			prev_frame_atmosphere.refractivity != main_planet.atmosphere.refractivity
 			){
+			TRACE_SCOPE("racunanje_K");
 			recalculate_K();
 		
 		}
 
 
-		ImGui::Render();
-		compute();
+		publish_snapshot();
 
 		prev_frame_atmosphere = main_planet.atmosphere;
 
+		if (measure_frames) measured_frame_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
 	}
 
+	stop_render_thread();
 
-}
-
-void RenderEngine::recalculate_K(){
+	if (_input_recorder.active()) {
+		std::cout << "Snimanje unosa zavrseno (" << _input_recorder.frame_count() << " slika)\n";
+		_input_recorder.stop();
+	}
 
+	if (!_input_player.error().empty()) std::cerr << _input_player.error() << "\n";
 
-	double surface_mole_number =  (main_planet.atmosphere.surface_pressure_pa * (1*1*1)) / (8.3144621 * main_planet.atmosphere.temperature);
-	double num_air_particles_2 = surface_mole_number  * (6.02214076 * pow(10,23)) /*Avogadrova konstanta*/;
-	double surface_molecule_density = num_air_particles_2 / (1*1*1);
+	if (measure_frames) {
+		FrameTimeStats stats = compute_frame_time_stats(measured_frame_ms);
+		std::cout << std::fixed << std::setprecision(3) << "Iscrtano " << stats.count << " slika: prosjek " << stats.mean << " ms, p50 " << stats.p50
+			<< " ms, p95 " << stats.p95 << " ms, p99 " << stats.p99 << " ms, najvise " << stats.max << " ms" << std::defaultfloat << std::setprecision(6) << "\n";
+	}
 
+	print_gpu_profile();
 
-	double pi = 3.141592654;
-	K = 2 * pi * pi * (main_planet.atmosphere.refractivity*main_planet.atmosphere.refractivity - 1) * (main_planet.atmosphere.refractivity*main_planet.atmosphere.refractivity - 1) / surface_molecule_density / 3.0f;
+	// Greška na dretvi iscrtavanja (npr. izgubljen uređaj) završava program kao da se dogodila na glavnoj dretvi
+	if (_render_thread_error) std::rethrow_exception(_render_thread_error);
+}
 
+void RenderEngine::start_render_thread(){
+	_render_thread_stop = false;
+	_render_thread_failed = false;
+	_render_thread_error = nullptr;
+	_render_thread = std::thread(&RenderEngine::render_thread_loop, this);
 }
 
-void RenderEngine::show_gui(){
+void RenderEngine::stop_render_thread(){
+	if (!_render_thread.joinable()) return;
 
-	if (!_config_mode){
-		if (!_hide_GUI){
-			ImGui::Begin("Opis", 0, 
-				ImGuiWindowFlags_NoBackground | 
-				ImGuiWindowFlags_AlwaysAutoResize | 
-				ImGuiWindowFlags_NoCollapse | 
-				ImGuiWindowFlags_NoDecoration | 
-				ImGuiWindowFlags_NoMove
+	_render_thread_stop = true;
+	wake_render_waiters();
+	_render_thread.join();
+}
 
-			);
-			const ImVec2 pos {0,0};
-		
-			ImGui::SetWindowPos("Opis", pos);
-			const ImVec4 textCol {1,1,1,1};
-			ImGui::TextColored(textCol, "Pritisnite \"ESC\" za mijenjanje parametara, ili \"F1\" za skrivanje/pokazivanje ovog teksta ");
-		
-			ImGui::End();
-		}
+// Stanje koje se čeka mijenja se atomarno izvan mutexa, pa se mutex zauzme prije obavijesti -
+// inače bi obavijest mogla stići između provjere uvjeta i početka čekanja
+void RenderEngine::wake_render_waiters(){
+	{
+		std::lock_guard<std::mutex> lock(_render_wake_mutex);
 	}
-	else{
-		ImGui::Begin("Kontrole", 0, 
-			ImGuiWindowFlags_AlwaysAutoResize 
-		);
+	_render_wake.notify_all();
+}
 
-		ImGui::SeparatorText("Kontrole simulacije");
+void RenderEngine::render_thread_loop(){
 
-		ImGui::SliderFloat("Brzina kamere", &camera_speed, 0.025,  100, "%.3f", ImGuiSliderFlags_Logarithmic);
+	TraceRecorder::instance().set_thread_name("iscrtavanje");
 
-		ImGui::InputInt("Broj iteracija zrake", &sample_amount_in,1,10);
-		ImGui::InputInt("Broj iteracija tlaka", &sample_amount_out,1,10);
+	try {
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(_render_wake_mutex);
+				_render_wake.wait(lock, [&]() { return _render_thread_stop || _snapshots.has_new(); });
+			}
+			// Zadnja objavljena slika (npr. kraj putanje) iscrtava se i nakon zahtjeva za zaustavljanje
+			if (!_snapshots.has_new()) break;
 
-		ImGui::Checkbox("Rayleigh simulacija", &do_rayleigh);
+			// Preuzimanjem zadnje snimke stanja glavna dretva smije početi graditi sljedeću sliku
+			_snapshots.update();
+			wake_render_waiters();
+
+			const RenderSnapshot& snapshot = _snapshots.read_buffer();
+			render_snapshot(snapshot);
+
+			_rendered_sequence = snapshot.sequence;
+			wake_render_waiters();
+		}
+	}
+	catch (...) {
+		// Greška se ponovno baca na glavnoj dretvi kada petlja završi
+		_render_thread_error = std::current_exception();
+		_render_thread_failed = true;
+		wake_render_waiters();
+	}
+}
+
+// Glavna dretva čeka dok dretva iscrtavanja ne preuzme prošlu snimku stanja. Tako se slike ne preskaču, a dok
+// dretva iscrtavanja snima i šalje naredbe, glavna već obrađuje unos i gradi sučelje sljedeće slike
+void RenderEngine::wait_for_render_thread(){
+	if (!_render_thread.joinable()) return;
+
+	TRACE_SCOPE("cekanje_iscrtavanja");
+	std::unique_lock<std::mutex> lock(_render_wake_mutex);
+	_render_wake.wait_for(lock, std::chrono::milliseconds(_render_wait_ms), [&]() { return _render_thread_failed || !_snapshots.has_new(); });
+}
+
+// Sve što dretva iscrtavanja treba od glavne dretve, osim sučelja
+void RenderEngine::fill_snapshot(RenderSnapshot& snapshot){
+	snapshot.sequence = ++_snapshot_sequence;
+	snapshot.scene = scene_parameters();
+
+	int width, height;
+	SDL_GetWindowSize(_window, &width, &height);
+	snapshot.window_width = (unsigned int)std::max(width, 0);
+	snapshot.window_height = (unsigned int)std::max(height, 0);
+	snapshot.window_minimized = (SDL_GetWindowFlags(_window) & SDL_WINDOW_MINIMIZED) != 0;
+
+	snapshot.scene.foveation = foveation_parameters(width, height);
+	snapshot.scene.adaptive = _adaptive_sampling;
+
+	snapshot.resize_events = _resize_events;
+	snapshot.last_resize_event = _last_window_resize;
+	snapshot.screenshot_requests = _screenshot_requests;
+	snapshot.recording = _recording_requested;
+	snapshot.present_mode = _desired_present_mode;
+
+	// Ponavljanje unosa i putanja kamere mjere trajanje slika, pa se kvaliteta tada ne smije mijenjati
+	snapshot.dynamic_resolution = _dynamic_resolution && !_input_player.active() && _camera_path.empty();
+	snapshot.frame_budget_ms = _frame_budget_ms;
+	snapshot.full_quality = _idle_enabled && !scene_moving() && !renders_continuously();
+
+	snapshot.input = _latency.take_input();
+}
+
+FoveationParameters RenderEngine::foveation_parameters(int window_width, int window_height){
+	FoveationParameters foveation = _foveation;
+	foveation.focus_x = 0.5f;
+	foveation.focus_y = 0.5f;
+
+	// Položaj miša i točka pogleda nisu dio snimke unosa, pa ponavljanje i putanja kamere gledaju u sredinu
+	if (_input_player.active() || !_camera_path.empty()) return foveation;
+
+	// Dok miš okreće kameru, pogled je usmjeren u sredinu slike
+	if (_foveation_focus == FoveationFocus::Mouse && !SDL_GetRelativeMouseMode() && window_width > 0 && window_height > 0) {
+		int mouse_x, mouse_y;
+		SDL_GetMouseState(&mouse_x, &mouse_y);
+		foveation.focus_x = std::clamp((float)mouse_x / window_width, 0.0f, 1.0f);
+		foveation.focus_y = std::clamp((float)mouse_y / window_height, 0.0f, 1.0f);
+	}
+	// Dok uređaj ne pošalje prvu točku, fokus ostaje na sredini
+	else if (_foveation_focus == FoveationFocus::Gaze) {
+		_gaze.get(foveation.focus_x, foveation.focus_y);
+	}
+
+	return foveation;
+}
+
+void RenderEngine::publish_snapshot(){
+
+	// Bez dretve iscrtavanja slika se iscrtava odmah, a sučelje se crta izravno iz ImGui-ja
+	if (!_render_thread.joinable()) {
+		fill_snapshot(_direct_snapshot);
+		_direct_snapshot.draw_data = ImGui::GetDrawData();
+		render_snapshot(_direct_snapshot);
+		return;
+	}
+
+	TRACE_SCOPE("objava_slike");
+
+	RenderSnapshot& snapshot = _snapshots.write_buffer();
+	fill_snapshot(snapshot);
+
+	// Teksture sučelja (npr. nove znakove fonta) mijenja i ImGui na ovoj dretvi, pa se predaju samo kada ih treba
+	// ažurirati - tada se sljedeća slika ne gradi dok ova nije iscrtana
+	ImDrawData* draw_data = ImGui::GetDrawData();
+	bool textures_pending = false;
+	if (draw_data->Textures) {
+		for (ImTextureData* texture : *draw_data->Textures) {
+			if (texture->Status != ImTextureStatus_OK) textures_pending = true;
+		}
+	}
+	snapshot.copy_draw_data(draw_data, textures_pending);
+
+	uint64_t sequence = snapshot.sequence;
+	_snapshots.publish();
+	wake_render_waiters();
+
+	if (textures_pending) {
+		TRACE_SCOPE("cekanje_tekstura");
+		std::unique_lock<std::mutex> lock(_render_wake_mutex);
+		_render_wake.wait(lock, [&]() { return _render_thread_failed || _rendered_sequence >= sequence; });
+	}
+}
+
+// Iscrtava sliku iz snimke stanja - na dretvi iscrtavanja, ili na glavnoj dretvi bez nje
+void RenderEngine::render_snapshot(const RenderSnapshot& snapshot){
+
+	// Zahtjevi s glavne dretve koji još nisu preuzeti
+	if (snapshot.resize_events != _handled_resize_events) {
+		_handled_resize_events = snapshot.resize_events;
+		_resize_pending = true;
+		_last_resize_event = snapshot.last_resize_event;
+	}
+	if (snapshot.present_mode != _requested_present_mode) {
+		_requested_present_mode = snapshot.present_mode;
+		_swapchain_needs_recreate = true;
+	}
+	if (snapshot.screenshot_requests != _handled_screenshot_requests) {
+		_handled_screenshot_requests = snapshot.screenshot_requests;
+		_screenshot_requested = true;
+	}
+	if (snapshot.recording != _recording) {
+		_recording = snapshot.recording;
+		_recording_start_frame = _frame_number;
+	}
+
+	{
+		TRACE_SCOPE("slika");
+		compute(snapshot);
+	}
+
+	publish_render_status();
+}
+
+void RenderEngine::publish_render_status(){
+	RenderStatus& status = _render_status.write_buffer();
+
+	status.screen_size_x = _screen_size_x;
+	status.screen_size_y = _screen_size_y;
+
+	status.present_mode = _present_mode;
+	status.swapchain_image_count = (unsigned int)_swapchain_images.size();
+
+	status.variant_active = _active_compute_pipeline != _default_compute_pipeline;
+	status.variant_compiling = _variant_compiler.is_busy();
+	status.variant_build_ms = _last_variant_build_ms;
+
+	status.handled_resize_events = _handled_resize_events;
+	status.handled_screenshot_requests = _handled_screenshot_requests;
+	status.work_pending = _resize_pending || _swapchain_needs_recreate || _screenshot_requested;
+
+	status.render_width = _last_render_extent.width;
+	status.render_height = _last_render_extent.height;
+	status.sample_amount_in = _last_sample_amount_in;
+	status.sample_amount_out = _last_sample_amount_out;
+	status.quality_reduced = _last_quality_reduced;
+
+	_render_status.publish();
+}
+
+SceneParameters RenderEngine::scene_parameters() const{
+	SceneParameters scene;
+	scene.camera = main_camera;
+	scene.sun = sun;
+	scene.planet = main_planet;
+	scene.K = K;
+
+	scene.sample_amount_in = sample_amount_in;
+	scene.sample_amount_out = sample_amount_out;
+	scene.do_rayleigh = do_rayleigh;
+	scene.do_mie = do_mie;
+
+	scene.use_shader_variants = _use_shader_variants;
+	return scene;
+}
+
+// Sve što određuje sadržaj slike, osim veličine prozora. Promjena popisa mijenja format snimke -
+// starije snimke tada se odbijaju umjesto da se pogrešno ponove
+std::vector<ReplayField> RenderEngine::replay_fields(){
+	return {
+		{ &main_camera.position, sizeof(main_camera.position), ReplayGroup::Start },
+		{ &_simulation, sizeof(_simulation), ReplayGroup::Start },
+
+		{ &main_camera_movement, sizeof(main_camera_movement), ReplayGroup::Input },
+		{ &sun_movement, sizeof(sun_movement), ReplayGroup::Input },
+
+		{ &camera_speed, sizeof(camera_speed), ReplayGroup::Parameter },
+		{ &sample_amount_in, sizeof(sample_amount_in), ReplayGroup::Parameter },
+		{ &sample_amount_out, sizeof(sample_amount_out), ReplayGroup::Parameter },
+		{ &do_rayleigh, sizeof(do_rayleigh), ReplayGroup::Parameter },
+		{ &do_mie, sizeof(do_mie), ReplayGroup::Parameter },
+		{ &_use_shader_variants, sizeof(_use_shader_variants), ReplayGroup::Parameter },
+		{ &_foveation, sizeof(_foveation), ReplayGroup::Parameter },
+		{ &_foveation_focus, sizeof(_foveation_focus), ReplayGroup::Parameter },
+		{ &_adaptive_sampling, sizeof(_adaptive_sampling), ReplayGroup::Parameter },
+
+		{ &main_planet.radius, sizeof(main_planet.radius), ReplayGroup::Parameter },
+		{ &main_planet.atmosphere, sizeof(main_planet.atmosphere), ReplayGroup::Parameter },
+
+		{ &sun.distance, sizeof(sun.distance), ReplayGroup::Parameter },
+		{ &sun.radius, sizeof(sun.radius), ReplayGroup::Parameter },
+		{ &sun.angle, sizeof(sun.angle), ReplayGroup::Parameter },
+		{ &sun.r_wavelen, sizeof(sun.r_wavelen), ReplayGroup::Parameter },
+		{ &sun.g_wavelen, sizeof(sun.g_wavelen), ReplayGroup::Parameter },
+		{ &sun.b_wavelen, sizeof(sun.b_wavelen), ReplayGroup::Parameter },
+		{ &sun.light_intensity, sizeof(sun.light_intensity), ReplayGroup::Parameter },
+		{ &sun.light_color, sizeof(sun.light_color), ReplayGroup::Parameter },
+	};
+}
+
+// Prvi pritisak započinje snimanje unosa, drugi ga završava
+void RenderEngine::toggle_input_recording(){
+
+	if (_input_recorder.active()) {
+		std::cout << "Snimanje unosa zavrseno (" << _input_recorder.frame_count() << " slika)\n";
+		_input_recorder.stop();
+		return;
+	}
+
+	std::ostringstream path;
+	path << _capture_dir << "/unos_" << std::setw(4) << std::setfill('0') << _input_recording_counter++ << ".bin";
+	if (_input_recorder.start(path.str(), replay_fields())) std::cout << "Snimanje unosa u '" << path.str() << "' zapoceto\n";
+	else std::cerr << "Snimka unosa '" << path.str() << "' ne moze se stvoriti\n";
+}
+
+void RenderEngine::recalculate_K(){
+
+
+	double surface_mole_number =  (main_planet.atmosphere.surface_pressure_pa * (1*1*1)) / (8.3144621 * main_planet.atmosphere.temperature);
+	double num_air_particles_2 = surface_mole_number  * (6.02214076 * pow(10,23)) /*Avogadrova konstanta*/;
+	double surface_molecule_density = num_air_particles_2 / (1*1*1);
+
+
+	double pi = 3.141592654;
+	K = 2 * pi * pi * (main_planet.atmosphere.refractivity*main_planet.atmosphere.refractivity - 1) * (main_planet.atmosphere.refractivity*main_planet.atmosphere.refractivity - 1) / surface_molecule_density / 3.0f;
+
+}
+
+void RenderEngine::show_gui(){
+
+	const RenderStatus& status = _render_status.read_buffer();
+
+	if (!_config_mode){
+		if (!_hide_GUI){
+			ImGui::Begin("Opis", 0, 
+				ImGuiWindowFlags_NoBackground | 
+				ImGuiWindowFlags_AlwaysAutoResize | 
+				ImGuiWindowFlags_NoCollapse | 
+				ImGuiWindowFlags_NoDecoration | 
+				ImGuiWindowFlags_NoMove
+
+			);
+			const ImVec2 pos {0,0};
+		
+			ImGui::SetWindowPos("Opis", pos);
+			const ImVec4 textCol {1,1,1,1};
+			ImGui::TextColored(textCol, "Pritisnite \"ESC\" za mijenjanje parametara, ili \"F1\" za skrivanje/pokazivanje ovog teksta ");
+
+			LatencyTracker::Stats latency = _latency.get_stats();
+			if (latency.present_wait_supported){
+				ImGui::TextColored(textCol, "Latencija unos->prikaz: %.1f ms (max %.1f ms)", latency.input_to_present_ms, latency.input_to_present_max_ms);
+			}
+			else{
+				ImGui::TextColored(textCol, "Latencija unos->slanje: %.1f ms", latency.input_to_submit_ms);
+			}
+		
+			ImGui::End();
+		}
+	}
+	else{
+		ImGui::Begin("Kontrole", 0, 
+			ImGuiWindowFlags_AlwaysAutoResize 
+		);
+
+		ImGui::SeparatorText("Kontrole simulacije");
+
+		ImGui::SliderFloat("Brzina kamere", &camera_speed, 0.025,  100, "%.3f", ImGuiSliderFlags_Logarithmic);
+
+		int fps_limit = (int)_frame_pacer.limit();
+		if (ImGui::InputInt("Ogranicenje slika u sekundi (0 - bez)", &fps_limit, 10, 60)){
+			_frame_pacer.set_limit(std::max(fps_limit, 0));
+		}
+
+		ImGui::InputInt("Broj iteracija zrake", &sample_amount_in,1,10);
+		ImGui::InputInt("Broj iteracija tlaka", &sample_amount_out,1,10);
+
+		ImGui::Checkbox("Rayleigh simulacija", &do_rayleigh);
 		ImGui::Checkbox("Aerosolna Mie simulacija", &do_mie);
 
+		// Varijante se ne grade kada se sjenčari učitavaju s diska
+		if (_shader_override_dir.empty()){
+			ImGui::Checkbox("Specijalizirane varijante sjencara", &_use_shader_variants);
+		}
+		if (_use_shader_variants){
+			if (status.variant_active){
+				ImGui::Text("Aktivna varijanta (izgradena za %.0f ms)", status.variant_build_ms);
+			}
+			else if (status.variant_compiling){
+				ImGui::Text("Varijanta se prevodi - koristi se opci sjencar");
+			}
+			else{
+				ImGui::Text("Varijanta nije dostupna - koristi se opci sjencar");
+			}
+		}
+
 		ImGui::SeparatorText("Kontrole planeta");
 		ImGui::InputFloat("Radijus planeta", &main_planet.radius, 1000, 1000 * 100, "%.0f m");
 		
@@ -894,6 +1872,79 @@ void RenderEngine::show_gui(){
 		ImGui::SliderFloat("Valna duljina plave komponente", &sun.b_wavelen, 10,  2000, "%.2f nm");
 
 
+		ImGui::SeparatorText("Kontrole prikaza");
+
+		ImGui::Checkbox("Mirovanje kada se slika ne mijenja", &_idle_enabled);
+
+		ImGui::Checkbox("Dinamicka razlucivost", &_dynamic_resolution);
+		if (_dynamic_resolution){
+			float budget_ms = (float)_frame_budget_ms;
+			if (ImGui::SliderFloat("Najdulja slika na GPU-u", &budget_ms, 4.0f, 50.0f, "%.1f ms")){
+				_frame_budget_ms = budget_ms;
+			}
+			ImGui::Text("Sjencar: %ux%u, %d/%d iteracija", status.render_width, status.render_height, status.sample_amount_in, status.sample_amount_out);
+		}
+
+		ImGui::Checkbox("Foveacija", &_foveation.enabled);
+		if (_foveation.enabled){
+			const FoveationFocus focuses[] = { FoveationFocus::Center, FoveationFocus::Mouse, FoveationFocus::Gaze };
+
+			if (ImGui::BeginCombo("Tocka fokusa", foveation_focus_name(_foveation_focus))){
+				for (FoveationFocus focus : focuses){
+					if (ImGui::Selectable(foveation_focus_name(focus), focus == _foveation_focus)){
+						_foveation_focus = focus;
+						if (focus == FoveationFocus::Gaze) _gaze.start();
+					}
+				}
+				ImGui::EndCombo();
+			}
+			ImGui::SliderFloat("Polumjer fovee", &_foveation.radius, 0.02f, 1.0f, "%.2f visine");
+			ImGui::SliderFloat("Sirina prijelaza", &_foveation.falloff, 0.02f, 1.0f, "%.2f visine");
+			ImGui::SliderFloat("Uzorci na rubu", &_foveation.periphery_factor, 0.05f, 1.0f, "%.2f");
+		}
+
+		ImGui::Checkbox("Prilagodljiv broj uzoraka", &_adaptive_sampling.enabled);
+		if (_adaptive_sampling.enabled){
+			ImGui::SliderFloat("Prag promjene svjetline", &_adaptive_sampling.threshold, 0.01f, 1.0f, "%.2f");
+			ImGui::SliderFloat("Najmanje uzoraka", &_adaptive_sampling.min_factor, 0.05f, 1.0f, "%.2f");
+			ImGui::Checkbox("Prikaz budzeta plocica", &_adaptive_sampling.show_tiles);
+		}
+
+		const VkPresentModeKHR present_modes[] = {
+			VK_PRESENT_MODE_FIFO_KHR,
+			VK_PRESENT_MODE_MAILBOX_KHR,
+			VK_PRESENT_MODE_IMMEDIATE_KHR,
+			VK_PRESENT_MODE_FIFO_RELAXED_KHR
+		};
+
+		if (ImGui::BeginCombo("Nacin prezentacije", present_mode_name(_desired_present_mode))){
+			for (VkPresentModeKHR mode : present_modes){
+				bool supported = std::find(_supported_present_modes.begin(), _supported_present_modes.end(), mode) != _supported_present_modes.end();
+
+				// Nepodržani načini se prikazuju, ali se ne mogu odabrati
+				// Dretva iscrtavanja mijenja swapchain kada novi način stigne u snimci stanja
+				if (ImGui::Selectable(present_mode_name(mode), mode == _desired_present_mode, supported ? 0 : ImGuiSelectableFlags_Disabled)){
+					_desired_present_mode = mode;
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::Text("Aktivni nacin: %s (%d slika)", present_mode_name(status.present_mode), (int)status.swapchain_image_count);
+
+		LatencyTracker::Stats latency = _latency.get_stats();
+		ImGui::Text("Unos -> slanje: %.2f ms", latency.input_to_submit_ms);
+		if (latency.present_wait_supported){
+			ImGui::Text("Slanje -> prikaz: %.2f ms", latency.submit_to_present_ms);
+			ImGui::Text("Unos -> prikaz: %.2f ms (max %.2f ms, %u uzoraka)", latency.input_to_present_ms, latency.input_to_present_max_ms, latency.sample_count);
+		}
+		else{
+			ImGui::Text("Unos -> prikaz: nije dostupno (nema VK_KHR_present_wait)");
+		}
+
+		ImGui::Text("Spremljene slike: %llu, preskocene: %llu%s", (unsigned long long)_readback.completed_frames(),
+			(unsigned long long)_readback.dropped_frames(), _recording_requested ? " (snimanje)" : "");
+
+
 		ImGui::End();
 		
 
@@ -913,13 +1964,18 @@ void RenderEngine::show_gui(){
 		ImGui::Text("+/- na numpadu - pomicanje sunca");
 
 		ImGui::Text("F1 - skrivanje GUI-a izvan ovog moda");
+		ImGui::Text("F2 - ploca s performansama");
+		ImGui::Text("F3 - pocetak/kraj snimanja traga izvodenja");
+		ImGui::Text("F4 - pocetak/kraj snimanja unosa za ponavljanje");
+		ImGui::Text("F11 - snimanje svih slika, F12 - slika zaslona");
 		ImGui::Text("ESC - ulaz/izlaz i konfiguracijskog moda (ovog)");
 
 		ImGui::End();
 
 	}
 
-	
+	// Ploča s performansama vidljiva je u oba načina rada
+	_performance_hud.draw(_gpu_profiler, { status.render_width, status.render_height, status.sample_amount_in, status.sample_amount_out }, _allocator);
 
 }
 
@@ -927,12 +1983,20 @@ void RenderEngine::show_gui(){
 void RenderEngine::handle_input(){
 
 
+	bool had_event = false;
+
 	SDL_Event e;
 	while ((SDL_PollEvent(&e) != 0) && !should_quit)
 	{
+		had_event = true;
 
 		ImGui_ImplSDL2_ProcessEvent(&e);
 
+		// Bilježenje vremena unosa za mjerenje latencije
+		if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP || e.type == SDL_MOUSEMOTION ||
+			e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP || e.type == SDL_MOUSEWHEEL){
+			_latency.mark_input(e.common.timestamp, SDL_GetTicks());
+		}
 
 
 		if (e.type == SDL_QUIT){
@@ -946,6 +2010,14 @@ void RenderEngine::handle_input(){
 		{
 			should_quit = true;
 		} break;
+		// Swapchain se ne mijenja za svaki događaj - tijekom povlačenja ruba prozora stiže ih desetke u sekundi
+		case (SDL_WINDOWEVENT):
+		{
+			if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED){
+				_resize_events++;
+				_last_window_resize = std::chrono::steady_clock::now();
+			}
+		} break;
 		case (SDL_KEYDOWN):
 		{
 			switch (e.key.keysym.sym)
@@ -1012,6 +2084,32 @@ void RenderEngine::handle_input(){
 				_hide_GUI = !_hide_GUI;
 
 			} break;
+			case (SDL_SCANCODE_F2):
+			{
+				_performance_hud.toggle();
+			} break;
+			case (SDL_SCANCODE_F3):
+			{
+				toggle_trace();
+			} break;
+			case (SDL_SCANCODE_F4):
+			{
+				toggle_input_recording();
+			} break;
+			case (SDL_SCANCODE_F11):
+			{
+				_recording_requested = !_recording_requested;
+				if (_recording_requested){
+					std::cout << "Snimanje u mapu '" << _capture_dir << "' zapoceto\n";
+				}
+				else{
+					std::cout << "Snimanje zavrseno\n";
+				}
+			} break;
+			case (SDL_SCANCODE_F12):
+			{
+				_screenshot_requests++;
+			} break;
 
 			default:
 				break;
@@ -1040,145 +2138,857 @@ void RenderEngine::handle_input(){
 			}
 
 
-			switch (e.key.keysym.scancode)
-			{
-			case (SDL_SCANCODE_W):
-			{
-				if (main_camera_movement.v_z == -1) main_camera_movement.v_z = 0;
-			} break;
-			case (SDL_SCANCODE_A):
-			{
-				if (main_camera_movement.v_x == -1) main_camera_movement.v_x = 0;
-			} break;
-			case (SDL_SCANCODE_S):
-			{
-				if (main_camera_movement.v_z == 1) main_camera_movement.v_z= 0;
-			} break;
-			case (SDL_SCANCODE_D):
-			{
-				if (main_camera_movement.v_x == 1) main_camera_movement.v_x = 0;
-			} break;
+			switch (e.key.keysym.scancode)
+			{
+			case (SDL_SCANCODE_W):
+			{
+				if (main_camera_movement.v_z == -1) main_camera_movement.v_z = 0;
+			} break;
+			case (SDL_SCANCODE_A):
+			{
+				if (main_camera_movement.v_x == -1) main_camera_movement.v_x = 0;
+			} break;
+			case (SDL_SCANCODE_S):
+			{
+				if (main_camera_movement.v_z == 1) main_camera_movement.v_z= 0;
+			} break;
+			case (SDL_SCANCODE_D):
+			{
+				if (main_camera_movement.v_x == 1) main_camera_movement.v_x = 0;
+			} break;
+
+			case (SDL_SCANCODE_Q):
+			{
+				if (main_camera_movement.v_y == 1) main_camera_movement.v_y = 0;
+			} break;
+			case (SDL_SCANCODE_E):
+			{
+				if (main_camera_movement.v_y == -1) main_camera_movement.v_y = 0;
+			} break;
+
+			default:
+				break;
+			}
+			
+		} break;
+		case (SDL_MOUSEMOTION):
+		{
+			if (!_config_mode){
+				main_camera_movement.yaw -= e.motion.xrel / 1000.0f;
+				main_camera_movement.pitch -= e.motion.yrel / 1000.0f;
+			}	
+		} break;
+		default:
+			break;
+		}
+
+	}
+
+	if (had_event) _frames_since_event = 0;
+	else if (_frames_since_event < _idle_settle_frames) _frames_since_event++;
+
+}
+
+// Mijenja li se slika bez novog unosa
+bool RenderEngine::scene_moving(){
+	if (_frames_since_event < _idle_settle_frames) return true;
+
+	if (main_camera_movement.v_x != 0 || main_camera_movement.v_y != 0 || main_camera_movement.v_z != 0 || sun_movement != 0) return true;
+
+	// Interpolacija još nije stigla do zadnjeg koraka simulacije
+	return _simulation.shown_position != _simulation.position || _simulation.shown_sun_angle != _simulation.sun_angle;
+}
+
+bool RenderEngine::renders_continuously(){
+	return _recording_requested || _performance_hud.visible() || TraceRecorder::instance().enabled();
+}
+
+bool RenderEngine::scene_changing(){
+	if (scene_moving()) return true;
+
+	// Zahtjevi koje dretva iscrtavanja još nije obradila (npr. swapchain čeka kraj promjene veličine prozora)
+	_render_status.update();
+	const RenderStatus& status = _render_status.read_buffer();
+	if (_screenshot_requests != status.handled_screenshot_requests || _resize_events != status.handled_resize_events || status.work_pending) return true;
+
+	// Zadnja slika iscrtana je smanjenom kvalitetom - prije mirovanja iscrtava se još jedna u punoj
+	if (status.quality_reduced) return true;
+
+	return renders_continuously();
+}
+
+// Vraća true ako je petlja čekala jer se ništa nije mijenjalo (tada se vrijeme čekanja ne smije simulirati).
+// Događaj prekida čekanje odmah, pa unos nema dodatnu latenciju
+bool RenderEngine::wait_while_idle(){
+
+	bool waited_static = false;
+
+	while (_idle_enabled && !should_quit) {
+		Uint32 flags = SDL_GetWindowFlags(_window);
+		bool visible = !(flags & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN));
+		bool focused = (flags & SDL_WINDOW_INPUT_FOCUS) != 0;
+		bool changing = scene_changing();
+
+		if (visible && focused && changing) break;
+
+		int timeout_ms = _idle_wait_ms;
+		if (visible && changing && _background_fps > 0) {
+			std::chrono::steady_clock::time_point next_frame = _last_background_frame +
+				std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / _background_fps));
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (now >= next_frame) {
+				_last_background_frame = now;
+				break;
+			}
+			timeout_ms = std::min(timeout_ms, (int)std::chrono::duration_cast<std::chrono::milliseconds>(next_frame - now).count() + 1);
+		}
+		else {
+			waited_static = true;
+		}
+
+		// Bez strukture događaja SDL samo provjerava red - događaj ostaje za handle_input
+		TRACE_SCOPE("mirovanje");
+		if (SDL_WaitEventTimeout(nullptr, timeout_ms)) break;
+	}
+
+	return waited_static;
+}
+
+void RenderEngine::process_movement(double frame_dt){
+
+	Simulation_state& state = _simulation;
+
+	if (!state.initialized || main_camera.position != state.shown_position) {
+		state.previous_position = state.position = main_camera.position;
+	}
+	if (!state.initialized || sun.angle != state.shown_sun_angle) {
+		state.previous_sun_angle = state.sun_angle = sun.angle;
+	}
+	state.initialized = true;
+
+	// Okretanje mišem se ne simulira - kamera se okreće odmah
+	update_camera_orientation();
+
+	state.accumulator += std::min(std::max(frame_dt, 0.0), _max_frame_dt);
+	while (state.accumulator >= _simulation_dt) {
+		state.previous_position = state.position;
+		state.previous_sun_angle = state.sun_angle;
+		simulation_step(_simulation_dt);
+		state.accumulator -= _simulation_dt;
+	}
+
+	float alpha = (float)(state.accumulator / _simulation_dt);
+	main_camera.position = glm::mix(state.previous_position, state.position, alpha);
+	sun.angle = glm::mix(state.previous_sun_angle, state.sun_angle, alpha);
+
+	state.shown_position = main_camera.position;
+	state.shown_sun_angle = sun.angle;
+}
+
+// Brzine su odabrane tako da pri 60 slika u sekundi odgovaraju prijašnjem pomaku po slici (750 m * brzina, 0.75°)
+void RenderEngine::simulation_step(double dt){
+
+	Simulation_state& state = _simulation;
+
+	float distance = (float)(camera_speed * 45000.0 * dt);
+	state.position += distance * main_camera_movement.v_x * main_camera.right;
+	state.position += distance * main_camera_movement.v_y * main_camera.up;
+	state.position += distance * main_camera_movement.v_z * main_camera.front;
+
+	// Prošli korak se pomiče zajedno s trenutnim, da interpolacija ne prođe unatrag kroz cijeli krug
+	state.sun_angle += (float)(sun_movement * 45.0 * dt);
+	while (state.sun_angle > 360) {
+		state.sun_angle -= 360;
+		state.previous_sun_angle -= 360;
+	}
+	while (state.sun_angle < 0) {
+		state.sun_angle += 360;
+		state.previous_sun_angle += 360;
+	}
+}
+
+// Osi kamere iz zakreta i nagiba
+void RenderEngine::update_camera_orientation(){
+	main_camera.front = glm::vec3(0.0f, 0.0f, 1.0f);
+	main_camera.up = glm::vec3(0.0f, 1.0f, 0.0f);
+	main_camera.right = glm::vec3(1.0f, 0.0f, 0.0f);
+
+	glm::mat4 rotate_matrix = glm::mat4(
+		glm::vec4(main_camera.right,0),
+		glm::vec4(main_camera.up,0),
+		glm::vec4(main_camera.front,0),
+		glm::vec4(0,0,0,1)
+	);
+
+	rotate_matrix = glm::rotate(main_camera_movement.yaw, main_camera.up) * glm::rotate(main_camera_movement.pitch, main_camera.right);
+
+	main_camera.right = rotate_matrix[0];
+	main_camera.up = rotate_matrix[1];
+	main_camera.front = rotate_matrix[2];
+}
+
+// Postavlja kameru, sunce i atmosferu prema putanji. Vrijednosti koje putanja ne zadaje ostaju kakve jesu
+void RenderEngine::apply_camera_path(double time){
+
+	CameraPath::Sample sample = _camera_path.evaluate(time);
+
+	if (sample.has[CameraPath::ChannelPositionX]) {
+		main_camera.position = glm::vec3(sample.value[CameraPath::ChannelPositionX], sample.value[CameraPath::ChannelPositionY], sample.value[CameraPath::ChannelPositionZ]);
+	}
+	if (sample.has[CameraPath::ChannelYaw]) {
+		main_camera_movement.yaw = glm::radians((float)sample.value[CameraPath::ChannelYaw]);
+		main_camera_movement.pitch = glm::radians((float)sample.value[CameraPath::ChannelPitch]);
+	}
+	update_camera_orientation();
+
+	if (sample.has[CameraPath::ChannelSunAngle]) sun.angle = (float)sample.value[CameraPath::ChannelSunAngle];
+	if (sample.has[CameraPath::ChannelLightIntensity]) sun.light_intensity = (float)sample.value[CameraPath::ChannelLightIntensity];
+
+	Atmosphere& atmosphere = main_planet.atmosphere;
+	if (sample.has[CameraPath::ChannelSurfacePressure]) atmosphere.surface_pressure_pa = (float)sample.value[CameraPath::ChannelSurfacePressure];
+	if (sample.has[CameraPath::ChannelDensityHeight]) atmosphere.average_density_height = (float)sample.value[CameraPath::ChannelDensityHeight];
+	if (sample.has[CameraPath::ChannelDensityHeightAerosol]) atmosphere.average_density_height_aerosol = (float)sample.value[CameraPath::ChannelDensityHeightAerosol];
+	if (sample.has[CameraPath::ChannelAerosolDensity]) atmosphere.aerosol_density_mul = (float)sample.value[CameraPath::ChannelAerosolDensity];
+	if (sample.has[CameraPath::ChannelMieAsymmetry]) atmosphere.mie_asymmetry_const = (float)sample.value[CameraPath::ChannelMieAsymmetry];
+	if (sample.has[CameraPath::ChannelUpperLimit]) atmosphere.upper_limit = (float)sample.value[CameraPath::ChannelUpperLimit];
+
+	// Bez prozora nema provjere promjene atmosfere iz glavne petlje
+	if (sample.has[CameraPath::ChannelSurfacePressure]) recalculate_K();
+}
+
+void RenderEngine::init_readback(){
+
+	// Spremnika mora biti više nego slika u letu, a višak određuje koliko slika može istodobno čekati na spremanje.
+	// Kodiranje slika se izvodi na dretvama za čitanje, pa bez prozora (gdje je spremanje glavni posao) dobivaju
+	// sve jezgre osim jedne, a svaka dretva svoj spremnik. Kada su svi zauzeti, slanje novih slika čeka.
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	unsigned int worker_count = _headless ? std::max(1u, cores - 1) : std::max(1u, std::min(4u, cores / 2));
+	_readback.init(_device, _allocator, _max_frames_in_flight + std::max(2u, worker_count), worker_count);
+
+#ifdef _WIN32
+	_mkdir(_capture_dir.c_str());
+#else
+	mkdir(_capture_dir.c_str(), 0755);
+#endif
+}
+
+void RenderEngine::init_gpu_profiler(){
+
+	_gpu_profiler.init(_device, _physical_GPU, _compute_queue_family, _graphics_queue_family, _max_frames_in_flight, _pipeline_statistics_enabled);
+
+	_main_deletion_queue.push_function([=]() {
+		_gpu_profiler.cleanup();
+		});
+}
+
+void RenderEngine::print_gpu_profile(){
+
+	GpuProfiler::Stats stats = _gpu_profiler.get_stats();
+	if (stats.sample_count == 0) return;
+
+	std::cout << std::fixed << std::setprecision(3) << "Prosjecno na GPU-u (zadnjih " << stats.sample_count << " slika):";
+	for (int stage = 0; stage < GpuProfiler::StageCount; stage++) {
+		// Faze koje se ne snimaju (npr. sučelje bez prozora) se ne ispisuju
+		if (stats.stage_ms[stage] > 0) std::cout << " " << GpuProfiler::stage_name((GpuProfiler::Stage)stage) << " " << stats.stage_ms[stage] << " ms,";
+	}
+	std::cout << " ukupno " << stats.total_ms << " ms (najvise " << stats.total_max_ms << " ms)";
+	if (_gpu_profiler.statistics_supported()) std::cout << ", " << stats.compute_invocations << " poziva sjencara po slici";
+	std::cout << std::defaultfloat << std::setprecision(6) << "\n";
+}
+
+// Prvi pritisak započinje snimanje traga, drugi ga zapisuje u mapu za snimke
+void RenderEngine::toggle_trace(){
+
+	TraceRecorder& trace = TraceRecorder::instance();
+	if (!trace.enabled()) {
+		trace.start();
+		std::cout << "Snimanje traga izvodenja zapoceto\n";
+		return;
+	}
+
+	trace.stop();
+	std::ostringstream path;
+	path << _capture_dir << "/trag_" << std::setw(4) << std::setfill('0') << _trace_counter++ << ".json";
+	write_trace(path.str());
+}
+
+void RenderEngine::write_trace(const std::string& path){
+	if (TraceRecorder::instance().write(path)) std::cout << "Trag izvodenja zapisan u '" << path << "'\n";
+	else std::cerr << "Trag izvodenja '" << path << "' nije uspio biti zapisan\n";
+}
+
+// Zapisuje pročitanu sliku u datoteku, red po red - poziva se na dretvi za čitanje
+static void write_readback_frame(const std::string& path, ImageFileFormat format, const ReadbackFrame& frame){
+	ImageSource source = { frame.data, frame.width, frame.height, frame.row_pitch, frame.is_float, true };
+	if (!write_image(path, format, source)) {
+		std::cerr << "Slika '" << path << "' nije uspjela biti zapisana\n";
+	}
+}
+
+void RenderEngine::capture_output_image(VkCommandBuffer cmd){
+
+	if (!_screenshot_requested && !_recording) return;
+
+	std::ostringstream path;
+	if (_screenshot_requested) {
+		path << _capture_dir << "/slika_zaslona_" << std::setw(4) << std::setfill('0') << _screenshot_counter++ << ".png";
+	}
+	else {
+		path << _capture_dir << "/snimka_" << std::setw(6) << std::setfill('0') << (_frame_number - _recording_start_frame) << ".png";
+	}
+	std::string file_path = path.str();
+
+	FrameReadback::Consumer consumer = [file_path](const ReadbackFrame& frame) {
+		write_readback_frame(file_path, ImageFileFormat::PNG, frame);
+	};
+
+	// Pri snimanju se slike koje ne stignu biti spremljene preskaču, kako se iscrtavanje ne bi usporilo.
+	// Slika zaslona se ne smije izgubiti, pa se po potrebi čeka na slobodan spremnik
+	bool wait_for_slot = _screenshot_requested;
+	if (_readback.record_copy(cmd, _frames[_current_frame]._output_image._image, _output_format, { _screen_size_x, _screen_size_y },
+		_current_frame, _frame_number, consumer, wait_for_slot) && _screenshot_requested) {
+		std::cout << "Slika zaslona se sprema u '" << file_path << "'\n";
+	}
+
+	_screenshot_requested = false;
+}
+
+void RenderEngine::submit_offscreen(const FrameReadback::Consumer& consumer){
+
+	Frame& frame = _frames[_current_frame];
+
+	{
+		TRACE_SCOPE("cekanje_ograda");
+		VK_CHECK(vkWaitForFences(_device, 1, &frame._compute_fence, true, UINT64_MAX));
+	}
+	frame._deletion_queue.flush();
+
+	// Kopije ove slike iz prošlog kruga su gotove
+	_readback.retire_frame(_current_frame);
+	if (_gpu_profiler.collect(_current_frame)) TraceRecorder::instance().add_gpu_frame(_gpu_profiler.last_frame());
+
+	// Mjerenje brzine mijenja razlučivost između slika
+	update_output_image(_current_frame);
+
+	SceneParameters scene = scene_parameters();
+	update_shader_variant(scene);
+
+	VK_CHECK(vkResetFences(_device, 1, &frame._compute_fence));
+	VK_CHECK(vkResetCommandBuffer(frame._compute_command_buffer, 0));
+
+	update_uniform_buffers(scene, { _screen_size_x, _screen_size_y });
+
+	VkCommandBufferBeginInfo cmdBeginInfo = {};
+	cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VK_CHECK(vkBeginCommandBuffer(frame._compute_command_buffer, &cmdBeginInfo));
+
+	_gpu_profiler.begin_frame(_current_frame, _frame_number);
+	_gpu_profiler.begin_stage(frame._compute_command_buffer, _current_frame, GpuProfiler::StageCompute, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = frame._output_image._image;
+	imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(frame._compute_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	_gpu_profiler.begin_statistics(frame._compute_command_buffer, _current_frame);
+	record_compute_dispatch(frame._compute_command_buffer, { _screen_size_x, _screen_size_y }, scene.adaptive.enabled);
+	_gpu_profiler.end_statistics(frame._compute_command_buffer, _current_frame);
+
+	_gpu_profiler.end_stage(frame._compute_command_buffer, _current_frame, GpuProfiler::StageCompute);
+
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(frame._compute_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	// Bez prozora se ne smije izgubiti nijedna slika - ako su svi spremnici zauzeti, čeka se potrošač
+	if (consumer) {
+		_gpu_profiler.begin_stage(frame._compute_command_buffer, _current_frame, GpuProfiler::StageCopy, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		_readback.record_copy(frame._compute_command_buffer, frame._output_image._image, _output_format, { _screen_size_x, _screen_size_y },
+			_current_frame, _frame_number, consumer, true);
+		_gpu_profiler.end_stage(frame._compute_command_buffer, _current_frame, GpuProfiler::StageCopy);
+	}
+
+	VK_CHECK(vkEndCommandBuffer(frame._compute_command_buffer));
+
+	VkSubmitInfo submit = {};
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit.commandBufferCount = 1;
+	submit.pCommandBuffers = &frame._compute_command_buffer;
+
+	_gpu_profiler.mark_submit(_current_frame);
+	VK_CHECK(vkQueueSubmit(_compute_queue, 1, &submit, frame._compute_fence));
+
+	_frame_number++;
+	_current_frame = (_current_frame + 1) % _max_frames_in_flight;
+}
+
+void RenderEngine::render_offscreen(uint8_t* pixels){
+
+	// Sjenčar piše komponente obrnutim redoslijedom (b, g, r) zbog formata swapchaina, pa se ovdje vraćaju u RGBA
+	submit_offscreen([pixels](const ReadbackFrame& frame) {
+		for (uint32_t y = 0; y < frame.height; y++) {
+			const uint8_t* src = frame.data + y * frame.row_pitch;
+			uint8_t* dst = pixels + (size_t)y * frame.width * 4;
+			for (uint32_t x = 0; x < frame.width; x++) {
+				for (int c = 0; c < 3; c++) {
+					if (frame.is_float) {
+						float value = ((const float*)src)[x * 4 + 2 - c];
+						dst[x * 4 + c] = (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+					}
+					else {
+						dst[x * 4 + c] = src[x * 4 + 2 - c];
+					}
+				}
+				dst[x * 4 + 3] = 255;
+			}
+		}
+	});
+
+	// Sinkrono sučelje - čeka se GPU i potrošač
+	VK_CHECK(vkDeviceWaitIdle(_device));
+	_readback.flush();
+}
+
+void RenderEngine::run_headless(unsigned int frame_count, const std::string& output_path){
+
+	// Kod više slika broj slike se umeće prije ekstenzije (slika.ppm -> slika_0001.ppm)
+	std::string base = output_path;
+	std::string extension;
+	size_t dot = output_path.find_last_of('.');
+	if (dot != std::string::npos && output_path.find_first_of("/\\", dot) == std::string::npos) {
+		base = output_path.substr(0, dot);
+		extension = output_path.substr(dot);
+	}
+
+	ImageFileFormat format = image_format_from_path(output_path);
+	if (image_format_is_float(format) && _output_format != VK_FORMAT_R32G32B32A32_SFLOAT) {
+		std::cout << "Napomena: slika se iscrtava u 8 bita, pa " << extension << " datoteka nece sadrzavati linearne vrijednosti\n";
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Slike se šalju bez čekanja - GPU iscrtava sljedeću dok pozadinske dretve spremaju prethodne
+	for (unsigned int i = 0; i < frame_count; i++) {
+
+		if (!_camera_path.empty()) apply_camera_path(i / _camera_path_fps);
+
+		std::string path = output_path;
+		if (frame_count > 1) {
+			std::ostringstream name;
+			name << base << "_" << std::setw(4) << std::setfill('0') << i << extension;
+			path = name.str();
+		}
+
+		// Kodiranje se izvodi na dretvama za čitanje - kada sve kasne, submit_offscreen čeka slobodan spremnik
+		submit_offscreen([path, format](const ReadbackFrame& frame) {
+			if (path.empty()) return;
+			write_readback_frame(path, format, frame);
+		});
+	}
+
+	VK_CHECK(vkDeviceWaitIdle(_device));
+	_readback.flush();
+
+	double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Iscrtano " << frame_count << " slika (" << _screen_size_x << "x" << _screen_size_y << ") za " << total_ms << " ms ("
+		<< (frame_count ? total_ms / frame_count : 0) << " ms po slici)\n";
+
+	print_gpu_profile();
+}
+
+void RenderEngine::render_cpu(unsigned int frame_count, const std::string& output_path, unsigned int thread_count){
+
+	std::string base = output_path;
+	std::string extension;
+	size_t dot = output_path.find_last_of('.');
+	if (dot != std::string::npos && output_path.find_first_of("/\\", dot) == std::string::npos) {
+		base = output_path.substr(0, dot);
+		extension = output_path.substr(dot);
+	}
+	ImageFileFormat format = image_format_from_path(output_path);
+
+	CpuRenderer renderer;
+	renderer.init(thread_count);
+	if (!renderer.set_kernel(_cpu_kernel)) {
+		std::cerr << "Procesor ne podrzava jezgru '" << CpuRenderer::kernel_name(_cpu_kernel) << "', koristi se '" << CpuRenderer::kernel_name(renderer.kernel()) << "'\n";
+	}
+	renderer.set_density_profile(_cpu_density_profile);
+	renderer.set_optical_depth(_cpu_optical_depth);
+
+	shader_input_buffer_1 camera_input;
+	shader_input_buffer_2 atmosphere_input;
+	std::vector<float> pixels((size_t)_screen_size_x * _screen_size_y * 4);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (unsigned int i = 0; i < frame_count; i++) {
+		if (!_camera_path.empty()) apply_camera_path(i / _camera_path_fps);
+
+		fill_shader_inputs(scene_parameters(), { _screen_size_x, _screen_size_y }, camera_input, atmosphere_input);
+		renderer.render(camera_input, atmosphere_input, pixels.data());
 
-			case (SDL_SCANCODE_Q):
-			{
-				if (main_camera_movement.v_y == 1) main_camera_movement.v_y = 0;
-			} break;
-			case (SDL_SCANCODE_E):
-			{
-				if (main_camera_movement.v_y == -1) main_camera_movement.v_y = 0;
-			} break;
+		if (output_path.empty()) continue;
 
-			default:
-				break;
-			}
-			
-		} break;
-		case (SDL_MOUSEMOTION):
-		{
-			if (!_config_mode){
-				main_camera_movement.yaw -= e.motion.xrel / 1000.0f;
-				main_camera_movement.pitch -= e.motion.yrel / 1000.0f;
-			}	
-		} break;
-		default:
-			break;
+		std::string path = output_path;
+		if (frame_count > 1) {
+			std::ostringstream name;
+			name << base << "_" << std::setw(4) << std::setfill('0') << i << extension;
+			path = name.str();
 		}
 
+		ImageSource source = { (const uint8_t*)pixels.data(), _screen_size_x, _screen_size_y, (size_t)_screen_size_x * 4 * sizeof(float), true, true };
+		if (!write_image(path, format, source)) {
+			std::cerr << "Slika '" << path << "' nije uspjela biti zapisana\n";
+		}
 	}
 
+	double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Iscrtano na procesoru (" << renderer.thread_count() << " dretvi, jezgra " << CpuRenderer::kernel_name(renderer.kernel())
+		<< ", profil " << CpuRenderer::density_profile_name(_cpu_density_profile) << ", opticka dubina " << CpuRenderer::optical_depth_name(_cpu_optical_depth) << ") " << frame_count << " slika (" << _screen_size_x << "x" << _screen_size_y << ") za "
+		<< total_ms << " ms (" << (frame_count ? total_ms / frame_count : 0) << " ms po slici)\n";
 
+	renderer.cleanup();
 }
 
-void RenderEngine::process_movement(){
-	main_camera.front = glm::vec3(0.0f, 0.0f, 1.0f);
-	main_camera.up = glm::vec3(0.0f, 1.0f, 0.0f);
-	main_camera.right = glm::vec3(1.0f, 0.0f, 0.0f);
+bool RenderEngine::run_regression(bool use_gpu){
 
-	glm::mat4 rotate_matrix = glm::mat4(
-		glm::vec4(main_camera.right,0),
-		glm::vec4(main_camera.up,0),
-		glm::vec4(main_camera.front,0),
-		glm::vec4(0,0,0,1)
-	);
+#ifdef _WIN32
+	_mkdir(_regression_dir.c_str());
+#else
+	mkdir(_regression_dir.c_str(), 0755);
+#endif
 
-	rotate_matrix = glm::rotate(main_camera_movement.yaw, main_camera.up) * glm::rotate(main_camera_movement.pitch, main_camera.right);
+	// Scene mijenjaju kameru, sunce, atmosferu i način raspršenja - vraćaju se na kraju
+	Camera saved_camera = main_camera;
+	Sun saved_sun = sun;
+	Planet saved_planet = main_planet;
+	bool saved_rayleigh = do_rayleigh;
+	bool saved_mie = do_mie;
 
-	main_camera.right = rotate_matrix[0];
-	main_camera.up = rotate_matrix[1];
-	main_camera.front = rotate_matrix[2];
+	CpuRenderer renderer;
+	renderer.init(0);
+
+	uint32_t width = _screen_size_x;
+	uint32_t height = _screen_size_y;
+	std::vector<float> reference((size_t)width * height * 4);
+	std::vector<float> candidate((size_t)width * height * 4);
+
+	shader_input_buffer_1 camera_input;
+	shader_input_buffer_2 atmosphere_input;
 
+	unsigned int check_count = 0;
+	unsigned int failure_count = 0;
 
-	main_camera.position += camera_speed * 750 * main_camera_movement.v_x * main_camera.right;
-	main_camera.position += camera_speed * 750 * main_camera_movement.v_y * main_camera.up;
-	main_camera.position += camera_speed * 750 * main_camera_movement.v_z * main_camera.front;
+	auto check = [&](const std::string& name, float rmse_limit, float max_limit) {
+		ImageDifference difference = compare_images(candidate.data(), reference.data(), width, height);
+		bool passed = difference.rmse <= rmse_limit && difference.max_error <= max_limit;
 
-	sun.angle += sun_movement * 0.75f;
-	while (sun.angle > 360) sun.angle -= 360;
-	while (sun.angle < 0) sun.angle += 360;
-}
+		check_count++;
+		std::cout << (passed ? "  u redu  " : "  GRESKA  ") << std::left << std::setw(44) << name << std::right
+			<< " rmse " << std::scientific << std::setprecision(2) << difference.rmse << " (" << rmse_limit << ")"
+			<< "  maks. " << difference.max_error << " (" << max_limit << ") u " << difference.max_x << "," << difference.max_y
+			<< std::defaultfloat << std::setprecision(6) << "\n";
+
+		if (!passed) {
+			failure_count++;
+			write_regression_images(_regression_dir + "/" + name, candidate.data(), reference.data(), width, height, max_limit);
+		}
+	};
 
-void RenderEngine::compute(){
+	// Svaka scena provjerava se u sva tri načina raspršenja - jezgre procesora imaju zasebnu instancu za svaki način,
+	// a sjenčar zasebna grananja
+	const std::pair<int, const char*> modes[] = { { 1, "rayleigh" }, { 2, "mie" }, { 3, "oba" } };
+
+	for (const RegressionScene& scene : regression_scenes()) {
+		apply_regression_scene(scene, main_camera, sun, main_planet);
+
+		for (const std::pair<int, const char*>& mode : modes) {
+			do_rayleigh = (mode.first & 1) != 0;
+			do_mie = (mode.first & 2) != 0;
+			std::string case_name = std::string(scene.name) + "_" + mode.second;
+
+			fill_shader_inputs(scene_parameters(), { _screen_size_x, _screen_size_y }, camera_input, atmosphere_input);
+
+			renderer.set_kernel(CpuRenderer::Kernel::Scalar);
+			renderer.render(camera_input, atmosphere_input, reference.data());
+
+			if (use_gpu) {
+				float* pixels = candidate.data();
+				submit_offscreen([pixels](const ReadbackFrame& frame) {
+					for (uint32_t y = 0; y < frame.height; y++) {
+						const uint8_t* src = frame.data + y * frame.row_pitch;
+						float* dst = pixels + (size_t)y * frame.width * 4;
+						if (frame.is_float) {
+							memcpy(dst, src, (size_t)frame.width * 4 * sizeof(float));
+						}
+						else {
+							for (uint32_t i = 0; i < frame.width * 4; i++) dst[i] = src[i] / 255.0f;
+						}
+					}
+				});
+				VK_CHECK(vkDeviceWaitIdle(_device));
+				_readback.flush();
+
+				check(case_name + "_gpu", scene.rmse_limit, scene.max_limit);
+			}
 
-	// Nije potrebno nita raditi ako je prozor minimiziran
-	if (SDL_GetWindowFlags(_window) & SDL_WINDOW_MINIMIZED){
-		return;
+			for (CpuRenderer::Kernel kernel : { CpuRenderer::Kernel::Generic, CpuRenderer::Kernel::Avx2, CpuRenderer::Kernel::Avx512 }) {
+				if (!renderer.set_kernel(kernel)) continue;
+
+				for (const RegressionVariant& variant : regression_variants()) {
+					renderer.set_density_profile(variant.profile);
+					renderer.set_optical_depth(variant.depth);
+					renderer.render(camera_input, atmosphere_input, candidate.data());
+
+					check(case_name + "_" + CpuRenderer::kernel_name(kernel) + "_" + variant.name, variant.rmse_limit, variant.max_limit);
+				}
+			}
+		}
 	}
 
+	renderer.cleanup();
 
-	// ekanje na dovretak naredba prole slike (tj. prole X-te, gdje je X maksimalan broj bufferanih slika (obino 1-3))
-	VK_CHECK(vkWaitForFences(_device, 1, &_frames[_current_frame]._compute_fence, true, 1000000000));
-	VK_CHECK(vkWaitForFences(_device, 1, &_frames[_current_frame]._gui_fence, true, 1000000000));
+	main_camera = saved_camera;
+	sun = saved_sun;
+	main_planet = saved_planet;
+	do_rayleigh = saved_rayleigh;
+	do_mie = saved_mie;
 
-	// Postavljanje komandnog spremnika
-	VK_CHECK(vkResetCommandBuffer(_frames[_current_frame]._compute_command_buffer, 0));
+	std::cout << "Provjera regresije: " << (check_count - failure_count) << "/" << check_count << " u redu";
+	if (failure_count) std::cout << ", slike razlika su u mapi '" << _regression_dir << "'";
+	std::cout << "\n";
 
+	return failure_count == 0;
+}
 
+bool RenderEngine::run_benchmark(const BenchmarkConfig& config){
 
-	// Traenje dohvata slike (u koju e se output pisati) sa swapchaina, program maksimalno eka 1 sekundu prije izlaska
-	uint32_t swapchainImageIndex;
-																					// Ovaj semafor signalizira kada je operacija gotova
-	VkResult imageResult = vkAcquireNextImageKHR(_device, _swapchain, 1000000000, _frames[_current_frame]._present_semaphore, nullptr, &swapchainImageIndex);
+	// Položaji kamere su scene provjere regresije - provjeravaju se prije mjerenja, da se greška ne otkrije tek na kraju
+	std::vector<const RegressionScene*> cameras;
+	for (const std::string& name : config.cameras) {
+		const RegressionScene* found = nullptr;
+		for (const RegressionScene& scene : regression_scenes()) {
+			if (name == scene.name) found = &scene;
+		}
+		if (!found) {
+			std::cerr << "Nepoznat polozaj kamere: " << name << "\n";
+			return false;
+		}
+		cameras.push_back(found);
+	}
 
-	// Ukoliko slika ne odgovara swapchainu (najee zbog nove veliine prozora), swapchain i prozor bi se trebali postaviti na tonu vrijednost
-	if (imageResult == VK_ERROR_OUT_OF_DATE_KHR) {
-		recreate_swapchain();
-		return;
+	Camera saved_camera = main_camera;
+	Sun saved_sun = sun;
+	Planet saved_planet = main_planet;
+	unsigned int saved_size_x = _screen_size_x;
+	unsigned int saved_size_y = _screen_size_y;
+	int saved_sample_amount_in = sample_amount_in;
+	int saved_sample_amount_out = sample_amount_out;
+	bool saved_rayleigh = do_rayleigh;
+	bool saved_mie = do_mie;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(_physical_GPU, &properties);
+
+	BenchmarkReport report;
+	report.label = config.label;
+	report.device_name = properties.deviceName;
+	report.driver_version = properties.driverVersion;
+	report.gpu_timestamps = _gpu_profiler.timestamps_supported();
+	report.warmup_frames = config.warmup_frames;
+	report.measured_frames = config.measured_frames;
+
+	using Clock = std::chrono::steady_clock;
+
+	// Sve kombinacije postavki, redom kojim se mjere
+	std::vector<std::pair<BenchmarkCase, const RegressionScene*>> combinations;
+	for (const BenchmarkResolution& resolution : config.resolutions) {
+		for (int samples_in : config.sample_amounts_in) {
+			for (int samples_out : config.sample_amounts_out) {
+				for (int mode : config.modes) {
+					for (const RegressionScene* camera : cameras) {
+						BenchmarkCase combination = {};
+						combination.resolution = resolution;
+						combination.sample_amount_in = samples_in;
+						combination.sample_amount_out = samples_out;
+						combination.mode = mode;
+						combination.camera = camera->name;
+						combinations.push_back({ combination, camera });
+					}
+				}
+			}
+		}
 	}
-	else if (imageResult != VK_SUCCESS && imageResult != VK_SUBOPTIMAL_KHR) {
-		throw std::runtime_error("Nije bilo moguce dobiti sliku sa swapchaina :(");
+
+	for (auto& combination : combinations) {
+		BenchmarkCase& result = combination.first;
+
+		_screen_size_x = result.resolution.width;
+		_screen_size_y = result.resolution.height;
+		sample_amount_in = result.sample_amount_in;
+		sample_amount_out = result.sample_amount_out;
+		do_rayleigh = (result.mode & 1) != 0;
+		do_mie = (result.mode & 2) != 0;
+		apply_regression_scene(*combination.second, main_camera, sun, main_planet);
+
+		// Mjeri se varijanta sjenčara za ove postavke - čeka se da se prevede (najviše minutu)
+		update_shader_variant(scene_parameters());
+		Clock::time_point variant_start = Clock::now();
+		while (_shader_variant_pending && Clock::now() - variant_start < std::chrono::seconds(60)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			update_shader_variant(scene_parameters());
+		}
+
+		// Zagrijavanje - nove izlazne slike, priručne memorije i takt GPU-a
+		for (unsigned int i = 0; i < config.warmup_frames; i++) {
+			submit_offscreen(nullptr);
+		}
+		VK_CHECK(vkDeviceWaitIdle(_device));
+		for (unsigned int i = 0; i < _max_frames_in_flight; i++) {
+			_gpu_profiler.collect(i);
+		}
+
+		result.shader_variant = _active_compute_pipeline != _default_compute_pipeline;
+
+		_gpu_profiler.take_recorded();
+		_gpu_profiler.set_recording(true);
+
+		// Vrijeme na procesoru je razmak između dvaju slanja - kada je GPU usko grlo, slanje čeka ogradu slike
+		std::vector<double> cpu_times;
+		cpu_times.reserve(config.measured_frames);
+		Clock::time_point previous = Clock::now();
+		for (unsigned int i = 0; i < config.measured_frames; i++) {
+			submit_offscreen(nullptr);
+
+			Clock::time_point now = Clock::now();
+			cpu_times.push_back(std::chrono::duration<double, std::milli>(now - previous).count());
+			previous = now;
+		}
+
+		// Oznake zadnjih slika u letu, od najstarije
+		VK_CHECK(vkDeviceWaitIdle(_device));
+		for (unsigned int i = 0; i < _max_frames_in_flight; i++) {
+			_gpu_profiler.collect((_current_frame + i) % _max_frames_in_flight);
+		}
+		_gpu_profiler.set_recording(false);
+
+		std::vector<double> gpu_times;
+		uint64_t invocations = 0;
+		for (const GpuProfiler::FrameTimes& times : _gpu_profiler.take_recorded()) {
+			if (times.stage_valid[GpuProfiler::StageCompute]) gpu_times.push_back(times.stage_ms[GpuProfiler::StageCompute]);
+			if (times.has_statistics) invocations = times.compute_invocations;
+		}
+		result.compute_invocations = invocations;
+
+		result.gpu_ms = compute_frame_time_stats(gpu_times);
+		result.cpu_ms = compute_frame_time_stats(cpu_times);
+		report.cases.push_back(result);
+
+		std::cout << std::fixed << std::setprecision(3)
+			<< result.resolution.width << "x" << result.resolution.height << " uzorci " << result.sample_amount_in << "/" << result.sample_amount_out
+			<< " nacin " << result.mode << " kamera " << result.camera << (result.shader_variant ? "" : " (opci sjencar)")
+			<< ": GPU p50 " << result.gpu_ms.p50 << " p95 " << result.gpu_ms.p95 << " p99 " << result.gpu_ms.p99 << " ms"
+			<< ", procesor p50 " << result.cpu_ms.p50 << " p95 " << result.cpu_ms.p95 << " p99 " << result.cpu_ms.p99 << " ms"
+			<< std::defaultfloat << std::setprecision(6) << "\n";
 	}
 
-	// Postavljanje ogradi za naredbe
-	VK_CHECK(vkResetFences(_device, 1, &_frames[_current_frame]._compute_fence));
-	VK_CHECK(vkResetFences(_device, 1, &_frames[_current_frame]._gui_fence));
+	main_camera = saved_camera;
+	sun = saved_sun;
+	main_planet = saved_planet;
+	_screen_size_x = saved_size_x;
+	_screen_size_y = saved_size_y;
+	sample_amount_in = saved_sample_amount_in;
+	sample_amount_out = saved_sample_amount_out;
+	do_rayleigh = saved_rayleigh;
+	do_mie = saved_mie;
+
+	if (!write_benchmark_json(config.output_path, report)) {
+		std::cerr << "Rezultati mjerenja nisu uspjeli biti zapisani u '" << config.output_path << "'\n";
+		return false;
+	}
+	std::cout << "Rezultati mjerenja zapisani su u '" << config.output_path << "'\n";
+	return true;
+}
 
+void RenderEngine::fill_shader_inputs(const SceneParameters& scene, VkExtent2D render_extent, shader_input_buffer_1& camera_input, shader_input_buffer_2& atmosphere_input){
 
-	// Raunanje novih uniformnih podataka - u ovom sluaju fiksna pozicija kamere
-	shader_input_buffer_1 camera_input;
+	// Računanje novih uniformnih podataka - u ovom slučaju fiksna pozicija kamere
 	
 	camera_input.lookDir = glm::mat4(
-		glm::vec4(main_camera.right,0),
-		glm::vec4(main_camera.up,0),
-		glm::vec4(main_camera.front,0),
+		glm::vec4(scene.camera.right,0),
+		glm::vec4(scene.camera.up,0),
+		glm::vec4(scene.camera.front,0),
 		glm::vec4(0,0,0,1)
 	);
 	
 	
-	camera_input.initPos = glm::vec4(main_camera.position,0);
+	camera_input.initPos = glm::vec4(scene.camera.position,0);
 	camera_input.initDir = glm::vec4(0.0f, 0.0f, -0.51f, 0); // Kamera uvijek gleda relativno ispred sebe 
 
 	camera_input.xPosMultiplier = 0;
 	camera_input.yPosMultiplier = 0;
 
-	camera_input.xDirMultiplier = 1.0f/1000.0f;
-	camera_input.yDirMultiplier = 1.0f/1000.0f;
+	// Uz manju razlučivost sjenčara svaki piksel pokriva veći dio pogleda, pa vidno polje ostaje isto
+	camera_input.xDirMultiplier = 1.0f/1000.0f * _screen_size_x / render_extent.width;
+	camera_input.yDirMultiplier = 1.0f/1000.0f * _screen_size_y / render_extent.height;
 
-	camera_input.sampleAmount_in = sample_amount_in;
-	camera_input.sampleAmount_out = sample_amount_out;
+	camera_input.sampleAmount_in = scene.sample_amount_in;
+	camera_input.sampleAmount_out = scene.sample_amount_out;
 
 	camera_input.mode = 0;
-	if (do_rayleigh) camera_input.mode |= 1;
-	if (do_mie) camera_input.mode |= 2;
+	if (scene.do_rayleigh) camera_input.mode |= 1;
+	if (scene.do_mie) camera_input.mode |= 2;
+
+	camera_input.renderWidth = render_extent.width;
+	camera_input.renderHeight = render_extent.height;
+
+	// Foveacija u pikselima slike koju sjenčar računa
+	camera_input.focusX = 0;
+	camera_input.focusY = 0;
+	camera_input.foveaRadius = 0;
+	camera_input.foveaFalloff = 0;
+	camera_input.peripheryFactor = 1;
+	if (scene.foveation.enabled) {
+		camera_input.focusX = scene.foveation.focus_x * render_extent.width;
+		camera_input.focusY = scene.foveation.focus_y * render_extent.height;
+		camera_input.foveaRadius = scene.foveation.radius * render_extent.height;
+		camera_input.foveaFalloff = std::max(scene.foveation.falloff * render_extent.height, 1.0f);
+		camera_input.peripheryFactor = scene.foveation.periphery_factor;
+	}
+
+	camera_input.adaptiveThreshold = std::max(scene.adaptive.threshold, 0.01f);
+	camera_input.adaptiveMinFactor = std::clamp(scene.adaptive.min_factor, 0.0f, 1.0f);
+	camera_input.adaptiveFlags = 0;
+	if (scene.adaptive.enabled) {
+		camera_input.adaptiveFlags |= 1;
+		if (scene.adaptive.show_tiles) camera_input.adaptiveFlags |= 2;
+	}
+
+	camera_input.sampleFactor = scene.sample_factor;
+
+	atmosphere_input.sun = scene.sun;
+	atmosphere_input.planet = scene.planet;
+	atmosphere_input.K = scene.K;
+}
+
+void RenderEngine::update_uniform_buffers(const SceneParameters& scene, VkExtent2D render_extent){
+
+	shader_input_buffer_1 camera_input;
+	shader_input_buffer_2 atmosphere_input;
+	fill_shader_inputs(scene, render_extent, camera_input, atmosphere_input);
 
 	// Prebacivanje uniformnih podataka na GPU
 	void* data;
@@ -1187,16 +2997,104 @@ void RenderEngine::compute(){
 	vmaUnmapMemory(_allocator, _frames[_current_frame]._camera_uniform_buffer._allocation);
 
 
-	shader_input_buffer_2 atmosphere_input;
-
-	atmosphere_input.sun = sun;
-	atmosphere_input.planet = main_planet;
-	atmosphere_input.K = K;
-
-
 	vmaMapMemory(_allocator, _frames[_current_frame]._atmosphere_uniform_buffer._allocation, &data);
 	memcpy(data, &atmosphere_input, sizeof(shader_input_buffer_2));
 	vmaUnmapMemory(_allocator, _frames[_current_frame]._atmosphere_uniform_buffer._allocation);
+}
+
+void RenderEngine::record_compute_dispatch(VkCommandBuffer cmd, VkExtent2D render_extent, bool adaptive_samples){
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _active_compute_pipeline);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _compute_pipeline_Layout, 0, 1, &_frames[_current_frame]._compute_descriptor_set, 0, 0);
+
+	// Predprolaz računa samo kutove pločica (jedna jedinica po kutu), pa stoji malen dio punog prolaza
+	if (adaptive_samples) {
+		int32_t pass = 1;
+		vkCmdPushConstants(cmd, _compute_pipeline_Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pass), &pass);
+
+		uint32_t corners_x = (render_extent.width + _adaptive_tile_size - 1) / _adaptive_tile_size + 1;
+		uint32_t corners_y = (render_extent.height + _adaptive_tile_size - 1) / _adaptive_tile_size + 1;
+		vkCmdDispatch(cmd, corners_x / 32 + 1, corners_y / 32 + 1, 1);
+
+		// Puni prolaz čita svjetline koje je predprolaz zapisao
+		VkMemoryBarrier estimateBarrier = {};
+		estimateBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		estimateBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		estimateBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &estimateBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	int32_t pass = 0;
+	vkCmdPushConstants(cmd, _compute_pipeline_Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pass), &pass);
+	vkCmdDispatch(cmd, render_extent.width / 32 + 1, render_extent.height / 32 + 1, 1);
+}
+
+VkExtent2D RenderEngine::apply_frame_quality(const RenderSnapshot& snapshot, SceneParameters& scene){
+
+	Frame& frame = _frames[_current_frame];
+	frame._resolution_generation = 0;
+
+	if (!snapshot.dynamic_resolution) _resolution.reset();
+	_resolution.set_budget(snapshot.frame_budget_ms);
+
+	// Slike zaslona i snimke uvijek su pune razlučivosti, kao i zadnja slika prije mirovanja
+	bool exact = _screenshot_requested || _recording;
+	bool full_quality = snapshot.full_quality || exact;
+	if (full_quality) scene.foveation.enabled = false;
+
+	// Uz prikaz budžeta pločica prilagodljiv broj uzoraka ostaje i na zadnjoj slici prije mirovanja, inače bi prikaz
+	// nestao čim se scena zaustavi
+	if (exact || (full_quality && !scene.adaptive.show_tiles)) {
+		scene.adaptive.enabled = false;
+		scene.adaptive.show_tiles = false;
+	}
+
+	VkExtent2D render_extent = { _screen_size_x, _screen_size_y };
+	scene.sample_factor = 1;
+
+	if (snapshot.dynamic_resolution && !full_quality) {
+		frame._resolution_generation = _resolution.generation();
+
+		double scale = _resolution.scale();
+		render_extent.width = std::max(1u, std::min(_screen_size_x, (unsigned int)std::ceil(_screen_size_x * scale)));
+		render_extent.height = std::max(1u, std::min(_screen_size_y, (unsigned int)std::ceil(_screen_size_y * scale)));
+
+		// Broj uzoraka smanjuje sjenčar po pikselu (kao kod foveacije), a zadani broj ostaje u varijanti sjenčara -
+		// inače bi svaki korak regulatora tražio novu varijantu, a do njezina prevođenja slika bi bila sporija
+		scene.sample_factor = (float)_resolution.sample_factor();
+	}
+
+	// Prosječan broj uzoraka za prikaz - sjenčar oba broja smanjuje jednako i zaokružuje po pikselu, uz barem dva uzorka
+	double sample_scale = std::sqrt(scene.sample_factor);
+	_last_render_extent = render_extent;
+	_last_sample_amount_in = scene.sample_amount_in > 2 ? std::max(2, (int)std::lround(scene.sample_amount_in * sample_scale)) : scene.sample_amount_in;
+	_last_sample_amount_out = scene.sample_amount_out > 2 ? std::max(2, (int)std::lround(scene.sample_amount_out * sample_scale)) : scene.sample_amount_out;
+	_last_quality_reduced = render_extent.width != _screen_size_x || render_extent.height != _screen_size_y ||
+		scene.sample_factor < 1 || scene.foveation.enabled || (scene.adaptive.enabled && !full_quality);
+
+	return render_extent;
+}
+
+// Prolazi se raspoređuju na dretve za snimanje, a prvi snima dretva koja ih je pozvala. Svaki prolaz smije koristiti
+// samo svoj bazen naredbi - Vulkan ne dopušta istodobno snimanje iz istog bazena na dvije dretve
+void RenderEngine::record_passes(const std::vector<std::function<void()>>& passes){
+
+	if (_recording_threads == 0) {
+		for (const std::function<void()>& pass : passes) pass();
+		return;
+	}
+
+	// Bazen nije pokrenut (npr. bez prozora) - prolaz se snima odmah
+	for (size_t i = 1; i < passes.size(); i++) {
+		if (!_record_workers.submit(passes[i])) passes[i]();
+	}
+	if (!passes.empty()) passes[0]();
+	_record_workers.wait_idle();
+}
+
+// Komputacijski sjenčar, kopiranje izlazne slike u swapchain i kopija za spremanje na disk
+void RenderEngine::record_compute_pass(uint32_t swapchainImageIndex, VkExtent2D render_extent, bool adaptive_samples){
+
+	TRACE_SCOPE("snimanje_racunanja");
 
 	// Postavljanje naredbenog spremnika
 	VkCommandBufferBeginInfo cmdBeginInfo = {};
@@ -1204,14 +3102,17 @@ void RenderEngine::compute(){
 	cmdBeginInfo.pNext = nullptr;
 
 	cmdBeginInfo.pInheritanceInfo = nullptr;
-	// Ovaj naredbeni spremnik koristit e se samo jednom (po frameu)
+	// Ovaj naredbeni spremnik koristit će se samo jednom (po frameu)
 	cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 
-	// Poetak spremanja grafikih naredbi u spremnik
+	// Početak spremanja grafičkih naredbi u spremnik
 	VK_CHECK(vkBeginCommandBuffer(_frames[_current_frame]._compute_command_buffer, &cmdBeginInfo));
 
-	// Postavljanje izlazne slike na generalno koritenje pomou barijere
+	// Slanje čeka swapchain tek na kopiranju, pa sjenčar počinje odmah i njegova faza ne uključuje čekanje prikaza
+	_gpu_profiler.begin_stage(_frames[_current_frame]._compute_command_buffer, _current_frame, GpuProfiler::StageCompute, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+	// Postavljanje izlazne slike na generalno korištenje pomoću barijere
 	VkImageMemoryBarrier imageBarrier = {};
 	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	imageBarrier.pNext = NULL;
@@ -1231,10 +3132,12 @@ void RenderEngine::compute(){
 		&imageBarrier);
 
 
-	// Izvravanje komputacijskog sjenara
-	vkCmdBindPipeline(_frames[_current_frame]._compute_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _default_compute_pipeline);
-	vkCmdBindDescriptorSets(_frames[_current_frame]._compute_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _compute_pipeline_Layout, 0, 1, &_frames[_current_frame]._compute_descriptor_set, 0, 0);
-	vkCmdDispatch(_frames[_current_frame]._compute_command_buffer, _screen_size_x / 32 + 1, _screen_size_y / 32 + 1, 1);
+	// Izvršavanje komputacijskog sjenčara
+	_gpu_profiler.begin_statistics(_frames[_current_frame]._compute_command_buffer, _current_frame);
+	record_compute_dispatch(_frames[_current_frame]._compute_command_buffer, render_extent, adaptive_samples);
+	_gpu_profiler.end_statistics(_frames[_current_frame]._compute_command_buffer, _current_frame);
+
+	_gpu_profiler.end_stage(_frames[_current_frame]._compute_command_buffer, _current_frame, GpuProfiler::StageCompute);
 
 
 	// Konverzija izlazne slike i swapchainove slike kako bi se podaci mogli kopirati s jedne na drugu
@@ -1263,22 +3166,69 @@ void RenderEngine::compute(){
 	imageBarrier2.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
 	imageBarrier2.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 	imageBarrier2.image = _frames[_current_frame]._output_image._image;
+	imageBarrier2.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarrier2.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
 
 	VkImageMemoryBarrier imageBarrier3 = imageBarrier;
 	imageBarrier3.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	imageBarrier3.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 	imageBarrier3.image = _swapchain_images[swapchainImageIndex];
+	imageBarrier3.srcAccessMask = 0;
+	imageBarrier3.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 
 	VkImageMemoryBarrier imageBarrierArray2[2] = {imageBarrier2, imageBarrier3};
 
-	srcFlags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-	dstFlags = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	vkCmdPipelineBarrier(_frames[_current_frame]._compute_command_buffer, srcFlags, dstFlags, 0, 0, NULL, 0, NULL, 2,
+	// Prezentacijski semafor se čeka na fazi prijenosa, pa barijera mora početi na istoj fazi - tako se prijelaz
+	// rasporeda slike swapchaina veže na čekanje semafora
+	VkPipelineStageFlags copySrcFlags = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	vkCmdPipelineBarrier(_frames[_current_frame]._compute_command_buffer, copySrcFlags, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 2,
 		imageBarrierArray2);
 
+	// Početna oznaka na fazi prijenosa iza barijere - faza kopiranja ne uključuje čekanje slike swapchaina
+	_gpu_profiler.begin_stage(_frames[_current_frame]._compute_command_buffer, _current_frame, GpuProfiler::StageCopy, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	// Dinamička razlučivost: sjenčar je računao manju sliku, pa se ona linearnim filtrom povećava u pomoćnu sliku
+	// istog formata. U swapchain se i dalje kopira, pa boje ne ovise o tome pretvara li blit format swapchaina.
+	// Blit s linearnim filtrom za R8G8B8A8_UNORM mora podržavati svaki uređaj
+	VkImage presentSource = _frames[_current_frame]._output_image._image;
+	if (render_extent.width != _screen_size_x || render_extent.height != _screen_size_y) {
+		VkImage upscaledImage = _frames[_current_frame]._upscaled_image._image;
+
+		VkImageMemoryBarrier upscaleBarrier = imageBarrier;
+		upscaleBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		upscaleBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		upscaleBarrier.image = upscaledImage;
+		upscaleBarrier.srcAccessMask = 0;
+		upscaleBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(_frames[_current_frame]._compute_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1,
+			&upscaleBarrier);
+
+		VkImageBlit blitRegion{};
+		blitRegion.srcSubresource = copyRegion.srcSubresource;
+		blitRegion.dstSubresource = copyRegion.dstSubresource;
+		blitRegion.srcOffsets[1] = { (int32_t)render_extent.width, (int32_t)render_extent.height, 1 };
+		blitRegion.dstOffsets[1] = { (int32_t)_screen_size_x, (int32_t)_screen_size_y, 1 };
+
+		vkCmdBlitImage(_frames[_current_frame]._compute_command_buffer, _frames[_current_frame]._output_image._image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upscaledImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blitRegion, VK_FILTER_LINEAR);
+
+		upscaleBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		upscaleBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		upscaleBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		upscaleBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(_frames[_current_frame]._compute_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1,
+			&upscaleBarrier);
+
+		presentSource = upscaledImage;
+	}
+
 	// Kopiranje podataka na sliku swapchaina
-	vkCmdCopyImage(_frames[_current_frame]._compute_command_buffer, _frames[_current_frame]._output_image._image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, _swapchain_images[swapchainImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+	vkCmdCopyImage(_frames[_current_frame]._compute_command_buffer, presentSource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, _swapchain_images[swapchainImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+	// Slika je već u formatu za kopiranje, pa se kopija za spremanje na disk snima odmah iza
+	capture_output_image(_frames[_current_frame]._compute_command_buffer);
+
+	_gpu_profiler.end_stage(_frames[_current_frame]._compute_command_buffer, _current_frame, GpuProfiler::StageCopy);
 
 
 
@@ -1306,16 +3256,29 @@ void RenderEngine::compute(){
 		imageBarrierArray3);
 
 
-	// Finalizacija komandog spremnika - sada se moe slati na GPU za izvedbu
+	// Finalizacija komandog spremnika - sada se može slati na GPU za izvedbu
 	VK_CHECK(vkEndCommandBuffer(_frames[_current_frame]._compute_command_buffer));
+}
 
-	// CRTANJE GUI-A
+// Sučelje se crta preko slike swapchaina u grafičkom redu
+void RenderEngine::record_gui_pass(const RenderSnapshot& snapshot, uint32_t swapchainImageIndex){
+
+	TRACE_SCOPE("snimanje_sucelja");
+
+	VkCommandBufferBeginInfo cmdBeginInfo = {};
+	cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	cmdBeginInfo.pNext = nullptr;
+
+	cmdBeginInfo.pInheritanceInfo = nullptr;
+	// Ovaj naredbeni spremnik koristit će se samo jednom (po frameu)
+	cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 	// Postavljanje komandnog spremnika
 	VK_CHECK(vkResetCommandBuffer(_frames[_current_frame]._graphics_command_buffer, 0));
-	// Poetak spremanja grafikih naredbi u spremnik za grafiku
+	// Početak spremanja grafičkih naredbi u spremnik za grafiku
 	VK_CHECK(vkBeginCommandBuffer(_frames[_current_frame]._graphics_command_buffer, &cmdBeginInfo));
 
+	_gpu_profiler.begin_stage(_frames[_current_frame]._graphics_command_buffer, _current_frame, GpuProfiler::StageGui, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
 
 	VkRenderPassBeginInfo renderPassInfo{};
@@ -1331,41 +3294,152 @@ void RenderEngine::compute(){
 
 	vkCmdBeginRenderPass(_frames[_current_frame]._graphics_command_buffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-	ImDrawData* draw_data = ImGui::GetDrawData();
-	ImGui_ImplVulkan_RenderDrawData(draw_data, _frames[_current_frame]._graphics_command_buffer);
+	ImGui_ImplVulkan_RenderDrawData(snapshot.draw_data, _frames[_current_frame]._graphics_command_buffer);
 
 	vkCmdEndRenderPass(_frames[_current_frame]._graphics_command_buffer);
 
+	_gpu_profiler.end_stage(_frames[_current_frame]._graphics_command_buffer, _current_frame, GpuProfiler::StageGui);
 
 
 
 	VK_CHECK(vkEndCommandBuffer(_frames[_current_frame]._graphics_command_buffer));
+}
+
+void RenderEngine::compute(const RenderSnapshot& snapshot){
+
+	// Nije potrebno ništa raditi ako je prozor minimiziran
+	if (snapshot.window_minimized){
+		return;
+	}
+
+
+	// Čekanje na dovršetak naredba prošle slike (tj. prošle X-te, gdje je X maksimalan broj bufferanih slika (obično 1-3))
+	{
+		PerformanceHud::Scope scope(_performance_hud, PerformanceHud::PhaseGpuWait);
+		TRACE_SCOPE("cekanje_ograda");
+		VK_CHECK(vkWaitForFences(_device, 1, &_frames[_current_frame]._compute_fence, true, 1000000000));
+		VK_CHECK(vkWaitForFences(_device, 1, &_frames[_current_frame]._gui_fence, true, 1000000000));
+	}
+
+	// Strukture koje su zamijenjene prije nego što je ova slika opet došla na red više nitko ne koristi
+	_frames[_current_frame]._deletion_queue.flush();
+
+	// Kopije izlazne slike snimljene u prošlom krugu ove slike su gotove i mogu se predati na spremanje
+	_readback.retire_frame(_current_frame);
+
+	// Oba naredbena spremnika ove slike su gotova, pa su i njezini upiti spremni
+	if (_gpu_profiler.collect(_current_frame)) {
+		TraceRecorder::instance().add_gpu_frame(_gpu_profiler.last_frame());
+
+		// Regulator dinamičke razlučivosti vidi samo slike iscrtane s njegovim trenutnim postavkama. Predaje mu se zbroj
+		// trajanja faza, pa čekanje na sliku swapchaina ne spušta razlučivost
+		if (_frames[_current_frame]._resolution_generation == _resolution.generation()) {
+			_resolution.add_frame(_gpu_profiler.last_frame().total_ms);
+		}
+	}
+
+	// Novi swapchain se stvara kada se prozor prestane mijenjati, ili odmah ako stari više nije upotrebljiv
+	if (_swapchain_needs_recreate ||
+		(_resize_pending && std::chrono::steady_clock::now() - _last_resize_event >= std::chrono::milliseconds(_resize_debounce_ms))) {
+		recreate_swapchain(snapshot.window_width, snapshot.window_height);
+	}
+
+	update_output_image(_current_frame);
+
+	// Razlučivost i broj uzoraka ove slike
+	SceneParameters scene = snapshot.scene;
+	VkExtent2D render_extent = apply_frame_quality(snapshot, scene);
+	{
+		TRACE_SCOPE("varijanta_sjencara");
+		update_shader_variant(scene);
+	}
+
+	// Regulator smije vidjeti samo trajanja slika iscrtanih traženom varijantom. Dok se ona prevodi, slika se
+	// iscrtava sporijim općim sjenčarom, a nakon promjene protočnog sustava mjerenje počinje ispočetka
+	if (_active_compute_pipeline != _measured_compute_pipeline) {
+		_measured_compute_pipeline = _active_compute_pipeline;
+		_resolution.restart_measurement();
+		if (_frames[_current_frame]._resolution_generation != 0) _frames[_current_frame]._resolution_generation = _resolution.generation();
+	}
+	if (_shader_variant_pending) _frames[_current_frame]._resolution_generation = 0;
 
+	// Postavljanje komandnog spremnika
+	VK_CHECK(vkResetCommandBuffer(_frames[_current_frame]._compute_command_buffer, 0));
+
+
+
+	// Traženje dohvata slike (u koju će se output pisati) sa swapchaina, program maksimalno čeka 1 sekundu prije izlaska
+	uint32_t swapchainImageIndex;
+	VkResult imageResult;
+	{
+		PerformanceHud::Scope scope(_performance_hud, PerformanceHud::PhaseGpuWait);
+		TRACE_SCOPE("dohvat_slike_swapchaina");
+
+		// Pozadinska dretva za mjerenje latencije također pristupa swapchainu
+		std::lock_guard<std::mutex> lock(_latency.swapchain_mutex());
+																						// Ovaj semafor signalizira kada je operacija gotova
+		imageResult = vkAcquireNextImageKHR(_device, _swapchain, 1000000000, _frames[_current_frame]._present_semaphore, nullptr, &swapchainImageIndex);
+	}
+
+	// Ukoliko slika ne odgovara swapchainu (najčešće zbog nove veličine prozora), swapchain i prozor bi se trebali postaviti na točnu vrijednost
+	if (imageResult == VK_ERROR_OUT_OF_DATE_KHR) {
+		_swapchain_needs_recreate = true;
+
+		// Prelazak na sljedeću sliku - time se strukture zamijenjene u ovoj slici brišu tek nakon čekanja svih ostalih
+		_current_frame = (_current_frame + 1) % _max_frames_in_flight;
+		return;
+	}
+	else if (imageResult != VK_SUCCESS && imageResult != VK_SUBOPTIMAL_KHR) {
+		throw std::runtime_error("Nije bilo moguce dobiti sliku sa swapchaina :(");
+	}
+
+	// Ostatak funkcije - snimanje, slanje i prezentacija
+	PerformanceHud::Scope recording_scope(_performance_hud, PerformanceHud::PhaseRecording);
+	TraceRecorder::Scope recording_trace("snimanje_naredbi");
+
+	// Postavljanje ogradi za naredbe
+	VK_CHECK(vkResetFences(_device, 1, &_frames[_current_frame]._compute_fence));
+	VK_CHECK(vkResetFences(_device, 1, &_frames[_current_frame]._gui_fence));
+
+
+	update_uniform_buffers(scene, render_extent);
 
+	// Upiti slike postavljaju se prije snimanja, jer prolazi zapisuju vremenske oznake s različitih dretvi
+	_gpu_profiler.begin_frame(_current_frame, _frame_number);
 
+	// Prolazi se snimaju istodobno, svaki u svoj naredbeni spremnik iz svog bazena naredbi ove slike
+	record_passes({
+		[&]() { record_compute_pass(swapchainImageIndex, render_extent, scene.adaptive.enabled); },
+		[&]() { record_gui_pass(snapshot, swapchainImageIndex); }
+	});
 
+	// Vrijeme slanja - ujedno i kraj latencije unosa koja ne ovisi o prikazu
+	LatencyTracker::FrameMark latency_mark = _latency.mark_submit(snapshot.input);
 
 	// Informacije o slanju
 	VkSubmitInfo submit = {};
 	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submit.pNext = nullptr;
 
-	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	// Sliku swapchaina prvo dira kopiranje, pa se na nju čeka tek na fazi prijenosa - sjenčar radi dok se čeka prikaz
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
 	submit.pWaitDstStageMask = &waitStage;
-	// ekanje na prezentacijski semafor - kada signalizira da je gotov, swapchain je omoguio pisanje na sliku.
+	// Čekanje na prezentacijski semafor - kada signalizira da je gotov, swapchain je omogućio pisanje na sliku.
 	submit.waitSemaphoreCount = 1;
 	submit.pWaitSemaphores = &_frames[_current_frame]._present_semaphore;
-	// Ovaj set naredbi e aktivirati _compute_finish_semaphore kada je gotov
+	// Ovaj set naredbi će aktivirati _compute_finish_semaphore kada je gotov
 	submit.signalSemaphoreCount = 1;
 	submit.pSignalSemaphores = &_frames[_current_frame]._compute_finish_semaphore;
 
 	submit.commandBufferCount = 1;
 	submit.pCommandBuffers = &_frames[_current_frame]._compute_command_buffer;
 
-	// Slanje i izvravanje naredbenog spremnika
-	// _compute_fence e sada blokirati daljnja slanja dok GPU nije gotov.
+	// Slanje i izvršavanje naredbenog spremnika
+	// _compute_fence će sada blokirati daljnja slanja dok GPU nije gotov.
+	_gpu_profiler.mark_submit(_current_frame);
 	VK_CHECK(vkQueueSubmit(_compute_queue, 1, &submit, _frames[_current_frame]._compute_fence));
+	_frame_number++;
 
 
 	// Informacije o slanju crtanja GUI-a
@@ -1373,7 +3447,9 @@ void RenderEngine::compute(){
 	submit_g.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submit_g.pNext = nullptr;
 
-	VkPipelineStageFlags waitStage_g = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	// Sučelje crta preko kopirane slike, pa cijeli spremnik čeka komputacijski red - i početna oznaka faze sučelja,
+	// koja bi inače ubrojila rad drugog reda
+	VkPipelineStageFlags waitStage_g = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
 	submit_g.pWaitDstStageMask = &waitStage_g;
 	submit_g.waitSemaphoreCount = 1;
@@ -1385,8 +3461,8 @@ void RenderEngine::compute(){
 	submit_g.commandBufferCount = 1;
 	submit_g.pCommandBuffers = &_frames[_current_frame]._graphics_command_buffer;
 
-	// Slanje i izvravanje naredbenog spremnika
-	// _compute_fence e sada blokirati daljnja slanja dok GPU nije gotov.
+	// Slanje i izvršavanje naredbenog spremnika
+	// _compute_fence će sada blokirati daljnja slanja dok GPU nije gotov.
 	VK_CHECK(vkQueueSubmit(_graphics_queue, 1, &submit_g, _frames[_current_frame]._gui_fence));
 
 
@@ -1397,20 +3473,52 @@ void RenderEngine::compute(){
 
 	presentInfo.pSwapchains = &_swapchain;
 	presentInfo.swapchainCount = 1;
-	// ekanje na semafor (tj. da komputacijski sjenar i kopiranje slika zavre)
+	// Čekanje na semafor (tj. da komputacijski sjenčar i kopiranje slika završe)
 	presentInfo.pWaitSemaphores = &_frames[_current_frame]._gui_finish_semaphore;
 	presentInfo.waitSemaphoreCount = 1;
 	presentInfo.pImageIndices = &swapchainImageIndex;
-	VkResult presentResult = vkQueuePresentKHR(_graphics_queue, &presentInfo);
 
+	// Id prezentacije omogućuje pozadinskoj dretvi čekanje na trenutak prikaza ove slike
+	uint64_t present_id = _latency.next_present_id();
+	VkPresentIdKHR presentIdInfo = {};
+	if (_present_id_enabled) {
+		presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+		presentIdInfo.pNext = nullptr;
+		presentIdInfo.swapchainCount = 1;
+		presentIdInfo.pPresentIds = &present_id;
+		presentInfo.pNext = &presentIdInfo;
+	}
+
+	VkResult presentResult;
+	{
+		TRACE_SCOPE("prikaz");
+		std::lock_guard<std::mutex> lock(_latency.swapchain_mutex());
+		presentResult = vkQueuePresentKHR(_graphics_queue, &presentInfo);
+	}
+	_latency.mark_present(_swapchain, present_id, latency_mark);
 
-	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
-		recreate_swapchain();
+
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR) {
+		_swapchain_needs_recreate = true;
+	}
+	else if (presentResult == VK_SUBOPTIMAL_KHR) {
+		// Slika se još može prikazati, pa se swapchain mijenja tek nakon isteka vremena za promjenu veličine
+		if (!_resize_pending) {
+			_resize_pending = true;
+			_last_resize_event = std::chrono::steady_clock::now();
+		}
 	}
 	else if (presentResult != VK_SUCCESS) {
 		throw std::runtime_error("Slika nije uspjela biti prezentirana na swapchain :(");
 	}
 
+	if (!_first_frame_presented) {
+		_first_frame_presented = true;
+		std::cout << "Vrijeme od pokretanja do prve slike: "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _startup_time).count() << " ms"
+			<< (_pipeline_cache_loaded ? " (s ucitanom prirucnom memorijom protocnih sustava)" : " (bez prirucne memorije protocnih sustava)") << "\n";
+	}
+
 	_current_frame = (_current_frame + 1) % _max_frames_in_flight;
 
 }
@@ -1418,20 +3526,40 @@ void RenderEngine::compute(){
 
 void RenderEngine::cleanup(){
 	
-	// ekanje dok GPU vie ne korisiti strukture
+	// Čekanje dok GPU više ne korisiti strukture
 	vkDeviceWaitIdle(_device);
+	_latency.cleanup();
+	_record_workers.cleanup();
+
+	// Slike koje još čekaju na spremanje se dovršavaju
+	_readback.cleanup();
+
+	// Trag zadan naredbenim retkom ili onaj koji je još u tijeku (F3)
+	if (TraceRecorder::instance().enabled()) {
+		if (!_trace_path.empty()) {
+			TraceRecorder::instance().stop();
+			write_trace(_trace_path);
+		}
+		else toggle_trace();
+	}
+
+	// Spremanje prije nego što se priručna memorija uništi zajedno s ostalim strukturama
+	save_pipeline_cache();
 
 	// Red je bitan - strukture ovise jedna o drugoj
 	cleanup_swapchain();
-	_image_deletion_queue.flush();
+	for (unsigned int i = 0; i < _max_frames_in_flight; i++) {
+		retire_output_image(i);
+		_frames[i]._deletion_queue.flush();
+	}
 	_main_deletion_queue.flush();
 
 	
 	vkDestroyDevice(_device, nullptr);
-	vkDestroySurfaceKHR(_instance, _window_surface, nullptr);
+	if (!_headless) vkDestroySurfaceKHR(_instance, _window_surface, nullptr);
 	vkb::destroy_debug_utils_messenger(_instance, _debug_messenger);
 	vkDestroyInstance(_instance, nullptr);
-	SDL_DestroyWindow(_window);
+	if (!_headless) SDL_DestroyWindow(_window);
 
 	delete[] _frames;
 }
@@ -1440,55 +3568,35 @@ void RenderEngine::cleanup_swapchain(){
 	_swapchain_deletion_queue.flush();
 }
 
-// Poziva se kada je potrebno promijeniti veliinu ili format swapchaina (obino kada se prozor promijeni)
-void RenderEngine::recreate_swapchain() {
-
-
-	int new_screen_size_x;
-	int new_screen_size_y;
-	SDL_GetWindowSize(_window, &new_screen_size_x, &new_screen_size_y);
-
-	if (SDL_GetWindowFlags(_window) & SDL_WINDOW_MINIMIZED) return; // Nije potrebno nita raditi ako je prozor minimiziran
-
-
-
-	vkDeviceWaitIdle(_device);
-	cleanup_swapchain();
-
-	_screen_size_x = new_screen_size_x;
-	_screen_size_y = new_screen_size_y;
-
-	_windowExtent.width = new_screen_size_x;
-	_windowExtent.height = new_screen_size_y;
-
-	// Realociranje slika
-	_image_deletion_queue.flush();
-	allocate_compute_images();
+// Poziva se kada je potrebno promijeniti veličinu ili format swapchaina (obično kada se prozor promijeni).
+// Ne čeka se da GPU završi - zamijenjene strukture brišu se kada trenutna slika ponovno dođe na red
+void RenderEngine::recreate_swapchain(unsigned int width, unsigned int height) {
 
+	TRACE_SCOPE("novi_swapchain");
 
-	// Osvjeavanje opisnika slika
-	for (unsigned int i = 0; i < _max_frames_in_flight; i++) {
-		VkWriteDescriptorSet setWrite = {};
-		setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		setWrite.pNext = nullptr;
+	// Nije potrebno ništa raditi ako je prozor minimiziran
+	if (width == 0 || height == 0) return;
 
+	_swapchain_needs_recreate = false;
+	_resize_pending = false;
 
-		setWrite.dstBinding = 2;
+	_latency.reset_swapchain();
 
-		setWrite.dstSet = _frames[i]._compute_descriptor_set;
-		setWrite.descriptorCount = 1;
+	// Stari swapchain, njegovi pogledi i framebufferi prelaze u red brisanja trenutne slike
+	for (std::function<void()>& deletor : _swapchain_deletion_queue.deletors) {
+		_frames[_current_frame]._deletion_queue.push_function(std::move(deletor));
+	}
+	_swapchain_deletion_queue.deletors.clear();
 
-		VkDescriptorImageInfo iinfo = {};
-		iinfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	_windowExtent.width = width;
+	_windowExtent.height = height;
 
-		iinfo.imageView = _frames[i]._output_image_view;
-		iinfo.sampler = nullptr;
-		setWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		setWrite.pImageInfo = &iinfo;
-		setWrite.pBufferInfo = nullptr;
-		vkUpdateDescriptorSets(_device, 1, &setWrite, 0, nullptr);
+	init_swapchain();
+	init_framebuffers();
 
-	}
+	// Površina može propisati drugačiju veličinu od prozora - iscrtava se samo ono što stane u swapchain
+	_screen_size_x = _swapchain_extent.width;
+	_screen_size_y = _swapchain_extent.height;
 
-	init_swapchain();
+	// Izlazne slike se mijenjaju tek kada koja dođe na red, i samo ako su premale (vidi update_output_image)
 }
\ No newline at end of file
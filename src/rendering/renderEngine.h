@@ -12,12 +12,42 @@
 #include <vma/vk_mem_alloc.h>
 
 #include <functional>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 #include "camera.h"
-#include "../simulation/sun.h"
-#include "../simulation/atmosphere.h"
+#include "latencyTracker.h"
+#include "shaderVariants.h"
+#include "frameReadback.h"
+#include "imageWriters.h"
+#include "regression.h"
+#include "benchmark.h"
+#include "gpuProfiler.h"
+#include "performanceHud.h"
+#include "traceRecorder.h"
+#include "inputReplay.h"
+#include "cameraPath.h"
+#include "framePacer.h"
+#include "resolutionController.h"
+#include "tripleBuffer.h"
+#include "renderSnapshot.h"
+#include "workerPool.h"
+#include "../simulation/shaderInputs.h"
+#include "../simulation/cpuRenderer.h"
 
 
 #include "..\third-party\imgui\imgui.h"
@@ -47,7 +77,7 @@ struct AllocatedImage {
 };
 
 
-// Slui za uvanje funkcija brisanja Vulkanovih objekata kako bi se mogle izvriti tonim redoslijedom pri ienju
+// Služi za čuvanje funkcija brisanja Vulkanovih objekata kako bi se mogle izvršiti točnim redoslijedom pri čišćenju
 struct DeletionQueue
 {
 	std::vector<std::function<void()>> deletors;
@@ -57,7 +87,7 @@ struct DeletionQueue
 	}
 
 	void flush() {
-		// Izvravanje svih funkcija redom
+		// Izvršavanje svih funkcija redom
 		for (auto it = deletors.rbegin(); it != deletors.rend(); it++) {
 			(*it)(); // Poziv
 		}
@@ -75,6 +105,19 @@ struct Frame {
 
 	AllocatedImage _output_image;
 	VkImageView _output_image_view;
+	// Alocirana veličina izlazne slike - zaokružena na veći razred, sjenčar piše samo u dio veličine prozora
+	VkExtent2D _output_image_extent;
+
+	// Slika iste veličine u koju se povećava manja slika sjenčara (dinamička razlučivost) - samo s prozorom
+	AllocatedImage _upscaled_image = {};
+	// Postavke dinamičke razlučivosti s kojima je slika iscrtana (ResolutionController::generation(), 0 - puna kvaliteta)
+	uint64_t _resolution_generation = 0;
+
+	// Svjetlina kutova pločica iz predprolaza prilagodljivog broja uzoraka - veličina prati izlaznu sliku
+	AllocatedBuffer _sample_estimate_buffer = {};
+
+	// Strukture koje su zamijenjene dok je ova slika bila u letu - brišu se kada se sljedeći put pričeka njezina ograda
+	DeletionQueue _deletion_queue;
 
 	// Naredbeni spreminici i njihovi alokacijski bazeni
 	VkCommandPool _compute_command_pool;
@@ -96,47 +139,51 @@ struct Frame {
 };
 
 
-// Odgovara 1. strukturi koju glavni sjenar prima
-// Predstavlja informacije o kameri
-struct shader_input_buffer_1 {
-	glm::mat4 lookDir;
-
-	glm::vec4 initPos;
-	glm::vec4 initDir;
-
-	float xPosMultiplier;
-	float yPosMultiplier;
-
-	float xDirMultiplier;
-	float yDirMultiplier;
+class RenderEngine {
 
-	int sampleAmount_in;
-	int sampleAmount_out;
+public:
+	void init();
 
-	int mode;
-};
+	void run();
 
-// Informacije o atmosferi
-struct shader_input_buffer_2 {
-	Sun sun;
-	Planet planet;
+	void cleanup();
 
-	// Dodatna konstanta da se ne mora raunati za svaki piksel svaki prikaz
-	alignas(8) double K;	
-};
+	// Način rada bez prozora i swapchaina, npr. za poslužitelje bez zaslona - postavlja se prije init()
+	bool _headless = false;
 
+	// Format izlazne slike. Float slika (VK_FORMAT_R32G32B32A32_SFLOAT) čuva linearne vrijednosti za PFM i EXR datoteke,
+	// ali je dopuštena samo bez prozora, jer se izlazna slika inače kopira izravno u 8-bitni swapchain
+	VkFormat _output_format = VK_FORMAT_R8G8B8A8_UNORM;
 
+	// Iscrtava jednu sliku bez prozora i kopira ju u memoriju pozivatelja (_screen_size_x * _screen_size_y * 4 bajta, RGBA)
+	void render_offscreen(uint8_t* pixels);
 
+	// Šalje jednu sliku na iscrtavanje bez čekanja - potrošač ju dobiva na pozadinskoj dretvi kada GPU završi.
+	// Bez potrošača (prazna funkcija) slika se ne čita s GPU-a
+	void submit_offscreen(const FrameReadback::Consumer& consumer);
 
+	// Iscrtava zadani broj slika i sprema ih u formatu određenom ekstenzijom (PPM, PNG, PFM, EXR; prazna putanja - slike se ne spremaju)
+	void run_headless(unsigned int frame_count, const std::string& output_path);
 
-class RenderEngine {
+	// Iscrtava zadani broj slika na procesoru (cpuRenderer.h) - ne koristi Vulkan, pa se init() i cleanup() ne pozivaju.
+	// thread_count = 0 - sve jezgre
+	void render_cpu(unsigned int frame_count, const std::string& output_path, unsigned int thread_count);
 
-public:
-	void init();
+	// Provjera regresije (regression.h) - svaka scena se iscrtava skalarnom referencom na procesoru i uspoređuje s GPU-om
+	// (ako je use_gpu, inače se init() ne poziva) i sa svim brzim jezgrama procesora. Vraća false ako ijedna provjera ne prođe.
+	// Za GPU je potrebna float izlazna slika bez prozora
+	bool run_regression(bool use_gpu);
+	std::string _regression_dir = "regresija";
 
-	void run();
+	// Mjerenje brzine (benchmark.h) bez prozora - iscrtava sve kombinacije postavki i zapisuje JSON s rezultatima.
+	// Vraća false ako rezultati nisu zapisani ili položaj kamere ne postoji
+	bool run_benchmark(const BenchmarkConfig& config);
 
-	void cleanup();
+	// SIMD jezgra za iscrtavanje na procesoru - zadano najšira koju procesor podržava
+	CpuRenderer::Kernel _cpu_kernel = CpuRenderer::best_kernel();
+	// Profil gustoće i optička dubina SIMD jezgre - zadano isto kao u sjenčaru
+	CpuDensityProfile _cpu_density_profile = CpuDensityProfile::Exponential;
+	CpuOpticalDepth _cpu_optical_depth = CpuOpticalDepth::Marched;
 
 
 
@@ -148,21 +195,20 @@ public:
 	VkDebugUtilsMessengerEXT _debug_messenger;
 	VkSurfaceKHR _window_surface;
 
-	// Fiziki opis ureaja
+	// Fizički opis uređaja
 	VkPhysicalDevice _physical_GPU;
-	// Logiki opis ureaja
+	// Logički opis uređaja
 	VkDevice _device;
 
-	// Redovi za ienje Vulkanovih struktura
+	// Redovi za čišćenje Vulkanovih struktura
 	DeletionQueue _main_deletion_queue;
 	DeletionQueue _swapchain_deletion_queue;
-	DeletionQueue _image_deletion_queue;
 
 
 	VmaAllocator _allocator;
 
 
-	// Maksimalna memorija pridruena sjenarovom 1. spremniku
+	// Maksimalna memorija pridružena sjenčarovom 1. spremniku
 	unsigned int _max_uniform_memory;
 	
 
@@ -179,6 +225,33 @@ public:
 	VkPipelineLayout _compute_pipeline_Layout;
 	VkPipeline _default_compute_pipeline;
 
+	// Priručna memorija protočnih sustava - sprema se na disk kako se sjenčar ne bi ponovno prevodio pri svakom pokretanju
+	VkPipelineCache _pipeline_cache = VK_NULL_HANDLE;
+	std::string _pipeline_cache_path;
+	bool _pipeline_cache_loaded = false;
+
+	// Ako nije prazno, sjenčari se učitavaju iz ove mape umjesto iz izvršne datoteke
+	std::string _shader_override_dir;
+
+	// Varijante glavnog sjenčara u kojima su način raspršenja i broj iteracija konstante umjesto uniformnih vrijednosti.
+	// Dok se tražena varijanta prevodi u pozadini, koristi se opći _default_compute_pipeline.
+	// Drži se najviše _max_variant_pipelines varijanti - najdulje nekorištena se briše (trim_variant_pipelines)
+	struct VariantPipeline {
+		VkPipeline pipeline;
+		uint64_t last_used;
+	};
+	ShaderVariantCompiler _variant_compiler;
+	bool _use_shader_variants = true;
+	std::unordered_map<uint64_t, VariantPipeline> _variant_pipelines;
+	static constexpr size_t _max_variant_pipelines = 16;
+	uint64_t _variant_use_counter = 0;
+	std::unordered_set<uint64_t> _failed_variants;
+	uint64_t _requested_variant_key = 0;
+	// Tražena varijanta se još prevodi - iscrtava se općim sjenčarom
+	bool _shader_variant_pending = false;
+	VkPipeline _active_compute_pipeline = VK_NULL_HANDLE;
+	double _last_variant_build_ms = 0;
+
 	struct PipelineBuilder {
 	public:
 
@@ -187,11 +260,53 @@ public:
 		VkPipelineInputAssemblyStateCreateInfo _inputAssembly;
 		VkPipelineLayout _pipelineLayout;
 
-		VkPipeline build_compute_pipeline(VkDevice device);
+		VkPipeline build_compute_pipeline(VkDevice device, VkPipelineCache cache);
 	};
 
 
-	// GPU redovi za izvravanje naredbi
+	// Trajanje faza slike na GPU-u i broj poziva sjenčara (statistika protočnog sustava, ako je podržana)
+	GpuProfiler _gpu_profiler;
+	bool _pipeline_statistics_enabled = false;
+
+	// Ploča s performansama (F2)
+	PerformanceHud _performance_hud;
+
+	// Trag izvođenja (F3 ili --trag). Ako je putanja zadana, trag se snima od init() i zapisuje u cleanup()
+	std::string _trace_path;
+	unsigned int _trace_counter = 0;
+
+	// Snimanje unosa i parametara (F4 ili --snimi-unos) i ponavljanje snimke (--ponovi-unos)
+	InputRecorder _input_recorder;
+	InputPlayer _input_player;
+	std::string _input_record_path;
+	std::string _input_replay_path;
+	unsigned int _input_recording_counter = 0;
+
+	// Razmak slika pri ponavljanju: 0 - bez čekanja, > 0 - stalni korak (ms), < 0 - trajanje slika iz snimke
+	double _replay_step_ms = 0;
+
+	// Unaprijed zadana putanja (--putanja) zamjenjuje process_movement. Vrijeme putanje je broj slike / _camera_path_fps,
+	// pa put ne ovisi o brzini iscrtavanja
+	CameraPath _camera_path;
+	double _camera_path_fps = 60;
+
+	// Asinkrono čitanje izlaznih slika (slike zaslona, snimanje, način rada bez prozora)
+	FrameReadback _readback;
+	uint64_t _frame_number = 0;
+
+	// Zahtjevi s glavne dretve (F12, F11) - dretva iscrtavanja ih preuzima iz snimke stanja
+	uint64_t _screenshot_requests = 0;
+	bool _recording_requested = false;
+
+	// Stanje snimanja na dretvi iscrtavanja
+	bool _screenshot_requested = false;
+	bool _recording = false;
+	uint64_t _handled_screenshot_requests = 0;
+	unsigned int _screenshot_counter = 0;
+	uint64_t _recording_start_frame = 0;
+	std::string _capture_dir = "snimke";
+
+	// GPU redovi za izvršavanje naredbi
 	VkQueue _compute_queue;
 	uint32_t _compute_queue_family;
 
@@ -207,7 +322,7 @@ public:
 	
 
 	// Strukture za prikazivanje
-	VkSwapchainKHR _swapchain;
+	VkSwapchainKHR _swapchain = VK_NULL_HANDLE;
 	VkFormat _swapchain_image_format;
 	VkExtent2D _swapchain_extent;
 	std::vector<VkImage> _swapchain_images;
@@ -217,9 +332,39 @@ public:
 
 	VkRenderPass _renderPass;
 
+	// Način prezentacije koji korisnik želi (glavna dretva), onaj za koji je dretva iscrtavanja stvorila swapchain
+	// i onaj koji je swapchain stvarno dobio (ako traženi nije podržan)
+	VkPresentModeKHR _desired_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	VkPresentModeKHR _requested_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	VkPresentModeKHR _present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	std::vector<VkPresentModeKHR> _supported_present_modes;
+
+	bool _swapchain_needs_recreate = false;
+
+	// Promjena veličine prozora - swapchain se mijenja tek kada događaji promjene veličine prestanu stizati
+	bool _resize_pending = false;
+	std::chrono::steady_clock::time_point _last_resize_event;
+	const unsigned int _resize_debounce_ms = 50;
+
+	// Događaji promjene veličine na glavnoj dretvi i broj onih koje je dretva iscrtavanja preuzela
+	uint64_t _resize_events = 0;
+	std::chrono::steady_clock::time_point _last_window_resize;
+	uint64_t _handled_resize_events = 0;
+
+	// Izlazne slike se alociraju u razredima ove veličine, pa manja promjena prozora ne zahtijeva novu sliku
+	const unsigned int _output_image_bucket = 256;
+
+	// Mjerenje latencije od unosa do prikaza
+	bool _present_id_enabled = false;
+	LatencyTracker _latency;
+
 
 	bool should_quit = false;
 
+	// Mjerenje vremena od pokretanja do prve prikazane slike
+	std::chrono::steady_clock::time_point _startup_time;
+	bool _first_frame_presented = false;
+
 
 	bool _config_mode = false;
 	bool _hide_GUI = false;
@@ -239,6 +384,93 @@ public:
 
 	Camera_movement main_camera_movement;
 
+	// Kretanje kamere i sunca simulira se fiksnim korakom, neovisno o broju slika u sekundi. Prikazuje se interpolacija
+	// između zadnja dva koraka, pa kretanje ostaje glatko i kada se slike i koraci ne poklapaju
+	struct Simulation_state{
+		glm::vec3 previous_position = glm::vec3(0);
+		glm::vec3 position = glm::vec3(0);
+		float previous_sun_angle = 0;
+		float sun_angle = 0;
+
+		double accumulator = 0; // Vrijeme (s) koje još nije simulirano
+
+		// Zadnje prikazane vrijednosti - ako ih nešto drugo promijeni (sučelje, putanja), simulacija nastavlja od novih
+		glm::vec3 shown_position = glm::vec3(0);
+		float shown_sun_angle = 0;
+		bool initialized = false;
+	};
+
+	Simulation_state _simulation;
+	double _simulation_dt = 1.0 / 120.0;
+
+	// Najdulja slika koju simulacija nadoknađuje - nakon zastoja (npr. promjena veličine prozora) kamera ne skače
+	const double _max_frame_dt = 0.25;
+
+	// Ograničenje broja slika u sekundi (0 - bez ograničenja)
+	FramePacer _frame_pacer;
+
+	// Mirovanje: kada se ništa ne mijenja ili prozor nije vidljiv, glavna petlja čeka događaje umjesto da iscrtava.
+	// Prozor bez fokusa u kojem se nešto mijenja iscrtava se s _background_fps slika u sekundi (0 - ne iscrtava se)
+	bool _idle_enabled = true;
+	double _background_fps = 10;
+	unsigned int _frames_since_event = 0;
+	std::chrono::steady_clock::time_point _last_background_frame;
+
+	// Broj slika nakon zadnjeg događaja prije mirovanja - ImGui treba nekoliko slika da se sučelje smiri
+	const unsigned int _idle_settle_frames = 3;
+
+	// Najdulje čekanje događaja u mirovanju (ms), da se rezultati pozadinskih dretvi ne čekaju predugo
+	const int _idle_wait_ms = 250;
+
+	// Dretva iscrtavanja: glavna dretva obrađuje unos, simulaciju i sučelje, a zatim objavljuje snimku stanja
+	// (renderSnapshot.h) koju dretva iscrtavanja preuzima, snima naredbe i šalje ih na GPU. Zastoj sučelja tako ne kasni
+	// slanje slike. Bez dretve (--bez-dretve-iscrtavanja) ista snimka stanja iscrtava se odmah na glavnoj dretvi
+	bool _use_render_thread = true;
+	std::thread _render_thread;
+	TripleBuffer<RenderSnapshot> _snapshots;
+	RenderSnapshot _direct_snapshot;
+	uint64_t _snapshot_sequence = 0;
+	std::atomic<uint64_t> _rendered_sequence{ 0 };
+
+	// Stanje dretve iscrtavanja za sučelje (veličina slike, swapchain, varijanta sjenčara)
+	TripleBuffer<RenderStatus> _render_status;
+
+	std::atomic<bool> _render_thread_stop{ false };
+	std::atomic<bool> _render_thread_failed{ false };
+	std::exception_ptr _render_thread_error;
+
+	// Služi samo za buđenje dretvi koje čekaju - podaci se predaju bez zaključavanja
+	std::mutex _render_wake_mutex;
+	std::condition_variable _render_wake;
+
+	// Najdulje čekanje glavne dretve na preuzimanje slike (ms) - ako slanje zapne, prozor i dalje obrađuje događaje
+	const int _render_wait_ms = 100;
+
+	// Dretve koje uz dretvu iscrtavanja snimaju naredbe prolaza slike (sučelje, a kasnije i novi prolazi).
+	// 0 - svi prolazi snimaju se redom na dretvi iscrtavanja
+	unsigned int _recording_threads = 1;
+	WorkerPool _record_workers;
+
+	// Dinamička razlučivost: postavke su na glavnoj dretvi, a regulator na dretvi iscrtavanja (koja prima trajanja s GPU-a)
+	bool _dynamic_resolution = true;
+	double _frame_budget_ms = 1000.0 / 60.0;
+	ResolutionController _resolution;
+	VkExtent2D _last_render_extent = { 0, 0 };
+	int _last_sample_amount_in = 0;
+	int _last_sample_amount_out = 0;
+	bool _last_quality_reduced = false;
+	// Protočni sustav s kojim regulator mjeri trajanja - promjena ponovno pokreće mjerenje
+	VkPipeline _measured_compute_pipeline = VK_NULL_HANDLE;
+
+	// Foveacija - postavke iz sučelja, a točka fokusa se određuje za svaku sliku (foveation_parameters)
+	FoveationParameters _foveation;
+	FoveationFocus _foveation_focus = FoveationFocus::Center;
+	GazeInput _gaze;
+
+	// Prilagodljiv broj uzoraka po pločicama slike. Veličina pločice mora odgovarati ADAPTIVE_TILE_SIZE u sjenčaru
+	AdaptiveSampling _adaptive_sampling;
+	static constexpr unsigned int _adaptive_tile_size = 16;
+
 	Atmosphere prev_frame_atmosphere;
 
 	Sun sun;
@@ -267,12 +499,25 @@ private:
 
 	void allocate_compute_buffers();
 	void allocate_compute_images();
+	void allocate_output_image(unsigned int frame_index);
+	void retire_output_image(unsigned int frame_index);
+	void write_output_image_descriptor(unsigned int frame_index);
+	// Povećava izlaznu sliku ako ju je prozor prerastao (ili ju smanjuje ako je znatno prevelika)
+	void update_output_image(unsigned int frame_index);
 	void init_compute_descriptors();
+	void init_pipeline_cache();
+	void save_pipeline_cache();
 	void init_compute_pipelines();
+	void init_shader_variants();
+
+	// Bira varijantu sjenčara za zadane postavke i po potrebi traži njezino prevođenje
+	void update_shader_variant(const SceneParameters& scene);
+	void trim_variant_pipelines();
 
 	void init_swapchain();
 	void cleanup_swapchain();
-	void recreate_swapchain();
+	// Veličina prozora dolazi iz snimke stanja, jer se SDL prozoru pristupa samo s glavne dretve
+	void recreate_swapchain(unsigned int width, unsigned int height);
 
 	void init_framebuffers();
 
@@ -284,18 +529,75 @@ private:
 
 	void init_imgui();
 
-	bool load_shader_module(const char* filePath, VkShaderModule* outShaderModule);
+	void init_readback();
+
+	void init_gpu_profiler();
+	void toggle_trace();
+
+	std::vector<ReplayField> replay_fields();
+
+	void apply_camera_path(double time);
+	void update_camera_orientation();
+	void toggle_input_recording();
+	void write_trace(const std::string& path);
+	// Ispisuje prosječno trajanje faza na GPU-u za zadnjih nekoliko slika
+	void print_gpu_profile();
+
+	// Snima kopiju izlazne slike trenutnog frame-a za spremanje na disk (ako je zatražena)
+	void capture_output_image(VkCommandBuffer cmd);
 
-	// Sadri strukture svih GUI elemenata
+	// Učitava ugrađeni SPIR-V sjenčara po imenu (npr. "main_shader"), ili .spv datoteku iz _shader_override_dir ako je postavljen
+	bool load_shader_module(const char* shaderName, VkShaderModule* outShaderModule);
+	bool create_shader_module(const uint32_t* code, size_t codeSize, VkShaderModule* outShaderModule);
+
+	// Sadrži strukture svih GUI elemenata
 	void show_gui();
 
 
-	// Glavni proces pozivanja sjenara
-	void compute();
+	// Glavni proces pozivanja sjenčara
+	void compute(const RenderSnapshot& snapshot);
+
+	// Snimanje prolaza slike, svaki u svoj naredbeni spremnik
+	void record_passes(const std::vector<std::function<void()>>& passes);
+	void record_compute_pass(uint32_t swapchainImageIndex, VkExtent2D render_extent, bool adaptive_samples);
+	void record_gui_pass(const RenderSnapshot& snapshot, uint32_t swapchainImageIndex);
+
+	// Dretva iscrtavanja i predaja snimki stanja
+	void start_render_thread();
+	void stop_render_thread();
+	void render_thread_loop();
+	void wake_render_waiters();
+	void wait_for_render_thread();
+	void fill_snapshot(RenderSnapshot& snapshot);
+	FoveationParameters foveation_parameters(int window_width, int window_height);
+	void publish_snapshot();
+	void render_snapshot(const RenderSnapshot& snapshot);
+	void publish_render_status();
+
+	// Trenutni parametri scene iz članova (kamera, sunce, planet, postavke uzorkovanja)
+	SceneParameters scene_parameters() const;
+
+	// Ulazni podaci sjenčara iz parametara scene - zajednički za GPU i iscrtavanje na procesoru
+	// render_extent - dio izlazne slike koji sjenčar računa (manji od _screen_size uz dinamičku razlučivost)
+	void fill_shader_inputs(const SceneParameters& scene, VkExtent2D render_extent, shader_input_buffer_1& camera_input, shader_input_buffer_2& atmosphere_input);
+	void update_uniform_buffers(const SceneParameters& scene, VkExtent2D render_extent);
+	// adaptive_samples - prije punog prolaza izvodi se predprolaz koji procjenjuje budžet uzoraka pločica
+	void record_compute_dispatch(VkCommandBuffer cmd, VkExtent2D render_extent, bool adaptive_samples);
+
+	// Razlučivost i broj uzoraka ove slike prema regulatoru dinamičke razlučivosti (smanjuje uzorke u scene), te
+	// isključivanje foveacije i prilagodljivog broja uzoraka za slike koje moraju biti u punoj kvaliteti
+	VkExtent2D apply_frame_quality(const RenderSnapshot& snapshot, SceneParameters& scene);
 
 
 	void handle_input();
-	void process_movement();
+	void process_movement(double frame_dt);
+	// Kamera, sunce ili sučelje se još mijenjaju
+	bool scene_moving();
+	// Iscrtava se svaka slika neovisno o promjenama (snimanje, ploča s performansama, trag)
+	bool renders_continuously();
+	bool scene_changing();
+	bool wait_while_idle();
+	void simulation_step(double dt);
 
 	// Zove se kada se povezani parametri atmosfere promjene
 	void recalculate_K();
@@ -0,0 +1,37 @@
+#include "renderSnapshot.h"
+
+
+RenderSnapshot::~RenderSnapshot(){
+	free_draw_lists();
+}
+
+void RenderSnapshot::free_draw_lists(){
+	for (ImDrawList* list : _owned_lists) IM_DELETE(list);
+	_owned_lists.resize(0);
+}
+
+void RenderSnapshot::copy_draw_data(const ImDrawData* source, bool with_textures){
+
+	// Liste prošle kopije su sigurno iscrtane - ovaj spremnik je pisaču vraćen tek nakon što ga je čitač zamijenio
+	free_draw_lists();
+
+	ImDrawData& copy = _draw_data_copy;
+	copy.Clear();
+	copy.Valid = source->Valid;
+	copy.DisplayPos = source->DisplayPos;
+	copy.DisplaySize = source->DisplaySize;
+	copy.FramebufferScale = source->FramebufferScale;
+	copy.Textures = with_textures ? source->Textures : nullptr;
+
+	for (ImDrawList* list : source->CmdLists) {
+		ImDrawList* clone = list->CloneOutput();
+		_owned_lists.push_back(clone);
+
+		copy.CmdLists.push_back(clone);
+		copy.TotalVtxCount += clone->VtxBuffer.Size;
+		copy.TotalIdxCount += clone->IdxBuffer.Size;
+	}
+	copy.CmdListsCount = copy.CmdLists.Size;
+
+	draw_data = &copy;
+}
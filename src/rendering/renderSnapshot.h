@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "camera.h"
+#include "latencyTracker.h"
+#include "foveation.h"
+#include "../simulation/shaderInputs.h"
+
+#include "..\third-party\imgui\imgui.h"
+
+
+// Prilagodljiv broj uzoraka: predprolaz niske razlučivosti procjenjuje promjenu svjetline oko svake pločice slike,
+// a puni prolaz prema njoj dijeli uzorke - glatko nebo dobiva manje uzoraka od zalaska i ruba atmosfere
+struct AdaptiveSampling {
+	bool enabled = false;
+	float threshold = 0.15f;	// Relativna promjena svjetline u pločici iznad koje pločica dobiva sve uzorke
+	float min_factor = 0.1f;	// Najmanji udio ukupnog broja uzoraka
+	bool show_tiles = false;	// Budžet pločica prikazuje se preko slike
+};
+
+
+// Parametri scene koji određuju sadržaj slike - sve što sjenčar dobiva osim veličine slike
+struct SceneParameters {
+	Camera camera;
+	Sun sun;
+	Planet planet;
+	double K = 0;
+
+	int sample_amount_in = 0;
+	int sample_amount_out = 0;
+	bool do_rayleigh = true;
+	bool do_mie = true;
+
+	bool use_shader_variants = true;
+
+	// Udio ukupnog broja uzoraka po pikselu (dinamička razlučivost) - sjenčar ga primjenjuje po pikselu, a varijanta
+	// sjenčara zadržava zadani broj uzoraka
+	float sample_factor = 1;
+
+	// Samo slike u prozoru - scene_parameters() ju ostavlja isključenom
+	FoveationParameters foveation;
+	AdaptiveSampling adaptive;
+};
+
+
+// Nepromjenjivo stanje jedne slike koje glavna dretva (unos i sučelje) predaje dretvi iscrtavanja.
+// Zahtjevi su brojači, a ne zastavice, pa se ne gube ako dretva iscrtavanja preskoči neku snimku stanja
+struct RenderSnapshot {
+	uint64_t sequence = 0;
+
+	SceneParameters scene;
+
+	// Veličina prozora u trenutku izgradnje slike - SDL prozoru se pristupa samo s glavne dretve
+	unsigned int window_width = 0;
+	unsigned int window_height = 0;
+	bool window_minimized = false;
+
+	uint64_t resize_events = 0;
+	std::chrono::steady_clock::time_point last_resize_event;
+	uint64_t screenshot_requests = 0;
+	bool recording = false;
+	VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+
+	// Dinamička razlučivost (vidi ResolutionController). full_quality - scena se više ne mijenja, pa se slika
+	// iscrtava u punoj kvaliteti prije mirovanja
+	bool dynamic_resolution = false;
+	double frame_budget_ms = 0;
+	bool full_quality = false;
+
+	// Najraniji unos uključen u ovu sliku (bez vremena slanja)
+	LatencyTracker::FrameMark input;
+
+	// Sučelje ove slike - pokazuje na vlastitu kopiju (copy_draw_data) ili izravno na ImGui::GetDrawData()
+	ImDrawData* draw_data = nullptr;
+
+	RenderSnapshot() = default;
+	RenderSnapshot(const RenderSnapshot&) = delete;
+	RenderSnapshot& operator=(const RenderSnapshot&) = delete;
+	~RenderSnapshot();
+
+	// Kopira naredbe crtanja, jer ImGui iste liste ponovno koristi u sljedećoj slici. Teksture (npr. novi znakovi
+	// fonta) predaju se samo ako with_textures - tada glavna dretva ne smije graditi novu sliku dok ova nije iscrtana
+	void copy_draw_data(const ImDrawData* source, bool with_textures);
+
+private:
+	void free_draw_lists();
+
+	ImDrawData _draw_data_copy;
+	ImVector<ImDrawList*> _owned_lists;
+};
+
+
+// Stanje dretve iscrtavanja koje prikazuje sučelje, objavljeno nakon svake slike
+struct RenderStatus {
+	unsigned int screen_size_x = 0;
+	unsigned int screen_size_y = 0;
+
+	VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	unsigned int swapchain_image_count = 0;
+
+	bool variant_active = false;
+	bool variant_compiling = false;
+	double variant_build_ms = 0;
+
+	uint64_t handled_resize_events = 0;
+	uint64_t handled_screenshot_requests = 0;
+
+	// Veličina slike koju je sjenčar računao i broj uzoraka zadnje slike - uz dinamičku razlučivost manji od zadanih
+	unsigned int render_width = 0;
+	unsigned int render_height = 0;
+	int sample_amount_in = 0;
+	int sample_amount_out = 0;
+	bool quality_reduced = false;
+
+	// Swapchain se još mijenja ili slika zaslona još nije snimljena - potrebna je barem još jedna slika
+	bool work_pending = false;
+};
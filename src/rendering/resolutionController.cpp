@@ -0,0 +1,78 @@
+#include "resolutionController.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void ResolutionController::set_budget(double budget_ms){
+	if (budget_ms == _budget_ms) return;
+
+	_budget_ms = std::max(budget_ms, 0.1);
+	_measured_frames = 0;
+}
+
+void ResolutionController::set_min_scale(double min_scale){
+	_min_scale = std::clamp(min_scale, 0.1, 1.0);
+	if (_scale < _min_scale) {
+		_scale = _min_scale;
+		_generation++;
+		_measured_frames = 0;
+	}
+}
+
+void ResolutionController::reset(){
+	if (reduced()) _generation++;
+
+	_scale = 1;
+	_sample_factor = 1;
+	_measured_frames = 0;
+}
+
+void ResolutionController::restart_measurement(){
+	_generation++;
+	_measured_frames = 0;
+}
+
+void ResolutionController::add_frame(double gpu_ms){
+	if (gpu_ms <= 0) return;
+
+	_average_ms = _measured_frames == 0 ? gpu_ms : _average_ms + (gpu_ms - _average_ms) * _smoothing;
+	_measured_frames++;
+
+	// Previsoka vrijednost smanjuje se odmah - dovoljna je jedna slika
+	double measured_ms = gpu_ms > _budget_ms * _spike_threshold ? gpu_ms : _average_ms;
+	if (measured_ms > _budget_ms * _upper_threshold) {
+		scale_cost(_budget_ms * _target / measured_ms);
+	}
+	else if (measured_ms < _budget_ms * _lower_threshold && _measured_frames >= _increase_frames) {
+		scale_cost(std::min(_budget_ms * _target / measured_ms, _max_increase));
+	}
+}
+
+void ResolutionController::scale_cost(double ratio){
+
+	double scale = _scale;
+	double sample_factor = _sample_factor;
+
+	// Pri smanjivanju prvo se smanjuje razlučivost (povećanje je skoro nevidljivo pri kretanju), a tek onda uzorci.
+	// Povećava se obrnutim redom
+	if (ratio < 1) {
+		scale = std::max(_min_scale, _scale * std::sqrt(ratio));
+		double remaining = ratio / ((scale / _scale) * (scale / _scale));
+		if (remaining < 1) sample_factor = std::max(_min_sample_factor, _sample_factor * remaining);
+	}
+	else {
+		sample_factor = std::min(1.0, _sample_factor * ratio);
+		double remaining = ratio / (sample_factor / _sample_factor);
+		if (remaining > 1) scale = std::min(1.0, _scale * std::sqrt(remaining));
+	}
+
+	// Promjene manje od 1% ne vrijede nove slike s drugačijim postavkama
+	if (std::abs(scale - _scale) < 0.01 && std::abs(sample_factor - _sample_factor) < 0.01 &&
+		!(scale == 1 && _scale != 1) && !(sample_factor == 1 && _sample_factor != 1)) return;
+
+	_scale = scale;
+	_sample_factor = sample_factor;
+	_generation++;
+	_measured_frames = 0;
+}
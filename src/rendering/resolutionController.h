@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Dinamička razlučivost: prema trajanju slike na GPU-u mijenja udio piksela koje sjenčar računa (slika se zatim
+// povećava na veličinu prozora), a kada je razlučivost već najmanja, i broj uzoraka po zraki.
+// Histereza: kvaliteta se smanjuje tek iznad gornjeg praga, a povećava tek ispod donjeg, pa vrijednosti oko cilja ne
+// mijenjaju ništa. Smanjuje se odmah i koliko treba, a povećava sporo i u malim koracima
+class ResolutionController {
+
+public:
+	// Najdulje trajanje slike na GPU-u (ms) koje se pokušava održati
+	void set_budget(double budget_ms);
+	double budget() const { return _budget_ms; }
+
+	// Najmanji udio razlučivosti po osi. 1 - mijenja se samo broj uzoraka
+	void set_min_scale(double min_scale);
+
+	// Trajanje slike (ms) iscrtane s trenutnim postavkama - slike iscrtane prije zadnje promjene ne smiju se predavati
+	// (vidi generation()), jer ne pokazuju njezin učinak
+	void add_frame(double gpu_ms);
+
+	// Vraća punu kvalitetu
+	void reset();
+
+	// Postavke ostaju, ali se cijena slike promijenila (npr. drugi protočni sustav) - dosadašnja mjerenja se odbacuju,
+	// a slike iscrtane prije poziva više se ne smiju predavati
+	void restart_measurement();
+
+	// Udio razlučivosti po osi
+	double scale() const { return _scale; }
+	// Udio ukupnog broja uzoraka po pikselu (1 - zadani broj)
+	double sample_factor() const { return _sample_factor; }
+
+	bool reduced() const { return _scale < 1 || _sample_factor < 1; }
+
+	// Povećava se pri svakoj promjeni postavki
+	uint64_t generation() const { return _generation; }
+
+private:
+	// Mijenja cijenu slike za zadani omjer. Cijena je razmjerna broju piksela i broju uzoraka
+	void scale_cost(double ratio);
+
+	double _budget_ms = 1000.0 / 60.0;
+	double _min_scale = 0.5;
+	static constexpr double _min_sample_factor = 0.25;
+
+	// Pragovi i cilj kao udio budžeta
+	static constexpr double _upper_threshold = 0.95;
+	static constexpr double _lower_threshold = 0.7;
+	static constexpr double _target = 0.85;
+	// Jedna slika dulja od ovoga smanjuje kvalitetu bez čekanja prosjeka
+	static constexpr double _spike_threshold = 1.25;
+
+	// Najveće povećanje cijene u jednom koraku i broj slika s novim postavkama prije povećanja
+	static constexpr double _max_increase = 1.1;
+	static constexpr unsigned int _increase_frames = 8;
+	static constexpr double _smoothing = 0.25;
+
+	double _scale = 1;
+	double _sample_factor = 1;
+	uint64_t _generation = 1;
+
+	double _average_ms = 0;
+	unsigned int _measured_frames = 0;
+};
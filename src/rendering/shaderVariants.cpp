@@ -0,0 +1,255 @@
+#include "shaderVariants.h"
+#include "traceRecorder.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef SIMULACIJA_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+
+static const uint32_t spirv_magic = 0x07230203;
+
+
+bool ShaderVariantCompiler::runtime_compilation_available(){
+#ifdef SIMULACIJA_SHADERC
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+void ShaderVariantCompiler::init(const char* shader_name, const unsigned char* source, size_t source_size, const std::string& cache_dir, PipelineFactory factory){
+	_shader_name = shader_name;
+	_source.assign((const char*)source, source_size);
+	_cache_dir = cache_dir;
+	_factory = factory;
+
+#ifdef _WIN32
+	_mkdir(_cache_dir.c_str());
+#else
+	mkdir(_cache_dir.c_str(), 0755);
+#endif
+
+	// Varijante starih verzija izvora i davno korištenih postavki
+	prune_cache();
+
+	_running = true;
+	_worker = std::thread(&ShaderVariantCompiler::worker_loop, this);
+}
+
+void ShaderVariantCompiler::cleanup(){
+	if (!_running) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_running = false;
+		_has_request = false;
+	}
+	_cv.notify_all();
+	_worker.join();
+}
+
+
+uint64_t ShaderVariantCompiler::key_for(const std::vector<ShaderDefine>& defines) const{
+
+	// FNV-1a preko izvora i svih definicija
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const std::string& text){
+		for (unsigned char c : text){
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		// Separator, da "AB"+"C" i "A"+"BC" ne daju isti hash
+		hash ^= 0xff;
+		hash *= 1099511628211ull;
+	};
+
+	add(_source);
+	for (const ShaderDefine& define : defines){
+		add(define.name);
+		add(define.value);
+	}
+
+	return hash;
+}
+
+void ShaderVariantCompiler::request(uint64_t key, const std::vector<ShaderDefine>& defines){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_has_request = true;
+		_request_key = key;
+		_request_defines = defines;
+	}
+	_cv.notify_one();
+}
+
+bool ShaderVariantCompiler::poll(ShaderVariantResult& result){
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_results.empty()) return false;
+
+	result = _results.front();
+	_results.pop_front();
+	return true;
+}
+
+bool ShaderVariantCompiler::is_busy(){
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _has_request || _working;
+}
+
+
+void ShaderVariantCompiler::worker_loop(){
+
+	TraceRecorder::instance().set_thread_name("prevodenje sjencara");
+
+	while (true){
+		uint64_t key;
+		std::vector<ShaderDefine> defines;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [&]() { return !_running || _has_request; });
+			if (!_running) return;
+
+			key = _request_key;
+			defines = _request_defines;
+			_has_request = false;
+			_working = true;
+		}
+
+		TRACE_SCOPE("izgradnja_varijante");
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		ShaderVariantResult result;
+		result.key = key;
+
+		std::ostringstream path;
+		path << _cache_dir << "/" << _shader_name << "_" << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+
+		std::vector<uint32_t> spirv;
+		if (load_cached(path.str(), spirv)){
+			result.from_disk_cache = true;
+		}
+		else if (compile(defines, spirv, result.error)){
+			store_cached(path.str(), spirv);
+			prune_cache();
+		}
+
+		if (!spirv.empty()){
+			result.pipeline = _factory(spirv);
+			if (result.pipeline == VK_NULL_HANDLE && result.error.empty()) result.error = "Izgradnja protocnog sustava nije uspjela";
+		}
+
+		result.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_results.push_back(result);
+			_working = false;
+		}
+	}
+}
+
+
+bool ShaderVariantCompiler::load_cached(const std::string& path, std::vector<uint32_t>& spirv){
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	size_t fileSize = (size_t)file.tellg();
+
+	// Oštećene datoteke se ignoriraju i prevode ponovno
+	if (fileSize < sizeof(uint32_t) * 5 || fileSize % sizeof(uint32_t) != 0) return false;
+
+	spirv.resize(fileSize / sizeof(uint32_t));
+	file.seekg(0);
+	file.read((char*)spirv.data(), fileSize);
+
+	if (!file || spirv[0] != spirv_magic){
+		spirv.clear();
+		return false;
+	}
+	file.close();
+
+	// Vrijeme izmjene označava zadnju upotrebu - prema njemu prune_cache() briše najstarije
+	std::error_code error;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+	return true;
+}
+
+void ShaderVariantCompiler::store_cached(const std::string& path, const std::vector<uint32_t>& spirv){
+	// Privremena datoteka pa preimenovanje - druga instanca programa nikad ne vidi napola zapisanu datoteku
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return;
+		file.write((const char*)spirv.data(), spirv.size() * sizeof(uint32_t));
+	}
+	std::remove(path.c_str());
+	std::rename(temp_path.c_str(), path.c_str());
+}
+
+void ShaderVariantCompiler::prune_cache(){
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	std::string prefix = _shader_name + "_";
+	std::vector<std::pair<fs::file_time_type, fs::path>> files;
+
+	for (fs::directory_iterator it(_cache_dir, error), end; !error && it != end; it.increment(error)){
+		const fs::path& path = it->path();
+		if (path.extension() != ".spv" || path.filename().string().compare(0, prefix.size(), prefix) != 0) continue;
+
+		std::error_code time_error;
+		fs::file_time_type time = fs::last_write_time(path, time_error);
+		if (!time_error) files.emplace_back(time, path);
+	}
+
+	if (files.size() <= _max_cached_files) return;
+
+	// Najstarije prve
+	std::sort(files.begin(), files.end());
+	for (size_t i = 0; i + _max_cached_files < files.size(); i++){
+		fs::remove(files[i].second, error);
+	}
+}
+
+bool ShaderVariantCompiler::compile(const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv, std::string& error){
+#ifdef SIMULACIJA_SHADERC
+	shaderc::Compiler compiler;
+	shaderc::CompileOptions options;
+
+	for (const ShaderDefine& define : defines){
+		options.AddMacroDefinition(define.name, define.value);
+	}
+	options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+	options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+	shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(_source, shaderc_glsl_compute_shader, (_shader_name + ".comp").c_str(), options);
+
+	if (result.GetCompilationStatus() != shaderc_compilation_status_success){
+		error = result.GetErrorMessage();
+		return false;
+	}
+
+	spirv.assign(result.cbegin(), result.cend());
+	return true;
+#else
+	error = "Program je izgraden bez biblioteke shaderc - varijanta nije pronadena u prirucnoj memoriji";
+	return false;
+#endif
+}
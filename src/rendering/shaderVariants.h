@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+
+// Jedna #define vrijednost varijante sjenčara
+struct ShaderDefine {
+	std::string name;
+	std::string value;
+};
+
+// Rezultat izgradnje jedne varijante
+struct ShaderVariantResult {
+	uint64_t key = 0;
+	VkPipeline pipeline = VK_NULL_HANDLE; // VK_NULL_HANDLE ako prevođenje nije uspjelo
+	bool from_disk_cache = false;
+	double build_ms = 0;
+	std::string error;
+};
+
+
+// Prevodi varijante sjenčara (isti GLSL izvor s različitim #define vrijednostima) u pozadinskoj dretvi.
+// Prevedeni SPIR-V sprema se na disk pod imenom koje ovisi o hashu izvora i definicija, pa se svaka
+// kombinacija postavki prevodi samo jednom. Bez biblioteke shaderc koriste se samo već spremljene varijante.
+// Na disku se drži najviše _max_cached_files varijanti ovog sjenčara - brišu se one koje se najdulje nisu koristile.
+class ShaderVariantCompiler {
+
+public:
+	// Gradi protočni sustav iz SPIR-V-a - poziva se iz pozadinske dretve
+	using PipelineFactory = std::function<VkPipeline(const std::vector<uint32_t>& spirv)>;
+
+	static bool runtime_compilation_available();
+
+	void init(const char* shader_name, const unsigned char* source, size_t source_size, const std::string& cache_dir, PipelineFactory factory);
+	void cleanup();
+
+	// Ključ varijante - hash izvora i definicija
+	uint64_t key_for(const std::vector<ShaderDefine>& defines) const;
+
+	// Zahtjev za izgradnjom varijante. Ako prethodni zahtjev još nije započeo, zamjenjuje se ovim.
+	void request(uint64_t key, const std::vector<ShaderDefine>& defines);
+
+	// Preuzimanje gotovih varijanti - poziva glavna dretva, vraća false kada nema novih
+	bool poll(ShaderVariantResult& result);
+
+	bool is_busy();
+
+private:
+	void worker_loop();
+
+	bool load_cached(const std::string& path, std::vector<uint32_t>& spirv);
+	void store_cached(const std::string& path, const std::vector<uint32_t>& spirv);
+	void prune_cache();
+	bool compile(const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv, std::string& error);
+
+	std::string _shader_name;
+	std::string _source;
+	std::string _cache_dir;
+	PipelineFactory _factory;
+	static constexpr size_t _max_cached_files = 64;
+
+	std::thread _worker;
+	std::atomic<bool> _running{ false };
+
+	std::mutex _mutex;
+	std::condition_variable _cv;
+
+	bool _has_request = false;
+	bool _working = false;
+	uint64_t _request_key = 0;
+	std::vector<ShaderDefine> _request_defines;
+
+	std::deque<ShaderVariantResult> _results;
+};
@@ -0,0 +1,181 @@
+#include "traceRecorder.h"
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+
+
+TraceRecorder& TraceRecorder::instance(){
+	static TraceRecorder recorder;
+	return recorder;
+}
+
+void TraceRecorder::start(){
+
+	// Novi trag ne sadrži zone prethodnog
+	{
+		std::lock_guard<std::mutex> lock(_buffers_mutex);
+		for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+			std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+			buffer->next = 0;
+			buffer->count = 0;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(_gpu_mutex);
+		_gpu_next = 0;
+		_gpu_count = 0;
+		_has_gpu_offset = false;
+	}
+
+	_enabled.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::stop(){
+	_enabled.store(false, std::memory_order_relaxed);
+}
+
+int64_t TraceRecorder::to_ns(std::chrono::steady_clock::time_point time){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+
+TraceRecorder::ThreadBuffer& TraceRecorder::thread_buffer(){
+	// Zapis dretve stvara se pri imenovanju ili prvoj zoni i ostaje do kraja programa, pa pokazivač nikada ne postaje
+	// neispravan. Kružni spremnik zona alocira se tek pri prvoj zoni (add_cpu_zone), pa dretve bez snimanja drže samo ime
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer) {
+		std::lock_guard<std::mutex> lock(_buffers_mutex);
+		_buffers.emplace_back(new ThreadBuffer());
+		buffer = _buffers.back().get();
+		buffer->thread_id = (uint32_t)_buffers.size();
+	}
+	return *buffer;
+}
+
+void TraceRecorder::set_thread_name(const char* name){
+	ThreadBuffer& buffer = thread_buffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+void TraceRecorder::add_cpu_zone(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+	ThreadBuffer& buffer = thread_buffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+
+	if (buffer.zones.empty()) buffer.zones.resize(_zones_per_thread);
+	buffer.zones[buffer.next] = { name, to_ns(start), to_ns(end) };
+	buffer.next = (buffer.next + 1) % _zones_per_thread;
+	buffer.count = std::min(buffer.count + 1, _zones_per_thread);
+}
+
+void TraceRecorder::add_gpu_frame(const GpuProfiler::FrameTimes& times){
+	if (!enabled() || !times.has_submit_time) return;
+
+	double first_ns = 0;
+	bool any_stage = false;
+	for (int stage = 0; stage < GpuProfiler::StageCount; stage++) {
+		if (!times.stage_valid[stage]) continue;
+		if (!any_stage || times.stage_begin_ns[stage] < first_ns) first_ns = times.stage_begin_ns[stage];
+		any_stage = true;
+	}
+	if (!any_stage) return;
+
+	std::lock_guard<std::mutex> lock(_gpu_mutex);
+	if (_gpu.empty()) _gpu.resize(_gpu_zones);
+
+	// GPU ne može početi prije slanja, pa je pomak najmanje (slanje - početak) svake slike. Uzima se najveći
+	// dosad viđeni, pa je slika koja je počela odmah nakon slanja poravnata točno, a ostale kasne koliko su stvarno čekale
+	double offset = (double)to_ns(times.cpu_submit_time) - first_ns;
+	if (!_has_gpu_offset || offset > _gpu_offset_ns) _gpu_offset_ns = offset;
+	_has_gpu_offset = true;
+
+	for (int stage = 0; stage < GpuProfiler::StageCount; stage++) {
+		if (!times.stage_valid[stage]) continue;
+
+		_gpu[_gpu_next] = { (GpuProfiler::Stage)stage, (int64_t)(times.stage_begin_ns[stage] + _gpu_offset_ns), (int64_t)(times.stage_end_ns[stage] + _gpu_offset_ns) };
+		_gpu_next = (_gpu_next + 1) % _gpu_zones;
+		_gpu_count = std::min(_gpu_count + 1, _gpu_zones);
+	}
+}
+
+
+static void write_event(std::ostream& out, bool& first, const char* name, int pid, uint32_t tid, int64_t start_ns, int64_t end_ns, int64_t base_ns){
+	out << (first ? "\n" : ",\n") << "{\"name\":" << json_string(name) << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+		<< ",\"ts\":" << (start_ns - base_ns) / 1000.0 << ",\"dur\":" << std::max<int64_t>(end_ns - start_ns, 0) / 1000.0 << "}";
+	first = false;
+}
+
+static void write_name(std::ostream& out, bool& first, const char* kind, int pid, uint32_t tid, const std::string& name){
+	out << (first ? "\n" : ",\n") << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+		<< ",\"args\":{\"name\":" << json_string(name) << "}}";
+	first = false;
+}
+
+bool TraceRecorder::write(const std::string& path){
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out) return false;
+
+	// Kopije spremnika, da dretve ne čekaju dok se datoteka zapisuje
+	struct ThreadCopy {
+		uint32_t thread_id;
+		std::string name;
+		std::vector<Zone> zones;
+	};
+	std::vector<ThreadCopy> threads;
+	{
+		std::lock_guard<std::mutex> lock(_buffers_mutex);
+		for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+			std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+			ThreadCopy copy = { buffer->thread_id, buffer->name, {} };
+			for (size_t i = 0; i < buffer->count; i++) {
+				copy.zones.push_back(buffer->zones[(buffer->next + _zones_per_thread - buffer->count + i) % _zones_per_thread]);
+			}
+			threads.push_back(std::move(copy));
+		}
+	}
+
+	std::vector<GpuZone> gpu;
+	{
+		std::lock_guard<std::mutex> lock(_gpu_mutex);
+		for (size_t i = 0; i < _gpu_count; i++) {
+			gpu.push_back(_gpu[(_gpu_next + _gpu_zones - _gpu_count + i) % _gpu_zones]);
+		}
+	}
+
+	// Vremena u tragu počinju od najranije zone
+	int64_t base_ns = INT64_MAX;
+	for (const ThreadCopy& thread : threads) {
+		for (const Zone& zone : thread.zones) base_ns = std::min(base_ns, zone.start_ns);
+	}
+	for (const GpuZone& zone : gpu) base_ns = std::min(base_ns, zone.start_ns);
+	if (base_ns == INT64_MAX) base_ns = 0;
+
+	out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+
+	write_name(out, first, "process_name", 1, 0, "Procesor");
+	write_name(out, first, "process_name", 2, 0, "GPU");
+	write_name(out, first, "thread_name", 2, 1, "Komputacijski red");
+	write_name(out, first, "thread_name", 2, 2, "Graficki red");
+
+	for (const ThreadCopy& thread : threads) {
+		std::string name = thread.name.empty() ? "dretva " + std::to_string(thread.thread_id) : thread.name;
+		write_name(out, first, "thread_name", 1, thread.thread_id, name);
+
+		for (const Zone& zone : thread.zones) {
+			write_event(out, first, zone.name, 1, thread.thread_id, zone.start_ns, zone.end_ns, base_ns);
+		}
+	}
+
+	for (const GpuZone& zone : gpu) {
+		uint32_t queue = zone.stage == GpuProfiler::StageGui ? 2 : 1;
+		write_event(out, first, GpuProfiler::stage_name(zone.stage), 2, queue, zone.start_ns, zone.end_ns, base_ns);
+	}
+
+	out << "\n]}\n";
+	return (bool)out;
+}
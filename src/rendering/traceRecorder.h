@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gpuProfiler.h"
+
+
+// Snimanje vremenske crte izvođenja u formatu Chrome tracea (chrome://tracing, ui.perfetto.dev).
+// Svaka dretva piše zone u svoj kružni spremnik - kada se napuni, najstarije zone se prepisuju.
+// GPU faze iz GpuProfilera dodaju se na zasebnu crtu, poravnate s vremenom slanja slike na procesoru.
+// Dok snimanje nije uključeno, zona je samo provjera jedne zastavice
+class TraceRecorder {
+
+public:
+	static TraceRecorder& instance();
+
+	// start() briše zone prethodnog snimanja
+	void start();
+	void stop();
+	bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+	// Ime dretve u tragu - poziva se iz same dretve
+	void set_thread_name(const char* name);
+
+	// name mora trajati do zapisivanja (u pravilu literal)
+	void add_cpu_zone(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+	// Faze jedne slike s GPU-a. Sat GPU-a nije sinkroniziran sa satom procesora, pa se pomak procjenjuje tako
+	// da nijedna slika ne počne prije svog slanja
+	void add_gpu_frame(const GpuProfiler::FrameTimes& times);
+
+	// Zapisuje sve zone iz spremnika kao JSON. Snimanje se ne prekida
+	bool write(const std::string& path);
+
+	class Scope {
+	public:
+		explicit Scope(const char* name) : _name(name), _active(TraceRecorder::instance().enabled()) {
+			if (_active) _start = std::chrono::steady_clock::now();
+		}
+		~Scope() {
+			if (_active) TraceRecorder::instance().add_cpu_zone(_name, _start, std::chrono::steady_clock::now());
+		}
+
+	private:
+		const char* _name;
+		bool _active;
+		std::chrono::steady_clock::time_point _start;
+	};
+
+private:
+	struct Zone {
+		const char* name;
+		int64_t start_ns;
+		int64_t end_ns;
+	};
+
+	struct ThreadBuffer {
+		uint32_t thread_id;
+		std::string name;
+
+		// Vlasnik spremnika je jedna dretva, pa je mutex zauzet samo dok write() čita
+		std::mutex mutex;
+		std::vector<Zone> zones;	// Prazan dok dretva ne zapiše prvu zonu
+		size_t next = 0;
+		size_t count = 0;
+	};
+
+	struct GpuZone {
+		GpuProfiler::Stage stage;
+		int64_t start_ns;
+		int64_t end_ns;
+	};
+
+	ThreadBuffer& thread_buffer();
+	static int64_t to_ns(std::chrono::steady_clock::time_point time);
+
+	static constexpr size_t _zones_per_thread = 1 << 16;
+	static constexpr size_t _gpu_zones = 1 << 14;
+
+	std::atomic<bool> _enabled{ false };
+
+	std::mutex _buffers_mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+
+	std::mutex _gpu_mutex;
+	std::vector<GpuZone> _gpu;
+	size_t _gpu_next = 0;
+	size_t _gpu_count = 0;
+	bool _has_gpu_offset = false;
+	double _gpu_offset_ns = 0;
+};
+
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// Zona od mjesta poziva do kraja dosega
+#define TRACE_SCOPE(name) TraceRecorder::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
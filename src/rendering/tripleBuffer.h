@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+
+// Trostruki spremnik za predaju podataka između točno jedne dretve pisača i jedne dretve čitača, bez zaključavanja.
+// Pisač i čitač imaju svaki svoj spremnik, a treći čeka između njih - objava i preuzimanje samo atomarno zamjenjuju
+// indeks srednjeg spremnika. Čitač uvijek dobiva zadnju objavljenu vrijednost, a vrijednosti koje pisač objavi
+// prije nego što ih čitač preuzme se preskaču. Nijedna strana nikada ne čeka drugu
+template <typename T>
+class TripleBuffer {
+
+public:
+	// Spremnik u koji pisač upisuje sljedeću vrijednost. Sadrži neku od starijih vrijednosti, pa se pri pisanju
+	// moraju postaviti sva polja
+	T& write_buffer() { return _buffers[_write_index]; }
+
+	// Predaje spremnik za pisanje čitaču. Nakon objave pisač više ne smije pristupati prijašnjem write_buffer()
+	void publish() {
+		uint8_t previous = _middle.exchange((uint8_t)(_write_index | _new_bit), std::memory_order_acq_rel);
+		_write_index = previous & _index_mask;
+	}
+
+	// Ima li objavljene vrijednosti koju čitač još nije preuzeo (smije se pozivati s obje dretve)
+	bool has_new() const { return (_middle.load(std::memory_order_acquire) & _new_bit) != 0; }
+
+	// Čitač preuzima zadnju objavljenu vrijednost. Vraća false ako od prošlog preuzimanja ništa nije objavljeno
+	bool update() {
+		if (!has_new()) return false;
+		uint8_t previous = _middle.exchange(_read_index, std::memory_order_acq_rel);
+		_read_index = previous & _index_mask;
+		return true;
+	}
+
+	T& read_buffer() { return _buffers[_read_index]; }
+	const T& read_buffer() const { return _buffers[_read_index]; }
+
+private:
+	static constexpr uint8_t _index_mask = 0x3;
+	static constexpr uint8_t _new_bit = 0x4;
+
+	T _buffers[3];
+
+	// Indeksi su uvijek permutacija 0, 1 i 2
+	uint8_t _write_index = 0;
+	std::atomic<uint8_t> _middle{ 1 };
+	uint8_t _read_index = 2;
+};
@@ -0,0 +1,94 @@
+#include "workerPool.h"
+#include "traceRecorder.h"
+
+
+void WorkerPool::init(unsigned int thread_count, size_t max_queued_tasks, const char* thread_name){
+	if (thread_count == 0) thread_count = 1;
+
+	_max_queued_tasks = max_queued_tasks;
+	_thread_name = thread_name;
+	_running = true;
+
+	for (unsigned int i = 0; i < thread_count; i++){
+		_threads.emplace_back(&WorkerPool::worker_loop, this);
+	}
+}
+
+void WorkerPool::cleanup(){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_running) return;
+		_running = false;
+	}
+	_task_available.notify_all();
+	_space_available.notify_all();
+
+	// Dretve prije izlaska dovršavaju sve poslove koji su već u redu
+	for (std::thread& thread : _threads) thread.join();
+	_threads.clear();
+}
+
+
+bool WorkerPool::submit(std::function<void()> task){
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_space_available.wait(lock, [&]() { return !_running || _tasks.size() < _max_queued_tasks; });
+		if (!_running) return false;
+
+		_tasks.push_back(std::move(task));
+	}
+	_task_available.notify_one();
+	return true;
+}
+
+bool WorkerPool::try_submit(std::function<void()> task){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_running || _tasks.size() >= _max_queued_tasks) return false;
+
+		_tasks.push_back(std::move(task));
+	}
+	_task_available.notify_one();
+	return true;
+}
+
+void WorkerPool::wait_idle(){
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [&]() { return _tasks.empty() && _active_tasks == 0; });
+}
+
+size_t WorkerPool::queued_tasks(){
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _tasks.size();
+}
+
+
+void WorkerPool::worker_loop(){
+
+	TraceRecorder::instance().set_thread_name(_thread_name);
+
+	while (true){
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_task_available.wait(lock, [&]() { return !_running || !_tasks.empty(); });
+			if (_tasks.empty()) return; // Ugašen i nema više poslova
+
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+			_active_tasks++;
+		}
+		_space_available.notify_one();
+
+		{
+			TRACE_SCOPE("posao");
+			task();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_active_tasks--;
+			if (_tasks.empty() && _active_tasks == 0) _idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// Jednostavan bazen dretvi za poslove koji ne smiju usporavati glavnu petlju (npr. spremanje slika).
+// Red poslova je ograničen - kada je pun, submit() čeka, čime se glavna petlja usporava umjesto da troši memoriju
+class WorkerPool {
+
+public:
+	// thread_name - ime dretvi u tragu izvođenja
+	void init(unsigned int thread_count, size_t max_queued_tasks, const char* thread_name = "pozadinski poslovi");
+	void cleanup();
+
+	// Vraća false ako je bazen ugašen
+	bool submit(std::function<void()> task);
+
+	// Isto kao submit(), ali ne čeka ako je red pun
+	bool try_submit(std::function<void()> task);
+
+	// Čeka da se izvrše svi poslani poslovi
+	void wait_idle();
+
+	size_t queued_tasks();
+
+private:
+	void worker_loop();
+
+	std::vector<std::thread> _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _task_available;
+	std::condition_variable _space_available;
+	std::condition_variable _idle;
+
+	std::deque<std::function<void()>> _tasks;
+	size_t _max_queued_tasks = 0;
+	const char* _thread_name = nullptr;
+	unsigned int _active_tasks = 0;
+	bool _running = false;
+};
@@ -1,3 +0,0 @@
-%VULKAN_SDK%/Bin/glslc.exe main_shader.comp -g -o main_shader.spv
-pause
-
@@ -1,7 +1,7 @@
 struct Atmosphere{
-	alignas(4) float surface_pressure_pa; // Potrebno za raunanje gustoe i koliine estica za Rayleighovu jednadbu
-	alignas(4) float average_density_height; // Na ovoj visini se nalazi prosjena gustoa atmosfere
-	alignas(4) float average_density_height_aerosol; // Visina prosjene gustoe aerosola u atmosferi
+	alignas(4) float surface_pressure_pa; // Potrebno za računanje gustoće i količine čestica za Rayleighovu jednadžbu
+	alignas(4) float average_density_height; // Na ovoj visini se nalazi prosječna gustoća atmosfere
+	alignas(4) float average_density_height_aerosol; // Visina prosječne gustoće aerosola u atmosferi
 	alignas(4) float aerosol_density_mul;
 	alignas(4) float mie_asymmetry_const;
 
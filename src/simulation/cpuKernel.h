@@ -0,0 +1,82 @@
+#pragma once
+
+
+// Profil gustoće čestica po visini
+enum class CpuDensityProfile {
+	Exponential,	// exp(-visina / visina prosječne gustoće), kao u sjenčaru
+	Tabulated		// Linearna interpolacija tablice gustoće (CpuKernelParams::density_table)
+};
+
+// Način računanja optičke dubine (integrala gustoće) po putu svjetlosti
+enum class CpuOpticalDepth {
+	Marched,		// Koračanje sa sample_amount_out uzoraka, kao u sjenčaru
+	Analytic,		// Chapmanova aproksimacija - samo za eksponencijalni profil
+	Lut				// Tablica optičke dubine do ruba atmosfere po visini i kutu (CpuKernelParams::depth_lut)
+};
+
+
+// Vrijednosti koje su iste za sve piksele slike - računaju se jednom po slici (CpuRenderer::render)
+struct CpuKernelParams {
+	float look_dir[16];		// lookDir, po stupcima
+	float init_pos[3];
+	float init_dir[3];
+	float x_pos_multiplier, y_pos_multiplier;
+	float x_dir_multiplier, y_dir_multiplier;
+	float half_width, half_height;
+
+	int sample_amount_in;
+	int sample_amount_out;
+	int mode;
+
+	float planet_radius;
+	float atmosphere_radius;
+	float inv_average_distance;
+	float inv_average_distance_aerosol;
+	float aerosol_density_mul;
+
+	float sun_pos[3];
+	float sun_dir[3];		// normalize(sun_pos)
+	float sun_radius;
+	float starting_ray_light[3];
+	float starting_ray_light_length;
+
+	float rayleigh_scatter[3];	// K / valna_duljina^4 za svaku komponentu
+	float rayleigh_depth[3];	// 4 * pi * rayleigh_scatter
+	float mie_scatter;			// K / (900 nm)^4
+	float mie_depth;			// 4 * pi * mie_scatter
+
+	// Fazna funkcija Mie raspršivanja: mie_phase_scale * (1 + cos^2) / (mie_phase_base - mie_phase_cos * cos)^1.5
+	float mie_phase_scale;
+	float mie_phase_base;
+	float mie_phase_cos;
+
+	// Tablični profil: omjer gustoće i gustoće na površini za jednoliko razmaknute visine od površine do vrha atmosfere.
+	// [0] - molekule, [1] - aerosoli. Iznad vrha vrijedi zadnja vrijednost, a ispod površine gustoća raste eksponencijalno
+	const float* density_table[2];
+	int density_table_size;
+	float density_table_scale;		// (density_table_size - 1) / visina atmosfere
+
+	// Logaritam optičke dubine od točke do ruba atmosfere, [vrsta][visina][kut]. Visina je u tablici raspoređena
+	// po korijenu (gušće pri tlu), a kut je podijeljen obzorom: donja polovica su zrake koje pogađaju planet, gornja ostale
+	const float* depth_lut;
+	int depth_lut_heights;
+	int depth_lut_angles;
+
+	float average_distance[2];		// Visine prosječne gustoće molekula i aerosola (za Chapmanovu aproksimaciju)
+};
+
+// Inačica jezgre - bira se jednom po slici, a unutar jezgre su sve ove odluke konstante predloška
+struct CpuKernelVariant {
+	bool rayleigh;
+	bool mie;
+	CpuDensityProfile profile;
+	CpuOpticalDepth depth;
+};
+
+// Iscrtava piksele [x_begin, x_end) reda y. Izlaz je u obliku koji piše sjenčar (b, g, r, 0) - row pokazuje na početak reda
+using CpuSpanKernel = void (*)(const CpuKernelParams& params, int y, int x_begin, int x_end, float* row);
+
+// Analitička optička dubina uz tablični profil nije moguća - tada se koristi tablica optičke dubine
+CpuSpanKernel cpu_span_kernel_generic(const CpuKernelVariant& variant);
+CpuSpanKernel cpu_span_kernel_avx2(const CpuKernelVariant& variant);
+CpuSpanKernel cpu_span_kernel_avx512(const CpuKernelVariant& variant);
@@ -0,0 +1,12 @@
+#include "cpuKernelTemplates.h"
+
+
+// Prevodi se sa zastavicama za AVX2 i FMA (vidi src/CMakeLists.txt). Na procesorima druge arhitekture
+// zastavica nema, pa je ovo prenosiva jezgra - CpuRenderer ju tada ionako ne bira
+CpuSpanKernel cpu_span_kernel_avx2(const CpuKernelVariant& variant){
+#if defined(__AVX2__)
+	return select_span_kernel<PacketAvx2>(variant);
+#else
+	return select_span_kernel<PacketGeneric>(variant);
+#endif
+}
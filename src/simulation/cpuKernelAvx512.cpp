@@ -0,0 +1,12 @@
+#include "cpuKernelTemplates.h"
+
+
+// Prevodi se sa zastavicama za AVX-512 (vidi src/CMakeLists.txt). Na procesorima druge arhitekture
+// zastavica nema, pa je ovo prenosiva jezgra - CpuRenderer ju tada ionako ne bira
+CpuSpanKernel cpu_span_kernel_avx512(const CpuKernelVariant& variant){
+#if defined(__AVX512F__)
+	return select_span_kernel<PacketAvx512>(variant);
+#else
+	return select_span_kernel<PacketGeneric>(variant);
+#endif
+}
@@ -0,0 +1,11 @@
+#include "cpuKernelTemplates.h"
+
+
+// Prenosiva jezgra - prevodi se bez posebnih zastavica, pa radi na svakom procesoru (na x86-64 sa SSE2 paketima)
+CpuSpanKernel cpu_span_kernel_generic(const CpuKernelVariant& variant){
+#if defined(CPU_PACKETS_SSE2)
+	return select_span_kernel<PacketSse2>(variant);
+#else
+	return select_span_kernel<PacketGeneric>(variant);
+#endif
+}
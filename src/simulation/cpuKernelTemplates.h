@@ -0,0 +1,489 @@
+#pragma once
+
+#include "cpuKernel.h"
+#include "cpuPackets.h"
+
+
+// Sama jezgra - predložak preko vrste paketa i inačice (CpuKernelVariant), uključuje se samo u datoteke cpuKernel*.cpp
+// (cpuKernel.h sadrži samo sučelje koje koristi CpuRenderer).
+// Izračun prati main_shader.comp (i CpuRenderer::render_pixel), ali za cijeli paket zraka odjednom:
+// grananja sjenčara postaju maske, a skupi dijelovi se preskaču kada ih ne treba nijedna zraka u paketu.
+// Provjere načina raspršenja, profila i optičke dubine su parametri predloška, pa ih u petljama uzoraka nema.
+namespace {
+
+template<typename P>
+struct Vec3P {
+	P x, y, z;
+};
+
+template<typename P>
+inline Vec3P<P> operator+(const Vec3P<P>& a, const Vec3P<P>& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+template<typename P>
+inline Vec3P<P> operator-(const Vec3P<P>& a, const Vec3P<P>& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+template<typename P>
+inline Vec3P<P> operator*(const Vec3P<P>& a, const P& s) { return { a.x * s, a.y * s, a.z * s }; }
+template<typename P>
+inline Vec3P<P> operator-(const Vec3P<P>& a) { return { -a.x, -a.y, -a.z }; }
+
+template<typename P>
+inline P dot(const Vec3P<P>& a, const Vec3P<P>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+template<typename P>
+inline P length(const Vec3P<P>& a) { return sqrt(dot(a, a)); }
+template<typename P>
+inline Vec3P<P> normalize(const Vec3P<P>& a) { P inv = P(1.0f) / length(a); return a * inv; }
+
+template<typename P>
+inline Vec3P<P> broadcast(const float v[3]) { return { P(v[0]), P(v[1]), P(v[2]) }; }
+
+
+// exp(x) - Cephes aproksimacija, relativna greška oko 2 ULP-a
+template<typename P>
+inline P exp_packet(P x) {
+	x = min(max(x, P(-87.3365447f)), P(88.3762626f));
+
+	P fx = floor(x * P(1.44269504088896341f) + P(0.5f));
+
+	x = x - fx * P(0.693359375f);
+	x = x - fx * P(-2.12194440e-4f);
+
+	P z = x * x;
+	P y = P(1.9875691500e-4f);
+	y = y * x + P(1.3981999507e-3f);
+	y = y * x + P(8.3334519073e-3f);
+	y = y * x + P(4.1665795894e-2f);
+	y = y * x + P(1.6666665459e-1f);
+	y = y * x + P(5.0000001201e-1f);
+	y = y * z + x + P(1.0f);
+
+	return y * pow2n(fx);
+}
+
+
+template<typename P>
+struct SpherePacketResult {
+	typename P::Mask intersect;
+	P t_min;
+	P t_max;
+};
+
+// ray_sphere_intersect iz sjenčara - smjer mora biti normaliziran
+template<typename P>
+inline SpherePacketResult<P> ray_sphere_packet(const Vec3P<P>& ray_pos, const Vec3P<P>& ray_dir_n, const Vec3P<P>& sphere_pos, float sphere_r) {
+	Vec3P<P> pos_diff = ray_pos - sphere_pos;
+
+	P b = P(2.0f) * dot(ray_dir_n, pos_diff);
+	P c = dot(pos_diff, pos_diff) - P(sphere_r * sphere_r);
+	P d = b * b - P(4.0f) * c;
+
+	SpherePacketResult<P> res;
+	res.intersect = d > P(0.0f);
+
+	P root = sqrt(max(d, P(0.0f)));
+	P t1 = (-b + root) * P(0.5f);
+	P t2 = (-b - root) * P(0.5f);
+	res.t_min = min(t1, t2);
+	res.t_max = max(t1, t2);
+	return res;
+}
+
+// Vrste čestica: 0 - molekule (Rayleigh), 1 - aerosoli (Mie)
+template<int Species>
+inline float inv_average_distance(const CpuKernelParams& params) {
+	return Species == 0 ? params.inv_average_distance : params.inv_average_distance_aerosol;
+}
+
+// Omjer gustoće na visini height i gustoće na površini
+template<CpuDensityProfile Profile, int Species, typename P>
+inline P density_ratio_packet(const CpuKernelParams& params, const P& height) {
+	if constexpr (Profile == CpuDensityProfile::Exponential) {
+		return exp_packet(-height * P(inv_average_distance<Species>(params)));
+	}
+	else {
+		const float* table = params.density_table[Species];
+		P u = min(max(height * P(params.density_table_scale), P(0.0f)), P(float(params.density_table_size - 1)));
+		P i = min(floor(u), P(float(params.density_table_size - 2)));
+		P f = u - i;
+		P d0 = gather(table, i);
+		P d1 = gather(table + 1, i);
+		P density = d0 + (d1 - d0) * f;
+
+		// Ispod površine (zrake do sunca kroz planet) gustoća raste eksponencijalno kao u sjenčaru, inače bi planet propuštao svjetlost
+		typename P::Mask underground = height < P(0.0f);
+		if (!any(underground)) return density;
+		return select(underground, P(table[0]) * exp_packet(-height * P(inv_average_distance<Species>(params))), density);
+	}
+}
+
+// outScatter_partial iz sjenčara, za tražene vrste čestica u istom prolazu (dijele uzorke i udaljenosti)
+template<CpuDensityProfile Profile, bool Rayleigh, bool Mie, typename P>
+inline void out_scatter_packet(const CpuKernelParams& params, const Vec3P<P>& start, const Vec3P<P>& end, P& rayleigh, P& mie) {
+	int sample_amount_out = params.sample_amount_out;
+	P step_length = length(end - start) * P(1.0f / sample_amount_out);
+
+	rayleigh = P(0.0f);
+	mie = P(0.0f);
+	for (int j = 0; j < sample_amount_out; j++) {
+		float f = float(j) / (sample_amount_out - 1);
+		Vec3P<P> pos = start * P(1 - f) + end * P(f);
+
+		P distance_from_surface = length(pos) - P(params.planet_radius);
+
+		if constexpr (Rayleigh) rayleigh = rayleigh + density_ratio_packet<Profile, 0>(params, distance_from_surface) * step_length;
+		if constexpr (Mie) mie = mie + density_ratio_packet<Profile, 1>(params, distance_from_surface) * step_length;
+	}
+}
+
+// exp(z^2) * erfc(z) za z >= 0 - racionalna aproksimacija, relativna greška ispod 4e-4
+template<typename P>
+inline P erfcx_packet(const P& z) {
+	P num = P(1.0f) + z * (P(0.98944f) + z * P(0.39442f));
+	P den = P(1.0f) + z * (P(2.12475f) + z * (P(1.75050f) + z * P(0.39442f * 1.7724539f)));
+	return num / den;
+}
+
+// Optička dubina od pos do ruba atmosfere u smjeru dir_n, bez koračanja
+template<CpuOpticalDepth Depth, int Species, typename P>
+inline P depth_to_exit_packet(const CpuKernelParams& params, const Vec3P<P>& pos, const Vec3P<P>& dir_n) {
+	P r = length(pos);
+	P mu = dot(pos, dir_n) / r;
+
+	if constexpr (Depth == CpuOpticalDepth::Analytic) {
+		// Chapmanova funkcija Ch(x, mu) ~ sqrt(pi * x / 2) * erfcx(sqrt(x / 2) * mu), x = r / H. Zraka prema dolje prolazi
+		// najnižu točku putanje (r0), pa je njezina dubina dvostruka vodoravna dubina iz r0 umanjena za dubinu suprotne zrake
+		float H = params.average_distance[Species];
+		float inv_H = inv_average_distance<Species>(params);
+
+		P half_x = r * P(0.5f * inv_H);
+		P mu_abs = max(mu, -mu);
+		P upper = P(H * 1.7724539f) * sqrt(half_x) * exp_packet((P(params.planet_radius) - r) * P(inv_H)) * erfcx_packet(sqrt(half_x) * mu_abs);
+
+		typename P::Mask downward = mu < P(0.0f);
+		if (!any(downward)) return upper;
+
+		P r0 = r * sqrt(max(P(1.0f) - mu * mu, P(0.0f)));
+		P lower = P(2.0f * H * 1.7724539f) * sqrt(r0 * P(0.5f * inv_H)) * exp_packet((P(params.planet_radius) - r0) * P(inv_H)) - upper;
+		return select(downward, lower, upper);
+	}
+	else {
+		const int heights = params.depth_lut_heights;
+		const int angles = params.depth_lut_angles;
+		const int half = angles / 2;
+
+		float atmosphere_height = params.atmosphere_radius - params.planet_radius;
+		P height = min(max((r - P(params.planet_radius)) * P(1.0f / atmosphere_height), P(0.0f)), P(1.0f));
+		P uh = sqrt(height) * P(float(heights - 1));
+
+		// Kut se mjeri od obzora, da interpolacija ne miješa zrake koje pogađaju planet s onima koje ga promašuju
+		P rho = P(params.planet_radius) / max(r, P(params.planet_radius));
+		P mu_horizon = -sqrt(P(1.0f) - rho * rho);
+		typename P::Mask below = mu < mu_horizon;
+		P u_below = (mu + P(1.0f)) / (mu_horizon + P(1.0f));
+		P u_above = (mu - mu_horizon) / (P(1.0f) - mu_horizon);
+		P ua = select(below, min(max(u_below, P(0.0f)), P(1.0f)) * P(float(half - 1)),
+			P(float(half)) + min(max(u_above, P(0.0f)), P(1.0f)) * P(float(half - 1)));
+
+		P ih = min(floor(uh), P(float(heights - 2)));
+		P ia = min(floor(ua), select(below, P(float(half - 2)), P(float(angles - 2))));
+		P fh = uh - ih;
+		P fa = ua - ia;
+
+		const float* table = params.depth_lut + (size_t)Species * heights * angles;
+		P index = ih * P(float(angles)) + ia;
+		P d00 = gather(table, index);
+		P d01 = gather(table + 1, index);
+		P d10 = gather(table + angles, index);
+		P d11 = gather(table + angles + 1, index);
+
+		P d0 = d00 + (d01 - d00) * fa;
+		P d1 = d10 + (d11 - d10) * fa;
+		return exp_packet(d0 + (d1 - d0) * fh);
+	}
+}
+
+// Optička dubina od pos do izlaska iz atmosfere (t_exit duž dir_n) za tražene vrste čestica
+template<CpuDensityProfile Profile, CpuOpticalDepth Depth, bool Rayleigh, bool Mie, typename P>
+inline void exit_depth_packet(const CpuKernelParams& params, const Vec3P<P>& pos, const Vec3P<P>& dir_n, const P& t_exit, P& rayleigh, P& mie) {
+	if constexpr (Depth == CpuOpticalDepth::Marched) {
+		out_scatter_packet<Profile, Rayleigh, Mie>(params, pos, pos + dir_n * t_exit, rayleigh, mie);
+	}
+	else {
+		rayleigh = P(0.0f);
+		mie = P(0.0f);
+		if constexpr (Rayleigh) rayleigh = depth_to_exit_packet<Depth, 0>(params, pos, dir_n);
+		if constexpr (Mie) mie = depth_to_exit_packet<Depth, 1>(params, pos, dir_n);
+	}
+}
+
+
+template<typename P, bool Rayleigh, bool Mie, CpuDensityProfile Profile, CpuOpticalDepth Depth>
+inline void render_packet(const CpuKernelParams& params, int y, int x, float* out_b, float* out_g, float* out_r, float* out_a) {
+	using M = typename P::Mask;
+
+	const float* look = params.look_dir;
+	const int sample_amount_in = params.sample_amount_in;
+
+	// Zrake paketa - susjedni pikseli u redu
+	P px = P((float)x) + P::lane_index() - P(params.half_width);
+	P py = -(P((float)y) - P(params.half_height));
+
+	P pos_x = px * P(params.x_pos_multiplier);
+	P pos_y = py * P(params.y_pos_multiplier);
+	Vec3P<P> init_pos = {
+		P(look[0]) * pos_x + P(look[4]) * pos_y + P(params.init_pos[0]),
+		P(look[1]) * pos_x + P(look[5]) * pos_y + P(params.init_pos[1]),
+		P(look[2]) * pos_x + P(look[6]) * pos_y + P(params.init_pos[2])
+	};
+
+	P dir_x = px * P(params.x_dir_multiplier) + P(params.init_dir[0]);
+	P dir_y = py * P(params.y_dir_multiplier) + P(params.init_dir[1]);
+	P dir_z = P(params.init_dir[2]);
+
+	// lookDir * vec4(velocity, 1), pa dijeljenje s w
+	P w = P(look[3]) * dir_x + P(look[7]) * dir_y + P(look[11]) * dir_z + P(look[15]);
+	Vec3P<P> velocity = {
+		(P(look[0]) * dir_x + P(look[4]) * dir_y + P(look[8]) * dir_z + P(look[12])) / w,
+		(P(look[1]) * dir_x + P(look[5]) * dir_y + P(look[9]) * dir_z + P(look[13])) / w,
+		(P(look[2]) * dir_x + P(look[6]) * dir_y + P(look[10]) * dir_z + P(look[14])) / w
+	};
+	Vec3P<P> velocity_n = normalize(velocity);
+
+	// Zraka unutar planeta
+	P init_distance = length(init_pos);
+	M inside_planet = init_distance < P(params.planet_radius);
+	P floor_scale = dot(velocity_n, init_pos * (P(1.0f) / init_distance)) * P(0.5f) + P(0.5f);
+
+	Vec3P<P> planet_pos = { P(0.0f), P(0.0f), P(0.0f) };
+	Vec3P<P> sun_pos = broadcast<P>(params.sun_pos);
+
+	SpherePacketResult<P> planet_intersect = ray_sphere_packet(init_pos, velocity_n, planet_pos, params.planet_radius);
+	M intersecting_planet = planet_intersect.intersect & (planet_intersect.t_min > P(0.0f));
+	P planet_t_min = select(intersecting_planet, planet_intersect.t_min, P(0.0f));
+	Vec3P<P> planet_t_pos = init_pos + velocity_n * planet_t_min;
+
+	SpherePacketResult<P> sun_intersect = ray_sphere_packet(init_pos, velocity_n, sun_pos, params.sun_radius);
+	M looking_at_sun = sun_intersect.intersect & (sun_intersect.t_min > P(0.0f)) & !intersecting_planet;
+
+	SpherePacketResult<P> atmosphere_intersect = ray_sphere_packet(init_pos, velocity_n, planet_pos, params.atmosphere_radius);
+	M intersecting_atmosphere = atmosphere_intersect.intersect & ((atmosphere_intersect.t_min > P(0.0f)) | (atmosphere_intersect.t_max > P(0.0f)));
+
+	P t_min = max(atmosphere_intersect.t_min, P(0.0f));
+	P t_max = atmosphere_intersect.t_max;
+
+	M planet_reflection = intersecting_planet & (t_max > planet_t_min);
+	t_max = select(planet_reflection, planet_t_min, t_max);
+
+	Vec3P<P> ray_light = broadcast<P>(params.starting_ray_light);
+	Vec3P<P> total_light = { P(0.0f), P(0.0f), P(0.0f) };
+
+	M active = intersecting_atmosphere & !inside_planet;
+
+	if (any(active)) {
+		Vec3P<P> view_start = init_pos + velocity_n * t_min;
+		P sample_weight = (t_max - t_min) * P(1.0f / sample_amount_in);
+
+		Vec3P<P> sun_dir = broadcast<P>(params.sun_dir);
+		P surface_cos = max(P(0.0f), dot(sun_dir, normalize(planet_t_pos)));
+		const float floor_reflect = 0.3f * 0.0001f;
+
+		// Bez koračanja je dubina od view_start do uzorka razlika dubina do ruba atmosfere iz obje točke. Za zrake koje
+		// pogađaju planet gleda se u suprotnom smjeru, jer bi put do ruba inače prolazio kroz planet
+		Vec3P<P> view_dir = { select(intersecting_planet, -velocity_n.x, velocity_n.x),
+			select(intersecting_planet, -velocity_n.y, velocity_n.y),
+			select(intersecting_planet, -velocity_n.z, velocity_n.z) };
+		P view_sign = select(intersecting_planet, P(-1.0f), P(1.0f));
+		P view_start_depth = P(0.0f), view_start_depth_mie = P(0.0f);
+		if constexpr (Depth != CpuOpticalDepth::Marched) {
+			exit_depth_packet<Profile, Depth, Rayleigh, Mie>(params, view_start, view_dir, P(0.0f), view_start_depth, view_start_depth_mie);
+		}
+
+		for (int i = 1; i < sample_amount_in; i++) {
+			bool last_sample = i == sample_amount_in - 1;
+
+			float f = float(i) / (sample_amount_in - 1);
+			P t_smpl = t_min * P(1 - f) + t_max * P(f);
+
+			Vec3P<P> t_pos = init_pos + velocity_n * t_smpl;
+			Vec3P<P> ray_sun_n = normalize(sun_pos - t_pos);
+
+			SpherePacketResult<P> sample_planet_intersect = ray_sphere_packet(t_pos, ray_sun_n, planet_pos, params.planet_radius);
+			M hit_surface = sample_planet_intersect.intersect & (sample_planet_intersect.t_max + P(0.1f) > P(0.0f));
+
+			// Običan slučaj, a za zrake koje se odbijaju od površine samo točke prije zadnje čiji put do sunca ne siječe planet
+			M normal_case = !planet_reflection;
+			if (!last_sample) normal_case = normal_case | (!hit_surface);
+
+			SpherePacketResult<P> sample_atmosphere_intersect = ray_sphere_packet(t_pos, ray_sun_n, planet_pos, params.atmosphere_radius);
+			M lit_normal = normal_case & sample_atmosphere_intersect.intersect & active;
+
+			// Odbijanje od površine - samo zadnja točka uzorka
+			M lit_reflection = planet_reflection & sample_atmosphere_intersect.intersect & active;
+			bool any_reflection = last_sample && any(lit_reflection);
+
+			Vec3P<P> in_scatter_light = { P(0.0f), P(0.0f), P(0.0f) };
+			Vec3P<P> arriving_light = { P(0.0f), P(0.0f), P(0.0f) };
+
+			if (any(lit_normal) || any_reflection) {
+				P average_density_ratio, average_density_ratio_mie;
+				exit_depth_packet<Profile, Depth, true, Mie>(params, t_pos, ray_sun_n, sample_atmosphere_intersect.t_max, average_density_ratio, average_density_ratio_mie);
+
+				if (any(lit_normal)) {
+					P transmittance_r = exp_packet(-P(params.rayleigh_depth[0]) * average_density_ratio);
+					P transmittance_g = exp_packet(-P(params.rayleigh_depth[1]) * average_density_ratio);
+					P transmittance_b = exp_packet(-P(params.rayleigh_depth[2]) * average_density_ratio);
+
+					Vec3P<P> arriving = { ray_light.x * transmittance_r, ray_light.y * transmittance_g, ray_light.z * transmittance_b };
+
+					P cos_sun_angle = dot(ray_sun_n, velocity_n);
+					P cos_term = P(1.0f) + cos_sun_angle * cos_sun_angle;
+
+					P density_ratio = density_ratio_packet<Profile, 0>(params, length(t_pos) - P(params.planet_radius));
+
+					Vec3P<P> scattered = { P(0.0f), P(0.0f), P(0.0f) };
+					if constexpr (Rayleigh) {
+						P angle_const_rayleigh = P(0.75f) * cos_term;
+						P common = angle_const_rayleigh * density_ratio;
+						scattered.x = arriving.x * common * P(params.rayleigh_scatter[0]);
+						scattered.y = arriving.y * common * P(params.rayleigh_scatter[1]);
+						scattered.z = arriving.z * common * P(params.rayleigh_scatter[2]);
+					}
+					if constexpr (Mie) {
+						P base = P(params.mie_phase_base) - P(params.mie_phase_cos) * cos_sun_angle;
+						P angle_const_mie = P(params.mie_phase_scale) * cos_term / (base * sqrt(base));
+						P mie_part_2 = P(params.starting_ray_light_length) * angle_const_mie * density_ratio * P(params.mie_scatter)
+							* exp_packet(-P(params.mie_depth) * average_density_ratio_mie) * P(params.aerosol_density_mul);
+						scattered = scattered + Vec3P<P>{ mie_part_2, mie_part_2, mie_part_2 };
+					}
+
+					in_scatter_light.x = select(lit_normal, scattered.x, P(0.0f));
+					in_scatter_light.y = select(lit_normal, scattered.y, P(0.0f));
+					in_scatter_light.z = select(lit_normal, scattered.z, P(0.0f));
+					arriving_light.x = select(lit_normal, arriving.x, P(0.0f));
+					arriving_light.y = select(lit_normal, arriving.y, P(0.0f));
+					arriving_light.z = select(lit_normal, arriving.z, P(0.0f));
+				}
+
+				if (any_reflection) {
+					Vec3P<P> depth = { P(0.0f), P(0.0f), P(0.0f) };
+					if constexpr (Rayleigh) {
+						depth.x = P(params.rayleigh_depth[0]) * average_density_ratio;
+						depth.y = P(params.rayleigh_depth[1]) * average_density_ratio;
+						depth.z = P(params.rayleigh_depth[2]) * average_density_ratio;
+					}
+					if constexpr (Mie) {
+						P mie_part_1 = P(params.mie_depth) * average_density_ratio_mie * P(params.aerosol_density_mul);
+						depth = depth + Vec3P<P>{ mie_part_1, mie_part_1, mie_part_1 };
+					}
+
+					arriving_light.x = select(lit_reflection, ray_light.x * exp_packet(-depth.x), arriving_light.x);
+					arriving_light.y = select(lit_reflection, ray_light.y * exp_packet(-depth.y), arriving_light.y);
+					arriving_light.z = select(lit_reflection, ray_light.z * exp_packet(-depth.z), arriving_light.z);
+				}
+			}
+
+			// Gledanje izravno u sunce
+			in_scatter_light.x = select(looking_at_sun, arriving_light.x, in_scatter_light.x);
+			in_scatter_light.y = select(looking_at_sun, arriving_light.y, in_scatter_light.y);
+			in_scatter_light.z = select(looking_at_sun, arriving_light.z, in_scatter_light.z);
+
+			// Difuzno odbijanje od površine u zadnjoj točki uzorka
+			if (last_sample && any(planet_reflection)) {
+				P reflect = P(floor_reflect) * surface_cos;
+				in_scatter_light.x = select(planet_reflection, arriving_light.x * reflect, in_scatter_light.x);
+				in_scatter_light.y = select(planet_reflection, arriving_light.y * reflect, in_scatter_light.y);
+				in_scatter_light.z = select(planet_reflection, arriving_light.z * reflect, in_scatter_light.z);
+			}
+
+			// Izlazno raspršivanje od točke uzorka do očišta
+			P average_density_ratio_2, average_density_ratio_2_mie;
+			if constexpr (Depth == CpuOpticalDepth::Marched) {
+				out_scatter_packet<Profile, Rayleigh, Mie>(params, view_start, t_pos, average_density_ratio_2, average_density_ratio_2_mie);
+			}
+			else {
+				P sample_depth, sample_depth_mie;
+				exit_depth_packet<Profile, Depth, Rayleigh, Mie>(params, t_pos, view_dir, P(0.0f), sample_depth, sample_depth_mie);
+				average_density_ratio_2 = max((view_start_depth - sample_depth) * view_sign, P(0.0f));
+				average_density_ratio_2_mie = max((view_start_depth_mie - sample_depth_mie) * view_sign, P(0.0f));
+			}
+
+			Vec3P<P> depth = { P(0.0f), P(0.0f), P(0.0f) };
+			if constexpr (Rayleigh) {
+				depth.x = P(params.rayleigh_depth[0]) * average_density_ratio_2;
+				depth.y = P(params.rayleigh_depth[1]) * average_density_ratio_2;
+				depth.z = P(params.rayleigh_depth[2]) * average_density_ratio_2;
+			}
+			if constexpr (Mie) {
+				P mie_part_1 = P(params.mie_depth) * average_density_ratio_2_mie * P(params.aerosol_density_mul);
+				depth = depth + Vec3P<P>{ mie_part_1, mie_part_1, mie_part_1 };
+			}
+
+			total_light.x = total_light.x + in_scatter_light.x * exp_packet(-depth.x) * sample_weight;
+			total_light.y = total_light.y + in_scatter_light.y * exp_packet(-depth.y) * sample_weight;
+			total_light.z = total_light.z + in_scatter_light.z * exp_packet(-depth.z) * sample_weight;
+		}
+	}
+
+	// Spajanje slučajeva - redoslijed odgovara ranim izlazima iz sjenčara
+	P floor_value = P(0.3f) * floor_scale;
+	P space_r = select(looking_at_sun, ray_light.x, P(0.0f));
+	P space_g = select(looking_at_sun, ray_light.y, P(0.0f));
+	P space_b = select(looking_at_sun, ray_light.z, P(0.0f));
+	P space_a = select(looking_at_sun, P(1.0f), P(0.0f));
+
+	// Svemir i sunce se u sjenčaru zapisuju bez zamjene komponenata
+	P b = select(inside_planet, floor_value, select(intersecting_atmosphere, total_light.z, space_r));
+	P g = select(inside_planet, floor_value, select(intersecting_atmosphere, total_light.y, space_g));
+	P r = select(inside_planet, floor_value, select(intersecting_atmosphere, total_light.x, space_b));
+	P a = select(inside_planet, P(0.0f), select(intersecting_atmosphere, P(0.0f), space_a));
+
+	b.store(out_b);
+	g.store(out_g);
+	r.store(out_r);
+	a.store(out_a);
+}
+
+template<typename P, bool Rayleigh, bool Mie, CpuDensityProfile Profile, CpuOpticalDepth Depth>
+void render_span(const CpuKernelParams& params, int y, int x_begin, int x_end, float* row) {
+	alignas(64) float b[P::width], g[P::width], r[P::width], a[P::width];
+
+	for (int x = x_begin; x < x_end; x += P::width) {
+		render_packet<P, Rayleigh, Mie, Profile, Depth>(params, y, x, b, g, r, a);
+
+		// Zadnji paket reda može imati manje piksela od širine paketa
+		int count = x_end - x < P::width ? x_end - x : P::width;
+		for (int lane = 0; lane < count; lane++) {
+			float* pixel = row + (size_t)(x + lane) * 4;
+			pixel[0] = b[lane];
+			pixel[1] = g[lane];
+			pixel[2] = r[lane];
+			pixel[3] = a[lane];
+		}
+	}
+}
+
+
+// Odabir instancije za inačicu - svaka kombinacija je zasebna funkcija bez provjera u petljama
+template<typename P, bool Rayleigh, bool Mie>
+inline CpuSpanKernel select_span_kernel(CpuDensityProfile profile, CpuOpticalDepth depth) {
+	if (profile == CpuDensityProfile::Exponential) {
+		switch (depth) {
+		case CpuOpticalDepth::Marched: return render_span<P, Rayleigh, Mie, CpuDensityProfile::Exponential, CpuOpticalDepth::Marched>;
+		case CpuOpticalDepth::Analytic: return render_span<P, Rayleigh, Mie, CpuDensityProfile::Exponential, CpuOpticalDepth::Analytic>;
+		case CpuOpticalDepth::Lut: return render_span<P, Rayleigh, Mie, CpuDensityProfile::Exponential, CpuOpticalDepth::Lut>;
+		}
+	}
+
+	if (depth == CpuOpticalDepth::Marched) return render_span<P, Rayleigh, Mie, CpuDensityProfile::Tabulated, CpuOpticalDepth::Marched>;
+	return render_span<P, Rayleigh, Mie, CpuDensityProfile::Tabulated, CpuOpticalDepth::Lut>;
+}
+
+template<typename P>
+inline CpuSpanKernel select_span_kernel(const CpuKernelVariant& variant) {
+	if (variant.rayleigh) {
+		if (variant.mie) return select_span_kernel<P, true, true>(variant.profile, variant.depth);
+		return select_span_kernel<P, true, false>(variant.profile, variant.depth);
+	}
+	if (variant.mie) return select_span_kernel<P, false, true>(variant.profile, variant.depth);
+	return select_span_kernel<P, false, false>(variant.profile, variant.depth);
+}
+
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+// Paketi zraka za SIMD jezgru iscrtavanja na procesoru (cpuKernelTemplates.h).
+// Svaki paket drži po jednu vrijednost za više susjednih piksela (SoA raspored), a maska označava aktivne zrake.
+// AVX2 i AVX-512 paketi postoje samo u datotekama prevedenima za te skupove instrukcija (vidi src/CMakeLists.txt).
+//
+// Sve je u bezimenom imeniku: ista funkcija prevedena s različitim zastavicama ne smije se pri povezivanju
+// zamijeniti inačicom iz druge datoteke, jer bi se AVX-512 kod tada mogao izvršiti na procesoru koji ga ne podržava.
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// SSE2 je dio svakog x86-64 procesora, pa ga prenosiva jezgra koristi bez posebnih zastavica
+#if defined(__SSE2__) || defined(_M_X64)
+#define CPU_PACKETS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+
+// Prenosivi paket od 4 zrake - petlje fiksne duljine prevodilac pretvara u SSE ili NEON instrukcije
+struct PacketGeneric {
+	static const int width = 4;
+
+	// Maska po uzoru na SIMD usporedbe - svi bitovi 1 ili 0, kako bi se odabir mogao izvesti bitovnim operacijama
+	struct Mask {
+		int32_t v[width];
+	};
+
+	float v[width];
+
+	PacketGeneric() = default;
+	PacketGeneric(float s) { for (int i = 0; i < width; i++) v[i] = s; }
+
+	static PacketGeneric lane_index() {
+		PacketGeneric r;
+		for (int i = 0; i < width; i++) r.v[i] = (float)i;
+		return r;
+	}
+
+	void store(float* out) const { memcpy(out, v, sizeof(v)); }
+};
+
+#define PACKET_GENERIC_BINARY(op) \
+	inline PacketGeneric operator op(const PacketGeneric& a, const PacketGeneric& b) { \
+		PacketGeneric r; \
+		for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = a.v[i] op b.v[i]; \
+		return r; \
+	}
+PACKET_GENERIC_BINARY(+)
+PACKET_GENERIC_BINARY(-)
+PACKET_GENERIC_BINARY(*)
+PACKET_GENERIC_BINARY(/)
+#undef PACKET_GENERIC_BINARY
+
+inline PacketGeneric operator-(const PacketGeneric& a) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = -a.v[i];
+	return r;
+}
+
+inline PacketGeneric::Mask operator<(const PacketGeneric& a, const PacketGeneric& b) {
+	PacketGeneric::Mask r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = -(int32_t)(a.v[i] < b.v[i]);
+	return r;
+}
+inline PacketGeneric::Mask operator>(const PacketGeneric& a, const PacketGeneric& b) { return b < a; }
+
+inline PacketGeneric::Mask operator&(const PacketGeneric::Mask& a, const PacketGeneric::Mask& b) {
+	PacketGeneric::Mask r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = a.v[i] & b.v[i];
+	return r;
+}
+inline PacketGeneric::Mask operator|(const PacketGeneric::Mask& a, const PacketGeneric::Mask& b) {
+	PacketGeneric::Mask r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = a.v[i] | b.v[i];
+	return r;
+}
+inline PacketGeneric::Mask operator!(const PacketGeneric::Mask& a) {
+	PacketGeneric::Mask r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = ~a.v[i];
+	return r;
+}
+inline bool any(const PacketGeneric::Mask& m) {
+	int32_t r = 0;
+	for (int i = 0; i < PacketGeneric::width; i++) r |= m.v[i];
+	return r != 0;
+}
+
+inline PacketGeneric select(const PacketGeneric::Mask& m, const PacketGeneric& a, const PacketGeneric& b) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) {
+		int32_t x, y;
+		memcpy(&x, &a.v[i], sizeof(float));
+		memcpy(&y, &b.v[i], sizeof(float));
+		int32_t bits = (x & m.v[i]) | (y & ~m.v[i]);
+		memcpy(&r.v[i], &bits, sizeof(float));
+	}
+	return r;
+}
+// Čitanje tablice na indeksima paketa (cijeli brojevi zapisani kao float)
+inline PacketGeneric gather(const float* table, const PacketGeneric& index) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = table[(int32_t)index.v[i]];
+	return r;
+}
+inline PacketGeneric min(const PacketGeneric& a, const PacketGeneric& b) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+	return r;
+}
+inline PacketGeneric max(const PacketGeneric& a, const PacketGeneric& b) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+	return r;
+}
+inline PacketGeneric sqrt(const PacketGeneric& a) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = std::sqrt(a.v[i]);
+	return r;
+}
+inline PacketGeneric floor(const PacketGeneric& a) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) r.v[i] = std::floor(a.v[i]);
+	return r;
+}
+// 2^n za cijele n iz [-126, 127], izravno slaganjem eksponenta
+inline PacketGeneric pow2n(const PacketGeneric& n) {
+	PacketGeneric r;
+	for (int i = 0; i < PacketGeneric::width; i++) {
+		uint32_t bits = (uint32_t)((int32_t)n.v[i] + 127) << 23;
+		memcpy(&r.v[i], &bits, sizeof(float));
+	}
+	return r;
+}
+
+
+#if defined(CPU_PACKETS_SSE2)
+
+// 4 zrake u SSE registru - samo SSE2 instrukcije, jer ih ima svaki x86-64 procesor
+struct PacketSse2 {
+	static const int width = 4;
+
+	struct Mask {
+		__m128 v;
+	};
+
+	__m128 v;
+
+	PacketSse2() = default;
+	PacketSse2(__m128 x) : v(x) {}
+	PacketSse2(float s) : v(_mm_set1_ps(s)) {}
+
+	static PacketSse2 lane_index() { return _mm_setr_ps(0, 1, 2, 3); }
+
+	void store(float* out) const { _mm_storeu_ps(out, v); }
+};
+
+inline PacketSse2 operator+(const PacketSse2& a, const PacketSse2& b) { return _mm_add_ps(a.v, b.v); }
+inline PacketSse2 operator-(const PacketSse2& a, const PacketSse2& b) { return _mm_sub_ps(a.v, b.v); }
+inline PacketSse2 operator*(const PacketSse2& a, const PacketSse2& b) { return _mm_mul_ps(a.v, b.v); }
+inline PacketSse2 operator/(const PacketSse2& a, const PacketSse2& b) { return _mm_div_ps(a.v, b.v); }
+inline PacketSse2 operator-(const PacketSse2& a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+
+inline PacketSse2::Mask operator<(const PacketSse2& a, const PacketSse2& b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline PacketSse2::Mask operator>(const PacketSse2& a, const PacketSse2& b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+
+inline PacketSse2::Mask operator&(const PacketSse2::Mask& a, const PacketSse2::Mask& b) { return { _mm_and_ps(a.v, b.v) }; }
+inline PacketSse2::Mask operator|(const PacketSse2::Mask& a, const PacketSse2::Mask& b) { return { _mm_or_ps(a.v, b.v) }; }
+inline PacketSse2::Mask operator!(const PacketSse2::Mask& a) { return { _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))) }; }
+inline bool any(const PacketSse2::Mask& m) { return _mm_movemask_ps(m.v) != 0; }
+
+inline PacketSse2 select(const PacketSse2::Mask& m, const PacketSse2& a, const PacketSse2& b) {
+	return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v));
+}
+inline PacketSse2 min(const PacketSse2& a, const PacketSse2& b) { return _mm_min_ps(a.v, b.v); }
+inline PacketSse2 max(const PacketSse2& a, const PacketSse2& b) { return _mm_max_ps(a.v, b.v); }
+inline PacketSse2 sqrt(const PacketSse2& a) { return _mm_sqrt_ps(a.v); }
+// SSE2 nema zaokruživanja prema dolje - odsijecanje pa ispravak za negativne brojeve (dovoljno za raspon iz exp_packet)
+inline PacketSse2 floor(const PacketSse2& a) {
+	__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+	__m128 correction = _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.0f));
+	return _mm_sub_ps(truncated, correction);
+}
+inline PacketSse2 pow2n(const PacketSse2& n) {
+	__m128i exponent = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+	return _mm_castsi128_ps(_mm_slli_epi32(exponent, 23));
+}
+// SSE2 nema gather instrukcije
+inline PacketSse2 gather(const float* table, const PacketSse2& index) {
+	alignas(16) int32_t i[4];
+	_mm_store_si128((__m128i*)i, _mm_cvttps_epi32(index.v));
+	return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+}
+
+#endif
+
+
+#if defined(__AVX2__)
+
+// 8 zraka u jednom AVX registru
+struct PacketAvx2 {
+	static const int width = 8;
+
+	struct Mask {
+		__m256 v;
+	};
+
+	__m256 v;
+
+	PacketAvx2() = default;
+	PacketAvx2(__m256 x) : v(x) {}
+	PacketAvx2(float s) : v(_mm256_set1_ps(s)) {}
+
+	static PacketAvx2 lane_index() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+
+	void store(float* out) const { _mm256_storeu_ps(out, v); }
+};
+
+inline PacketAvx2 operator+(const PacketAvx2& a, const PacketAvx2& b) { return _mm256_add_ps(a.v, b.v); }
+inline PacketAvx2 operator-(const PacketAvx2& a, const PacketAvx2& b) { return _mm256_sub_ps(a.v, b.v); }
+inline PacketAvx2 operator*(const PacketAvx2& a, const PacketAvx2& b) { return _mm256_mul_ps(a.v, b.v); }
+inline PacketAvx2 operator/(const PacketAvx2& a, const PacketAvx2& b) { return _mm256_div_ps(a.v, b.v); }
+inline PacketAvx2 operator-(const PacketAvx2& a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+
+inline PacketAvx2::Mask operator<(const PacketAvx2& a, const PacketAvx2& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline PacketAvx2::Mask operator>(const PacketAvx2& a, const PacketAvx2& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+
+inline PacketAvx2::Mask operator&(const PacketAvx2::Mask& a, const PacketAvx2::Mask& b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline PacketAvx2::Mask operator|(const PacketAvx2::Mask& a, const PacketAvx2::Mask& b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline PacketAvx2::Mask operator!(const PacketAvx2::Mask& a) { return { _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))) }; }
+inline bool any(const PacketAvx2::Mask& m) { return _mm256_movemask_ps(m.v) != 0; }
+
+inline PacketAvx2 select(const PacketAvx2::Mask& m, const PacketAvx2& a, const PacketAvx2& b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+inline PacketAvx2 min(const PacketAvx2& a, const PacketAvx2& b) { return _mm256_min_ps(a.v, b.v); }
+inline PacketAvx2 max(const PacketAvx2& a, const PacketAvx2& b) { return _mm256_max_ps(a.v, b.v); }
+inline PacketAvx2 sqrt(const PacketAvx2& a) { return _mm256_sqrt_ps(a.v); }
+inline PacketAvx2 floor(const PacketAvx2& a) { return _mm256_floor_ps(a.v); }
+inline PacketAvx2 pow2n(const PacketAvx2& n) {
+	__m256i exponent = _mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127));
+	return _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23));
+}
+inline PacketAvx2 gather(const float* table, const PacketAvx2& index) { return _mm256_i32gather_ps(table, _mm256_cvttps_epi32(index.v), 4); }
+
+#endif
+
+
+#if defined(__AVX512F__)
+
+// 16 zraka u jednom AVX-512 registru, maske su zasebni registri
+struct PacketAvx512 {
+	static const int width = 16;
+
+	struct Mask {
+		__mmask16 v;
+	};
+
+	__m512 v;
+
+	PacketAvx512() = default;
+	PacketAvx512(__m512 x) : v(x) {}
+	PacketAvx512(float s) : v(_mm512_set1_ps(s)) {}
+
+	static PacketAvx512 lane_index() { return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+
+	void store(float* out) const { _mm512_storeu_ps(out, v); }
+};
+
+inline PacketAvx512 operator+(const PacketAvx512& a, const PacketAvx512& b) { return _mm512_add_ps(a.v, b.v); }
+inline PacketAvx512 operator-(const PacketAvx512& a, const PacketAvx512& b) { return _mm512_sub_ps(a.v, b.v); }
+inline PacketAvx512 operator*(const PacketAvx512& a, const PacketAvx512& b) { return _mm512_mul_ps(a.v, b.v); }
+inline PacketAvx512 operator/(const PacketAvx512& a, const PacketAvx512& b) { return _mm512_div_ps(a.v, b.v); }
+inline PacketAvx512 operator-(const PacketAvx512& a) { return _mm512_sub_ps(_mm512_setzero_ps(), a.v); }
+
+inline PacketAvx512::Mask operator<(const PacketAvx512& a, const PacketAvx512& b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+inline PacketAvx512::Mask operator>(const PacketAvx512& a, const PacketAvx512& b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) }; }
+
+inline PacketAvx512::Mask operator&(const PacketAvx512::Mask& a, const PacketAvx512::Mask& b) { return { (__mmask16)(a.v & b.v) }; }
+inline PacketAvx512::Mask operator|(const PacketAvx512::Mask& a, const PacketAvx512::Mask& b) { return { (__mmask16)(a.v | b.v) }; }
+inline PacketAvx512::Mask operator!(const PacketAvx512::Mask& a) { return { (__mmask16)~a.v }; }
+inline bool any(const PacketAvx512::Mask& m) { return m.v != 0; }
+
+inline PacketAvx512 select(const PacketAvx512::Mask& m, const PacketAvx512& a, const PacketAvx512& b) { return _mm512_mask_blend_ps(m.v, b.v, a.v); }
+inline PacketAvx512 min(const PacketAvx512& a, const PacketAvx512& b) { return _mm512_min_ps(a.v, b.v); }
+inline PacketAvx512 max(const PacketAvx512& a, const PacketAvx512& b) { return _mm512_max_ps(a.v, b.v); }
+inline PacketAvx512 sqrt(const PacketAvx512& a) { return _mm512_sqrt_ps(a.v); }
+inline PacketAvx512 floor(const PacketAvx512& a) { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline PacketAvx512 pow2n(const PacketAvx512& n) {
+	__m512i exponent = _mm512_add_epi32(_mm512_cvtps_epi32(n.v), _mm512_set1_epi32(127));
+	return _mm512_castsi512_ps(_mm512_slli_epi32(exponent, 23));
+}
+inline PacketAvx512 gather(const float* table, const PacketAvx512& index) { return _mm512_i32gather_ps(_mm512_cvttps_epi32(index.v), table, 4); }
+
+#endif
+
+}
@@ -0,0 +1,706 @@
+#include "cpuRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define CPU_RENDERER_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+#ifdef CPU_RENDERER_X86
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]){
+#ifdef _MSC_VER
+	__cpuidex((int*)regs, (int)leaf, (int)subleaf);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Registri koje operacijski sustav sprema pri promjeni dretve - bez toga se AVX registri ne smiju koristiti
+static uint64_t xgetbv0(){
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+bool CpuRenderer::kernel_supported(Kernel kernel){
+	if (kernel == Kernel::Scalar || kernel == Kernel::Generic) return true;
+
+#ifdef CPU_RENDERER_X86
+	unsigned int regs[4];
+	cpuid(0, 0, regs);
+	if (regs[0] < 7) return false;
+
+	cpuid(1, 0, regs);
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+	bool fma = (regs[2] & (1u << 12)) != 0;
+	if (!osxsave || !fma) return false;
+
+	uint64_t xcr0 = xgetbv0();
+	cpuid(7, 0, regs);
+
+	// YMM stanje (bitovi 1-2), te za AVX-512 još maske i gornji dijelovi ZMM registara (bitovi 5-7)
+	bool avx2 = (regs[1] & (1u << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+	bool avx512 = avx2 && (regs[1] & (1u << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+
+	if (kernel == Kernel::Avx2) return avx2;
+	if (kernel == Kernel::Avx512) return avx512;
+#endif
+
+	return false;
+}
+
+CpuRenderer::Kernel CpuRenderer::best_kernel(){
+	if (kernel_supported(Kernel::Avx512)) return Kernel::Avx512;
+	if (kernel_supported(Kernel::Avx2)) return Kernel::Avx2;
+	return Kernel::Generic;
+}
+
+const char* CpuRenderer::kernel_name(Kernel kernel){
+	switch (kernel) {
+	case Kernel::Scalar: return "skalarna";
+	case Kernel::Generic: return "prenosiva";
+	case Kernel::Avx2: return "avx2";
+	case Kernel::Avx512: return "avx512";
+	}
+	return "";
+}
+
+const char* CpuRenderer::density_profile_name(CpuDensityProfile profile){
+	switch (profile) {
+	case CpuDensityProfile::Exponential: return "eksponencijalni";
+	case CpuDensityProfile::Tabulated: return "tablicni";
+	}
+	return "";
+}
+
+const char* CpuRenderer::optical_depth_name(CpuOpticalDepth depth){
+	switch (depth) {
+	case CpuOpticalDepth::Marched: return "koracanje";
+	case CpuOpticalDepth::Analytic: return "analiticka";
+	case CpuOpticalDepth::Lut: return "tablica";
+	}
+	return "";
+}
+
+bool CpuRenderer::set_kernel(Kernel kernel){
+	if (!kernel_supported(kernel)) return false;
+
+	_kernel = kernel;
+	return true;
+}
+
+
+void CpuRenderer::init(unsigned int thread_count){
+	if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	set_kernel(best_kernel());
+
+	for (unsigned int i = 0; i < thread_count; i++) _queues.push_back(std::make_unique<TileQueue>());
+
+	_running = true;
+	for (unsigned int i = 1; i < thread_count; i++) {
+		_threads.emplace_back(&CpuRenderer::worker_loop, this, i);
+	}
+}
+
+void CpuRenderer::cleanup(){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_running = false;
+	}
+	_work_available.notify_all();
+
+	for (std::thread& thread : _threads) thread.join();
+	_threads.clear();
+	_queues.clear();
+}
+
+
+void CpuRenderer::render(const shader_input_buffer_1& camera, const shader_input_buffer_2& atmosphere, float* pixels){
+
+	_camera = &camera;
+	_atmosphere = &atmosphere;
+	_pixels = pixels;
+
+	// Instancija SIMD jezgre bira se jednom po slici, prema načinu raspršenja i odabranom profilu i optičkoj dubini
+	_span_kernel = nullptr;
+	if (_kernel != Kernel::Scalar) {
+		prepare_params(camera, atmosphere);
+
+		CpuKernelVariant variant = { (camera.mode & 1) != 0, (camera.mode & 2) != 0, _density_profile, _optical_depth };
+		switch (_kernel) {
+		case Kernel::Avx2: _span_kernel = cpu_span_kernel_avx2(variant); break;
+		case Kernel::Avx512: _span_kernel = cpu_span_kernel_avx512(variant); break;
+		default: _span_kernel = cpu_span_kernel_generic(variant); break;
+		}
+	}
+
+	_tiles_x = (camera.renderWidth + _tile_size - 1) / _tile_size;
+	uint32_t tiles_y = (camera.renderHeight + _tile_size - 1) / _tile_size;
+	uint32_t tile_count = _tiles_x * tiles_y;
+
+	// Svaka dretva dobiva neprekinut niz pločica - susjedne pločice imaju sličnu cijenu, pa se krađa s kraja
+	// tuđeg reda događa tek kada je dio slike (npr. nebo naspram svemira) osjetno skuplji od ostatka
+	unsigned int worker_count = (unsigned int)_queues.size();
+	for (unsigned int i = 0; i < worker_count; i++) {
+		uint32_t begin = (uint32_t)((uint64_t)tile_count * i / worker_count);
+		uint32_t end = (uint32_t)((uint64_t)tile_count * (i + 1) / worker_count);
+
+		std::lock_guard<std::mutex> lock(_queues[i]->mutex);
+		_queues[i]->tiles.clear();
+		for (uint32_t tile = begin; tile < end; tile++) _queues[i]->tiles.push_back(tile);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_generation++;
+		_busy_workers = (unsigned int)_threads.size();
+	}
+	_work_available.notify_all();
+
+	run_tiles(0);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_work_done.wait(lock, [&]() { return _busy_workers == 0; });
+}
+
+void CpuRenderer::worker_loop(unsigned int worker_index){
+
+	uint64_t seen_generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_work_available.wait(lock, [&]() { return !_running || _generation != seen_generation; });
+			if (!_running) return;
+			seen_generation = _generation;
+		}
+
+		run_tiles(worker_index);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_busy_workers--;
+		}
+		_work_done.notify_one();
+	}
+}
+
+void CpuRenderer::run_tiles(unsigned int worker_index){
+	uint32_t tile;
+	while (take_tile(worker_index, tile)) render_tile(tile);
+}
+
+bool CpuRenderer::take_tile(unsigned int worker_index, uint32_t& tile){
+
+	// Vlastiti red se uzima s početka
+	{
+		TileQueue& own = *_queues[worker_index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tiles.empty()) {
+			tile = own.tiles.front();
+			own.tiles.pop_front();
+			return true;
+		}
+	}
+
+	// Krađa s kraja tuđeg reda, što dalje od pločica koje vlasnik upravo obrađuje
+	unsigned int worker_count = (unsigned int)_queues.size();
+	for (unsigned int offset = 1; offset < worker_count; offset++) {
+		TileQueue& victim = *_queues[(worker_index + offset) % worker_count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tiles.empty()) {
+			tile = victim.tiles.back();
+			victim.tiles.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CpuRenderer::render_tile(uint32_t tile){
+	int x0 = (int)((tile % _tiles_x) * _tile_size);
+	int y0 = (int)((tile / _tiles_x) * _tile_size);
+	int x1 = std::min(x0 + (int)_tile_size, _camera->renderWidth);
+	int y1 = std::min(y0 + (int)_tile_size, _camera->renderHeight);
+
+	for (int y = y0; y < y1; y++) {
+		float* row = _pixels + (size_t)y * _camera->renderWidth * 4;
+
+		if (_span_kernel) {
+			_span_kernel(_params, y, x0, x1, row);
+			continue;
+		}
+
+		for (int x = x0; x < x1; x++) {
+			glm::vec4 color = render_pixel(*_camera, *_atmosphere, x, y);
+			row[x * 4 + 0] = color.x;
+			row[x * 4 + 1] = color.y;
+			row[x * 4 + 2] = color.z;
+			row[x * 4 + 3] = color.w;
+		}
+	}
+}
+
+
+void CpuRenderer::prepare_params(const shader_input_buffer_1& camera, const shader_input_buffer_2& atmosphere){
+
+	const Sun& sun = atmosphere.sun;
+	const Planet& planet = atmosphere.planet;
+	CpuKernelParams& p = _params;
+
+	memcpy(p.look_dir, &camera.lookDir[0][0], sizeof(p.look_dir));
+	for (int i = 0; i < 3; i++) {
+		p.init_pos[i] = camera.initPos[i];
+		p.init_dir[i] = camera.initDir[i];
+	}
+	p.x_pos_multiplier = camera.xPosMultiplier;
+	p.y_pos_multiplier = camera.yPosMultiplier;
+	p.x_dir_multiplier = camera.xDirMultiplier;
+	p.y_dir_multiplier = camera.yDirMultiplier;
+	p.half_width = camera.renderWidth / 2.0f;
+	p.half_height = camera.renderHeight / 2.0f;
+
+	p.sample_amount_in = camera.sampleAmount_in;
+	p.sample_amount_out = camera.sampleAmount_out;
+	p.mode = camera.mode;
+
+	p.planet_radius = planet.radius;
+	p.atmosphere_radius = planet.radius + planet.atmosphere.upper_limit;
+	p.inv_average_distance = 1.0f / planet.atmosphere.average_density_height;
+	p.inv_average_distance_aerosol = 1.0f / planet.atmosphere.average_density_height_aerosol;
+	p.aerosol_density_mul = planet.atmosphere.aerosol_density_mul;
+
+	float sun_angle = glm::radians(sun.angle);
+	glm::vec3 sun_pos = glm::vec3(std::cos(sun_angle), std::sin(sun_angle), 0) * sun.distance;
+	glm::vec3 sun_dir = glm::normalize(sun_pos);
+	glm::vec3 starting_ray_light = glm::vec3(sun.light_color * sun.light_intensity);
+	for (int i = 0; i < 3; i++) {
+		p.sun_pos[i] = sun_pos[i];
+		p.sun_dir[i] = sun_dir[i];
+		p.starting_ray_light[i] = starting_ray_light[i];
+	}
+	p.sun_radius = sun.radius;
+	p.starting_ray_light_length = glm::length(starting_ray_light);
+
+	float pi = 3.141592654f;
+	float K = float(atmosphere.K);
+	float wavelengths[3] = { sun.r_wavelen * 0.000000001f, sun.g_wavelen * 0.000000001f, sun.b_wavelen * 0.000000001f };
+	for (int i = 0; i < 3; i++) {
+		float w = wavelengths[i];
+		p.rayleigh_scatter[i] = K / (w * w * w * w);
+		p.rayleigh_depth[i] = 4 * pi * p.rayleigh_scatter[i];
+	}
+
+	float const_wavelen = 900 * 0.000000001f;
+	p.mie_scatter = K / (const_wavelen * const_wavelen * const_wavelen * const_wavelen);
+	p.mie_depth = 4 * pi * p.mie_scatter;
+
+	float g = planet.atmosphere.mie_asymmetry_const;
+	p.mie_phase_scale = 3.0f * (1.0f - g * g) / (2.0f * (2.0f + g * g));
+	p.mie_phase_base = 1 + g * g;
+	p.mie_phase_cos = 2 * g;
+
+	p.average_distance[0] = planet.atmosphere.average_density_height;
+	p.average_distance[1] = planet.atmosphere.average_density_height_aerosol;
+
+	update_tables(planet);
+
+	p.density_table[0] = _density_tables[0].data();
+	p.density_table[1] = _density_tables[1].data();
+	p.density_table_size = (int)_density_table_size;
+	p.density_table_scale = (_density_table_size - 1) / planet.atmosphere.upper_limit;
+
+	p.depth_lut = _depth_lut.data();
+	p.depth_lut_heights = (int)_depth_lut_heights;
+	p.depth_lut_angles = (int)_depth_lut_angles;
+}
+
+
+// Omjer gustoće za izradu tablica - isti profil koji koristi jezgra
+double CpuRenderer::table_density_ratio(int species, double height) const {
+	if (_density_profile == CpuDensityProfile::Exponential) {
+		return std::exp(-height / _table_key.average_distance[species]);
+	}
+
+	const std::vector<float>& table = _density_tables[species];
+	if (height < 0) return table[0] * std::exp(-height / _table_key.average_distance[species]);
+
+	double u = std::min(std::max(height * (_density_table_size - 1) / _table_key.upper_limit, 0.0), double(_density_table_size - 1));
+	size_t i = std::min((size_t)u, (size_t)_density_table_size - 2);
+	double f = u - i;
+	return table[i] + (table[i + 1] - table[i]) * f;
+}
+
+void CpuRenderer::update_tables(const Planet& planet){
+
+	// Tablica optičke dubine treba samo njoj i analitičkoj dubini uz tablični profil (koja ju zamjenjuje)
+	bool needs_lut = _optical_depth == CpuOpticalDepth::Lut
+		|| (_optical_depth == CpuOpticalDepth::Analytic && _density_profile == CpuDensityProfile::Tabulated);
+
+	TableKey key = { _density_profile, planet.radius, planet.atmosphere.upper_limit,
+		{ planet.atmosphere.average_density_height, planet.atmosphere.average_density_height_aerosol } };
+	bool same_key = key.profile == _table_key.profile && key.planet_radius == _table_key.planet_radius && key.upper_limit == _table_key.upper_limit
+		&& key.average_distance[0] == _table_key.average_distance[0] && key.average_distance[1] == _table_key.average_distance[1];
+
+	if (!same_key || _density_tables[0].empty()) _depth_lut.clear();
+	else if (!needs_lut || !_depth_lut.empty()) return;
+	_table_key = key;
+
+	// Atmosfera je zadana samo visinama prosječne gustoće, pa se tablični profil puni iz eksponencijalnog.
+	// Izmjereni profili (npr. sloj ozona) mogu se upisati izravno u ove tablice
+	for (int species = 0; species < 2; species++) {
+		_density_tables[species].resize(_density_table_size);
+		for (uint32_t i = 0; i < _density_table_size; i++) {
+			double height = double(planet.atmosphere.upper_limit) * i / (_density_table_size - 1);
+			_density_tables[species][i] = (float)std::exp(-height / key.average_distance[species]);
+		}
+	}
+
+	if (!needs_lut) return;
+
+	// Optička dubina do ruba atmosfere, izračunata koračanjem s puno uzoraka (trapezno pravilo)
+	const uint32_t steps = 256;
+	const uint32_t half = _depth_lut_angles / 2;
+	double planet_radius = planet.radius;
+	double atmosphere_radius = double(planet.radius) + planet.atmosphere.upper_limit;
+
+	_depth_lut.resize((size_t)2 * _depth_lut_heights * _depth_lut_angles);
+
+	for (uint32_t h = 0; h < _depth_lut_heights; h++) {
+		double u_height = double(h) / (_depth_lut_heights - 1);
+		double r = planet_radius + u_height * u_height * planet.atmosphere.upper_limit;
+
+		double rho = planet_radius / r;
+		double mu_horizon = -std::sqrt(std::max(0.0, 1.0 - rho * rho));
+
+		for (uint32_t a = 0; a < _depth_lut_angles; a++) {
+			double mu = a < half
+				? -1.0 + (mu_horizon + 1.0) * a / (half - 1)
+				: mu_horizon + (1.0 - mu_horizon) * (a - half) / (half - 1);
+			mu = std::min(std::max(mu, -1.0), 1.0);
+
+			// Zraka iz (0, r) u smjeru (sqrt(1 - mu^2), mu) do izlaska iz atmosfere
+			double b = r * mu;
+			double t_exit = -b + std::sqrt(std::max(0.0, b * b - (r * r - atmosphere_radius * atmosphere_radius)));
+			double dx = std::sqrt(std::max(0.0, 1.0 - mu * mu));
+			double step = t_exit / steps;
+
+			for (int species = 0; species < 2; species++) {
+				double depth = 0;
+				for (uint32_t i = 0; i <= steps; i++) {
+					double t = step * i;
+					double x = dx * t;
+					double y = r + mu * t;
+					double weight = (i == 0 || i == steps) ? 0.5 : 1.0;
+					depth += weight * table_density_ratio(species, std::sqrt(x * x + y * y) - planet_radius);
+				}
+				depth *= step;
+
+				// Tablica čuva logaritam, jer se dubina od tla do ruba i kroz planet razlikuje za desetke redova veličine
+				depth = std::min(std::max(depth, 1e-30), 1e30);
+				_depth_lut[((size_t)species * _depth_lut_heights + h) * _depth_lut_angles + a] = (float)std::log(depth);
+			}
+		}
+	}
+}
+
+
+// Prijenos sjenčara - imena i redoslijed operacija namjerno prate main_shader.comp, da bi se razlike lakše pratile.
+// Sve se računa u floatu kao na GPU-u, osim kosinusa kuta prema suncu, koji je i u sjenčaru double
+
+struct RaySphereResult {
+	bool intersect = false;
+	float t_min = 0;
+	float t_max = 0;
+};
+
+static RaySphereResult ray_sphere_intersect(glm::vec3 ray_pos, glm::vec3 ray_dir, glm::vec3 sphere_pos, float sphere_r){
+	RaySphereResult res;
+
+	glm::vec3 ray_dir_n = glm::normalize(ray_dir);
+	glm::vec3 pos_diff = ray_pos - sphere_pos;
+
+	float a = 1;
+	float b = 2 * glm::dot(ray_dir_n, pos_diff);
+	float c = glm::dot(pos_diff, pos_diff) - sphere_r * sphere_r;
+
+	float d = b * b - 4 * a * c;
+
+	if (d > 0) {
+		res.intersect = true;
+		float t1 = (-b + std::sqrt(d)) / (2 * a);
+		float t2 = (-b - std::sqrt(d)) / (2 * a);
+
+		res.t_min = std::min(t1, t2);
+		res.t_max = std::max(t1, t2);
+	}
+
+	return res;
+}
+
+static float out_scatter_partial(glm::vec3 start, glm::vec3 end, float average_distance, float planet_radius, int sample_amount_out){
+	float result = 0;
+
+	for (int j = 0; j < sample_amount_out; j++) {
+		float f = float(j) / (sample_amount_out - 1);
+		glm::vec3 pos = start * (1 - f) + end * f;
+
+		float distance_from_center = glm::length(pos);
+		float distance_from_surface = distance_from_center - planet_radius;
+
+		result += std::exp(-distance_from_surface / average_distance) * glm::length(end - start) / sample_amount_out;
+	}
+
+	return result;
+}
+
+glm::vec4 CpuRenderer::render_pixel(const shader_input_buffer_1& camera, const shader_input_buffer_2& atmosphere, int x, int y){
+
+	const Sun& sun = atmosphere.sun;
+	const Planet& planet = atmosphere.planet;
+	const int sample_amount_in = camera.sampleAmount_in;
+	const int sample_amount_out = camera.sampleAmount_out;
+	const int mode = camera.mode;
+
+	float render_width = (float)camera.renderWidth;
+	float render_height = (float)camera.renderHeight;
+
+	// Y koordinata se obrće - u teksturi je dolje +y, a u računanju -y
+	glm::vec3 initPos = glm::mat3(camera.lookDir) * glm::vec3((float(x) - render_width / 2.0f) * camera.xPosMultiplier, -(float(y) - render_height / 2.0f) * camera.yPosMultiplier, 0.0f) + glm::vec3(camera.initPos);
+	glm::vec3 velocity = glm::vec3((float(x) - render_width / 2.0f) * camera.xDirMultiplier, -(float(y) - render_height / 2.0f) * camera.yDirMultiplier, 0.0f) + glm::vec3(camera.initDir);
+
+	glm::vec4 velocity_2 = camera.lookDir * glm::vec4(velocity, 1.0f);
+	velocity = glm::vec3(velocity_2 / velocity_2.w);
+
+	glm::vec3 velocity_n = glm::normalize(velocity);
+
+	glm::vec4 floor_color = glm::vec4(0.3f, 0.3f, 0.3f, 0);
+	glm::vec4 center_col = glm::vec4(0.0f, 0.0f, 0.0f, 0);
+	if (glm::length(initPos) < planet.radius) {
+		float scale = glm::dot(velocity_n, glm::normalize(initPos)) / 2.0f + 0.5f;
+		return floor_color * scale + center_col * (1 - scale);
+	}
+
+	glm::vec3 floor_reflect = glm::vec3(0, 0, 0);
+
+	bool intersecting_planet = false;
+	float planet_t_min = 0;
+	glm::vec3 planet_pos = glm::vec3(0, 0, 0);
+
+	RaySphereResult planet_intersect = ray_sphere_intersect(initPos, velocity_n, planet_pos, planet.radius);
+
+	if (planet_intersect.intersect && planet_intersect.t_min > 0) {
+		intersecting_planet = true;
+		planet_t_min = planet_intersect.t_min;
+
+		floor_reflect = glm::vec3(floor_color) * 0.0001f;
+	}
+
+	glm::vec3 planet_t_pos = initPos + glm::normalize(velocity) * planet_t_min;
+
+	bool looking_at_sun = false;
+	float sun_angle = glm::radians(sun.angle);
+	glm::vec3 sun_pos = glm::vec3(std::cos(sun_angle), std::sin(sun_angle), 0) * sun.distance;
+	glm::vec3 starting_ray_light = glm::vec3(sun.light_color * sun.light_intensity);
+
+	RaySphereResult sun_intersect = ray_sphere_intersect(initPos, velocity_n, sun_pos, sun.radius);
+
+	if (sun_intersect.intersect && sun_intersect.t_min > 0 && !intersecting_planet) {
+		looking_at_sun = true;
+	}
+
+	float atmosphere_radius = planet.radius + planet.atmosphere.upper_limit;
+
+	RaySphereResult atmosphere_intersect = ray_sphere_intersect(initPos, velocity_n, planet_pos, atmosphere_radius);
+
+	if (!(atmosphere_intersect.intersect && (atmosphere_intersect.t_min > 0 || atmosphere_intersect.t_max > 0))) {
+		// U svemiru - osim sunca nema ničeg za iscrtati
+		if (looking_at_sun) return glm::vec4(starting_ray_light, 1);
+		return glm::vec4(0, 0, 0, 0);
+	}
+
+	float t_min = atmosphere_intersect.t_min;
+	float t_max = atmosphere_intersect.t_max;
+
+	if (t_min < 0) t_min = 0;
+
+	// Zraka se odbija od površine planeta - uzorci se ograničavaju na atmosferu prije površine
+	bool planet_reflection = false;
+	if (intersecting_planet && t_max > planet_t_min) planet_reflection = true;
+	if (planet_reflection) t_max = planet_t_min;
+
+	glm::vec3 total_light = glm::vec3(0, 0, 0);
+
+	float red_wavelenght = sun.r_wavelen * 0.000000001f;
+	float green_wavelenght = sun.g_wavelen * 0.000000001f;
+	float blue_wavelenght = sun.b_wavelen * 0.000000001f;
+
+	float pi = 3.141592654f;
+	float K = float(atmosphere.K);
+
+	const float average_distance = planet.atmosphere.average_density_height;
+	const float average_distance_aerosol = planet.atmosphere.average_density_height_aerosol;
+	const float aerosol_density_mul = planet.atmosphere.aerosol_density_mul;
+
+	for (int i = 1; i < sample_amount_in; i++) {
+
+		glm::vec3 total_ray_light = glm::vec3(0, 0, 0);
+
+		float f = float(i) / (sample_amount_in - 1);
+		float t_smpl = t_min * (1 - f) + t_max * f;
+
+		glm::vec3 t_pos = initPos + glm::normalize(velocity) * t_smpl;
+
+		glm::vec3 ray_sun_vector = sun_pos - t_pos;
+
+		RaySphereResult sample_planet_intersect = ray_sphere_intersect(t_pos, glm::normalize(ray_sun_vector), planet_pos, planet.radius);
+
+		bool hit_surface = false;
+		if (sample_planet_intersect.intersect && sample_planet_intersect.t_max + 0.1f > 0) {
+			hit_surface = true;
+		}
+
+		glm::vec3 in_scatter_light = glm::vec3(0, 0, 0);
+
+		// Konstantna valna duljina za aproksimaciju Mie raspršivanja
+		float const_wavelen = 900 * 0.000000001f;
+		float mie_scatter_constant = const_wavelen * const_wavelen * const_wavelen * const_wavelen;
+
+		glm::vec3 arriving_light = glm::vec3(0, 0, 0);
+
+		// Ulazno raspršivanje
+		if (!planet_reflection || (i < sample_amount_in - 1 && !hit_surface)) {
+
+			RaySphereResult sample_atmosphere_intersect = ray_sphere_intersect(t_pos, glm::normalize(ray_sun_vector), planet_pos, atmosphere_radius);
+
+			if (sample_atmosphere_intersect.intersect) {
+				float t_max_2 = sample_atmosphere_intersect.t_max;
+
+				glm::vec3 ray_light = starting_ray_light;
+
+				float average_density_ratio = out_scatter_partial(t_pos, t_pos + glm::normalize(ray_sun_vector) * t_max_2, average_distance, planet.radius, sample_amount_out);
+				float average_density_ratio_mie = out_scatter_partial(t_pos, t_pos + glm::normalize(ray_sun_vector) * t_max_2, average_distance_aerosol, planet.radius, sample_amount_out);
+
+				float rayleigh_part_1_red = 4 * pi * average_density_ratio * (K / (red_wavelenght * red_wavelenght * red_wavelenght * red_wavelenght));
+				float rayleigh_part_1_green = 4 * pi * average_density_ratio * (K / (green_wavelenght * green_wavelenght * green_wavelenght * green_wavelenght));
+				float rayleigh_part_1_blue = 4 * pi * average_density_ratio * (K / (blue_wavelenght * blue_wavelenght * blue_wavelenght * blue_wavelenght));
+				float mie_part_1 = 4 * pi * average_density_ratio_mie * (K / (mie_scatter_constant));
+
+				arriving_light.r = ray_light.r * std::exp(-rayleigh_part_1_red);
+				arriving_light.g = ray_light.g * std::exp(-rayleigh_part_1_green);
+				arriving_light.b = ray_light.b * std::exp(-rayleigh_part_1_blue);
+
+				double cos_sun_angle = glm::dot(glm::normalize(ray_sun_vector), glm::normalize(velocity));
+
+				float angle_const_rayleigh = float(3.0f / (4.0f) * (1 + cos_sun_angle * cos_sun_angle));
+
+				float asymmetry_const = planet.atmosphere.mie_asymmetry_const;
+				float angle_const_mie = 3.0f * (1.0f - asymmetry_const * asymmetry_const) / (2.0f * (2.0f + asymmetry_const * asymmetry_const)) * float(1 + cos_sun_angle * cos_sun_angle)
+					/ std::pow((1 + asymmetry_const * asymmetry_const - float(2 * asymmetry_const * cos_sun_angle)), 1.5f);
+
+				float density_ratio = std::exp(-(glm::length(t_pos) - planet.radius) / average_distance);
+
+				float rayleigh_part_2_red = 0;
+				float rayleigh_part_2_green = 0;
+				float rayleigh_part_2_blue = 0;
+
+				if ((mode & 1) != 0) {
+					rayleigh_part_2_red = ray_light.r * angle_const_rayleigh * density_ratio * (K / (red_wavelenght * red_wavelenght * red_wavelenght * red_wavelenght)) * std::exp(-rayleigh_part_1_red);
+					rayleigh_part_2_green = ray_light.g * angle_const_rayleigh * density_ratio * (K / (green_wavelenght * green_wavelenght * green_wavelenght * green_wavelenght)) * std::exp(-rayleigh_part_1_green);
+					rayleigh_part_2_blue = ray_light.b * angle_const_rayleigh * density_ratio * (K / (blue_wavelenght * blue_wavelenght * blue_wavelenght * blue_wavelenght)) * std::exp(-rayleigh_part_1_blue);
+				}
+
+				float mie_part_2 = 0;
+				if ((mode & 2) != 0) {
+					mie_part_2 = glm::length(ray_light) * angle_const_mie * density_ratio * (K / (mie_scatter_constant)) * std::exp(-mie_part_1) * aerosol_density_mul;
+				}
+
+				in_scatter_light += glm::vec3(rayleigh_part_2_red, rayleigh_part_2_green, rayleigh_part_2_blue) + glm::vec3(mie_part_2, mie_part_2, mie_part_2);
+			}
+		}
+		// Poseban slučaj - odbijanje od površine planeta, samo za zadnju točku uzorka
+		else if (i == sample_amount_in - 1) {
+			RaySphereResult sample_atmosphere_intersect = ray_sphere_intersect(t_pos, glm::normalize(ray_sun_vector), planet_pos, atmosphere_radius);
+
+			if (sample_atmosphere_intersect.intersect) {
+				float t_max_2 = sample_atmosphere_intersect.t_max;
+
+				glm::vec3 ray_light = starting_ray_light;
+
+				float average_density_ratio = out_scatter_partial(t_pos, t_pos + glm::normalize(ray_sun_vector) * t_max_2, average_distance, planet.radius, sample_amount_out);
+				float average_density_ratio_mie = out_scatter_partial(t_pos, t_pos + glm::normalize(ray_sun_vector) * t_max_2, average_distance_aerosol, planet.radius, sample_amount_out);
+
+				float rayleigh_part_1_red = 0;
+				float rayleigh_part_1_green = 0;
+				float rayleigh_part_1_blue = 0;
+
+				if ((mode & 1) != 0) {
+					rayleigh_part_1_red = 4 * pi * average_density_ratio * (K / (red_wavelenght * red_wavelenght * red_wavelenght * red_wavelenght));
+					rayleigh_part_1_green = 4 * pi * average_density_ratio * (K / (green_wavelenght * green_wavelenght * green_wavelenght * green_wavelenght));
+					rayleigh_part_1_blue = 4 * pi * average_density_ratio * (K / (blue_wavelenght * blue_wavelenght * blue_wavelenght * blue_wavelenght));
+				}
+				float mie_part_1 = 0;
+				if ((mode & 2) != 0) {
+					mie_part_1 = 4 * pi * average_density_ratio_mie * (K / (mie_scatter_constant)) * aerosol_density_mul;
+				}
+
+				arriving_light.r = ray_light.r * std::exp(-rayleigh_part_1_red - mie_part_1);
+				arriving_light.g = ray_light.g * std::exp(-rayleigh_part_1_green - mie_part_1);
+				arriving_light.b = ray_light.b * std::exp(-rayleigh_part_1_blue - mie_part_1);
+			}
+		}
+
+		if (looking_at_sun) in_scatter_light = arriving_light;
+
+		if (planet_reflection && i == sample_amount_in - 1) {
+			in_scatter_light = floor_reflect * arriving_light * std::max(0.0f, glm::dot(glm::normalize(sun_pos), glm::normalize(planet_t_pos)));
+		}
+
+		// Izlazno raspršivanje - od točke uzorka do očišta
+		{
+			glm::vec3 start = initPos + glm::normalize(velocity) * t_min;
+			glm::vec3 end = initPos + glm::normalize(velocity) * t_smpl;
+
+			float average_density_ratio_2 = out_scatter_partial(start, end, average_distance, planet.radius, sample_amount_out);
+			float average_density_ratio_2_mie = out_scatter_partial(start, end, average_distance_aerosol, planet.radius, sample_amount_out);
+
+			float rayleigh_part_1_red = 0;
+			float rayleigh_part_1_green = 0;
+			float rayleigh_part_1_blue = 0;
+
+			if ((mode & 1) != 0) {
+				rayleigh_part_1_red = 4 * pi * average_density_ratio_2 * (K / (red_wavelenght * red_wavelenght * red_wavelenght * red_wavelenght));
+				rayleigh_part_1_green = 4 * pi * average_density_ratio_2 * (K / (green_wavelenght * green_wavelenght * green_wavelenght * green_wavelenght));
+				rayleigh_part_1_blue = 4 * pi * average_density_ratio_2 * (K / (blue_wavelenght * blue_wavelenght * blue_wavelenght * blue_wavelenght));
+			}
+
+			float mie_part_1 = 0;
+			if ((mode & 2) != 0) {
+				mie_part_1 = 4 * pi * average_density_ratio_2_mie * (K / (mie_scatter_constant)) * aerosol_density_mul;
+			}
+
+			total_ray_light.r = in_scatter_light.r * std::exp(-rayleigh_part_1_red - mie_part_1);
+			total_ray_light.g = in_scatter_light.g * std::exp(-rayleigh_part_1_green - mie_part_1);
+			total_ray_light.b = in_scatter_light.b * std::exp(-rayleigh_part_1_blue - mie_part_1);
+
+			total_light += total_ray_light * (t_max - t_min) / float(sample_amount_in);
+		}
+	}
+
+	// Komponente izlaza su obrnute, kao u sjenčaru
+	return glm::vec4(total_light.b, total_light.g, total_light.r, 0);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "shaderInputs.h"
+#include "cpuKernel.h"
+
+
+// Iscrtavanje na procesoru - izravan prijenos glavnog sjenčara (main_shader.comp) u C++.
+// Služi kao referentna slika za provjeru GPU izračuna i za iscrtavanje na računalima bez grafičkog procesora.
+// Slika se dijeli na pločice; svaka dretva uzima pločice iz svog reda, a kada ga isprazni, krade ih s kraja tuđih redova.
+// Redovi pločica iscrtavaju se SIMD jezgrom (cpuKernel.h) za najširi skup instrukcija koji procesor podržava.
+class CpuRenderer {
+
+public:
+	enum class Kernel {
+		Scalar,		// render_pixel - piksel po piksel, izravno prema sjenčaru
+		Generic,	// Paketi od 4 zrake - SSE2 na x86-64, inače obične petlje koje prevodilac po mogućnosti vektorizira
+		Avx2,		// Paketi od 8 zraka
+		Avx512		// Paketi od 16 zraka
+	};
+
+	static bool kernel_supported(Kernel kernel);
+	static Kernel best_kernel();
+	static const char* kernel_name(Kernel kernel);
+	static const char* density_profile_name(CpuDensityProfile profile);
+	static const char* optical_depth_name(CpuOpticalDepth depth);
+
+	// thread_count = 0 - po jedna dretva za svaku jezgru
+	void init(unsigned int thread_count = 0);
+	void cleanup();
+
+	// Vraća false (i zadržava trenutnu jezgru) ako procesor ne podržava traženu
+	bool set_kernel(Kernel kernel);
+	Kernel kernel() const { return _kernel; }
+
+	// Profil gustoće i način računanja optičke dubine SIMD jezgri (skalarna jezgra uvijek radi kao sjenčar).
+	// Analitička optička dubina uz tablični profil zamjenjuje se tablicom optičke dubine
+	void set_density_profile(CpuDensityProfile profile) { _density_profile = profile; }
+	void set_optical_depth(CpuOpticalDepth depth) { _optical_depth = depth; }
+	CpuDensityProfile density_profile() const { return _density_profile; }
+	CpuOpticalDepth optical_depth() const { return _optical_depth; }
+
+	// Iscrtava sliku veličine renderWidth x renderHeight. Pikseli su 4 floata u obliku koji piše sjenčar (b, g, r, 0),
+	// pa se rezultat može izravno usporediti s float izlaznom slikom GPU-a
+	void render(const shader_input_buffer_1& camera, const shader_input_buffer_2& atmosphere, float* pixels);
+
+	// Jedan piksel - isti izračun kao jedna invokacija sjenčara
+	static glm::vec4 render_pixel(const shader_input_buffer_1& camera, const shader_input_buffer_2& atmosphere, int x, int y);
+
+	unsigned int thread_count() const { return (unsigned int)_queues.size(); }
+
+private:
+	struct TileQueue {
+		std::mutex mutex;
+		std::deque<uint32_t> tiles;
+	};
+
+	void worker_loop(unsigned int worker_index);
+	void run_tiles(unsigned int worker_index);
+	bool take_tile(unsigned int worker_index, uint32_t& tile);
+	void render_tile(uint32_t tile);
+	void prepare_params(const shader_input_buffer_1& camera, const shader_input_buffer_2& atmosphere);
+
+	// Puni tablice gustoće i optičke dubine kada se promijene planet, atmosfera ili profil
+	void update_tables(const Planet& planet);
+	double table_density_ratio(int species, double height) const;
+
+	static const uint32_t _tile_size = 32;
+
+	Kernel _kernel = Kernel::Generic;
+	CpuSpanKernel _span_kernel = nullptr;
+	CpuKernelParams _params = {};
+
+	CpuDensityProfile _density_profile = CpuDensityProfile::Exponential;
+	CpuOpticalDepth _optical_depth = CpuOpticalDepth::Marched;
+
+	static const uint32_t _density_table_size = 256;
+	static const uint32_t _depth_lut_heights = 64;
+	static const uint32_t _depth_lut_angles = 256;
+
+	struct TableKey {
+		CpuDensityProfile profile;
+		float planet_radius;
+		float upper_limit;
+		float average_distance[2];
+	};
+	TableKey _table_key = {};
+
+	std::vector<float> _density_tables[2];
+	std::vector<float> _depth_lut;
+
+	// Dretva koja poziva render() radi kao dretva 0, pa pozadinskih dretvi ima jednu manje
+	std::vector<std::thread> _threads;
+	std::vector<std::unique_ptr<TileQueue>> _queues;
+
+	std::mutex _mutex;
+	std::condition_variable _work_available;
+	std::condition_variable _work_done;
+	bool _running = false;
+	uint64_t _generation = 0;
+	unsigned int _busy_workers = 0;
+
+	// Trenutna slika
+	const shader_input_buffer_1* _camera = nullptr;
+	const shader_input_buffer_2* _atmosphere = nullptr;
+	float* _pixels = nullptr;
+	uint32_t _tiles_x = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "sun.h"
+#include "atmosphere.h"
+
+
+// Ulazni podaci glavnog sjenčara - iste strukture koristi i iscrtavanje na procesoru (cpuRenderer.h)
+
+// Odgovara 1. strukturi koju glavni sjenčar prima
+// Predstavlja informacije o kameri
+struct shader_input_buffer_1 {
+	glm::mat4 lookDir;
+
+	glm::vec4 initPos;
+	glm::vec4 initDir;
+
+	float xPosMultiplier;
+	float yPosMultiplier;
+
+	float xDirMultiplier;
+	float yDirMultiplier;
+
+	int sampleAmount_in;
+	int sampleAmount_out;
+
+	int mode;
+
+	// Aktivni dio izlazne slike (slika može biti veća od prozora)
+	int renderWidth;
+	int renderHeight;
+
+	// Foveacija u pikselima aktivnog dijela slike (foveaFalloff 0 - isključena). Koristi se samo u prozoru, pa ju
+	// iscrtavanje na procesoru zanemaruje
+	float focusX;
+	float focusY;
+	float foveaRadius;
+	float foveaFalloff;
+	float peripheryFactor;
+
+	// Prilagodljiv broj uzoraka po pločicama (adaptiveFlags: 1 - uključen, 2 - prikaz budžeta pločica). Također samo
+	// u prozoru
+	float adaptiveThreshold;
+	float adaptiveMinFactor;
+	int adaptiveFlags;
+
+	// Udio ukupnog broja uzoraka svih piksela (dinamička razlučivost, 1 - zadani broj)
+	float sampleFactor;
+};
+
+// Informacije o atmosferi
+struct shader_input_buffer_2 {
+	Sun sun;
+	Planet planet;
+
+	// Dodatna konstanta da se ne mora računati za svaki piksel svaki prikaz
+	alignas(8) double K;	
+};